@@ -6,13 +6,33 @@
 #include <SDL2/SDL_render.h>
 #include <SDL2/SDL_surface.h>
 #include <SDL2/SDL_video.h>
+#include <cmath>
+#include <coroutine>
 #include <cstddef>
 #include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <queue>
 #include <string>
+#include <unordered_map>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 480;
 
+// Bytes per pooled coroutine frame and frames allocated at a time
+const int FRAME_BLOCK_SIZE = 256;
+const int FRAME_CHUNK_BLOCKS = 1024;
+
+// Concurrent sequences and simulated frames in the sequence benchmark
+const int BENCHMARK_SEQUENCES = 100000;
+const int BENCHMARK_FRAMES = 600;
+
 class LTexture
 {
     public:
@@ -22,8 +42,9 @@ class LTexture
         // Deallocate
         ~LTexture();
 
-        // Load image at specified path
-        bool loadFromFile(std::string path);
+        // Load image at specified path, with color premultiplied by alpha when asked
+        // and the renderer supports the premultiplied blend mode
+        bool loadFromFile(std::string path, bool premultiply = false);
 
         // Deallocate texture
         void free();
@@ -45,30 +66,268 @@ class LTexture
         int getHeight();
 
     private:
+        // Applies color and alpha modulation, scaling color by alpha when premultiplied
+        void applyModulation();
+
         // The actual hardware texture
         SDL_Texture* mTexture;
 
+        // Whether pixels are premultiplied
+        bool mPremultiplied;
+
+        // Modulation as set by the user
+        Uint8 mRed;
+        Uint8 mGreen;
+        Uint8 mBlue;
+        Uint8 mAlpha;
+
         // Image dimensions
         int mWidth;
         int mHeight;
 };
 
+// Fixed size blocks for coroutine frames, recycled through a free list
+class LFramePool
+{
+    public:
+        // Initialize
+        LFramePool();
+
+        // Deallocate chunks
+        ~LFramePool();
+
+        // Block for a frame of size bytes, from the heap when it does not fit
+        void* allocate(size_t size);
+
+        // Returns frame to the pool
+        void release(void* frame, size_t size);
+
+        // Gets frames currently allocated from the pool
+        int getBlocksInUse();
+
+        // Gets frames that did not fit a block
+        Uint64 getFallbacks();
+
+        // Gets largest frame requested
+        size_t getLargestFrame();
+
+    private:
+        struct Block
+        {
+            Block* next;
+        };
+
+        Block* mFree;
+        std::vector<unsigned char*> mChunks;
+
+        int mBlocksInUse;
+        Uint64 mFallbacks;
+        size_t mLargestFrame;
+};
+
+class LScheduler;
+
+// Coroutine run by LScheduler, suspended by co_await waitSeconds() or tween()
+class LSequence
+{
+    public:
+        struct promise_type
+        {
+            promise_type();
+
+            LSequence get_return_object();
+            std::suspend_always initial_suspend() noexcept;
+            std::suspend_always final_suspend() noexcept;
+            void return_void();
+            void unhandled_exception();
+
+            // Frames come from gFramePool
+            static void* operator new(size_t size);
+            static void operator delete(void* frame, size_t size);
+
+            // Scheduler running the sequence
+            LScheduler* scheduler;
+
+            // Id given by the scheduler and whether it was cancelled while suspended
+            Uint32 id;
+            bool cancelled;
+        };
+
+        typedef std::coroutine_handle<promise_type> Handle;
+
+        // Takes ownership of the coroutine
+        explicit LSequence(Handle handle);
+        LSequence(LSequence&& other);
+
+        // Destroys the coroutine unless a scheduler took it
+        ~LSequence();
+
+        // Gives up ownership
+        Handle release();
+
+    private:
+        Handle mHandle;
+};
+
+// Suspends the sequence for seconds of scheduler time, at least until the next update
+struct WaitSeconds
+{
+    double seconds;
+
+    bool await_ready();
+    void await_suspend(LSequence::Handle handle);
+    void await_resume();
+};
+
+// Moves value linearly from one value to another over seconds, resuming when done
+struct Tween
+{
+    Uint8* value;
+    Uint8 from;
+    Uint8 to;
+    double seconds;
+
+    bool await_ready();
+    void await_suspend(LSequence::Handle handle);
+    void await_resume();
+};
+
+// Resumes sequences when due, suspended sequences cost nothing until then
+class LScheduler
+{
+    public:
+        // Initialize
+        LScheduler();
+
+        // Destroys remaining sequences
+        ~LScheduler();
+
+        // Runs sequence up to its first suspension, returns its id
+        Uint32 start(LSequence sequence);
+
+        // Destroys sequence the next time it would be resumed
+        void cancel(Uint32 id);
+
+        // Destroys all sequences
+        void clear();
+
+        // Advances tweens and resumes sequences due at now seconds
+        void update(double now);
+
+        // Called by awaiters
+        void sleep(LSequence::Handle handle, double seconds);
+        void tween(LSequence::Handle handle, Uint8* value, Uint8 from, Uint8 to, double seconds);
+
+        // Gets sequences not finished yet
+        int getLiveCount();
+
+        // Gets resumes since construction
+        Uint64 getResumes();
+
+    private:
+        struct Timer
+        {
+            double due;
+
+            // Breaks ties in start order
+            Uint64 order;
+
+            LSequence::Handle handle;
+
+            bool operator>(const Timer& other) const;
+        };
+
+        struct ActiveTween
+        {
+            Uint8* value;
+            Uint8 from;
+            Uint8 to;
+            double start;
+            double seconds;
+            LSequence::Handle handle;
+        };
+
+        // Resumes handle, destroying it when it finished or was cancelled
+        void resume(LSequence::Handle handle);
+
+        // Destroys handle and forgets it
+        void destroy(LSequence::Handle handle);
+
+        double mNow;
+
+        // Sleeping sequences, earliest first
+        std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer> > mTimers;
+        Uint64 mTimerOrder;
+
+        // Sequences tweening, advanced every update
+        std::vector<ActiveTween> mTweens;
+
+        // Sequences to resume this update, reused across updates
+        std::vector<LSequence::Handle> mReady;
+
+        std::unordered_map<Uint32, LSequence::Handle> mLive;
+        Uint32 mNextId;
+        Uint64 mResumes;
+};
+
 bool init();
 
 bool loadMedia();
 
 void close();
 
+// Multiplies color channels of ARGB8888 pixels by their alpha
+void premultiplyPixels(Uint32* pixels, int count);
+
+// Composites premultiplied ARGB8888 pixels over dst, scaled by premultiplied mod
+void compositePremultiplied(const Uint32* src, Uint32* dst, int count, Uint32 mod);
+
+// Composites straight alpha ARGB8888 pixels over dst like SDL_BLENDMODE_BLEND,
+// color modulated by the RGB of mod and alpha modulated by its alpha
+void compositeStraight(const Uint32* src, Uint32* dst, int count, Uint32 mod);
+
+// Compares fill rate of straight and premultiplied compositing in software
+void runFillBenchmark();
+
+// Suspends the calling sequence for seconds
+WaitSeconds waitSeconds(double seconds);
+
+// Moves value from one value to another over seconds
+Tween tween(Uint8& value, Uint8 from, Uint8 to, double seconds);
+
+// Fades alpha to target at a full fade per second
+LSequence fadeTo(Uint8& alpha, Uint8 target);
+
+// Fades alpha out and back in a few times
+LSequence blink(Uint8& alpha);
+
+// Compares 100k concurrent sequences against polled counters doing the same
+void runSequenceBenchmark();
+
 SDL_Window* gWindow = NULL;
 
 SDL_Renderer* gRenderer = NULL;
 
+// src + dst * (1 - src alpha) for color and alpha
+SDL_BlendMode gPremultipliedBlend = SDL_BLENDMODE_INVALID;
+bool gPremultipliedSupported = false;
+
 LTexture gModulatedTexture;
 LTexture gBackgroundTexture;
 
+// Declared before the scheduler so frames outlive it
+LFramePool gFramePool;
+
+LScheduler gScheduler;
+
 LTexture::LTexture()
 {
     mTexture = NULL;
+    mPremultiplied = false;
+    mRed = 0xFF;
+    mGreen = 0xFF;
+    mBlue = 0xFF;
+    mAlpha = 0xFF;
     mWidth = 0;
     mHeight = 0;
 }
@@ -78,6 +337,11 @@ void LTexture::free()
     if (mTexture != NULL) {
         SDL_DestroyTexture(mTexture);
         mTexture = NULL;
+        mPremultiplied = false;
+        mRed = 0xFF;
+        mGreen = 0xFF;
+        mBlue = 0xFF;
+        mAlpha = 0xFF;
         mWidth = 0;
         mHeight = 0;
     }
@@ -88,20 +352,44 @@ LTexture::~LTexture()
     free();
 }
 
-bool LTexture::loadFromFile(std::string path)
+bool LTexture::loadFromFile(std::string path, bool premultiply)
 {
+    // Get rid of preexisting texture
+    free();
+
     SDL_Texture* newTexture = NULL;
 
     SDL_Surface* loadedSurface = IMG_Load(path.c_str());
     if (loadedSurface == NULL) {
         printf("Failed to load image %s! SDL_Image Error: %s\n", path.c_str(), IMG_GetError());
     } else {
+        // Premultiply once here instead of per pixel on every blend
+        if (premultiply && gPremultipliedSupported) {
+            SDL_Surface* converted = SDL_ConvertSurfaceFormat(loadedSurface, SDL_PIXELFORMAT_ARGB8888, 0);
+            if (converted == NULL) {
+                printf("Failed to convert %s for premultiplying! SDL Error: %s\n", path.c_str(), SDL_GetError());
+            } else {
+                for (int y = 0; y < converted->h; ++y) {
+                    premultiplyPixels((Uint32*)((Uint8*)converted->pixels + y * converted->pitch), converted->w);
+                }
+
+                SDL_FreeSurface(loadedSurface);
+                loadedSurface = converted;
+                mPremultiplied = true;
+            }
+        }
+
         newTexture = SDL_CreateTextureFromSurface(gRenderer, loadedSurface);
         if (newTexture == NULL) {
             printf("Failed to create texture from %s! SDL_Error: %s\n", path.c_str(), SDL_GetError());
+            mPremultiplied = false;
         } else {
             mWidth = loadedSurface->w;
             mHeight = loadedSurface->h;
+
+            if (mPremultiplied) {
+                SDL_SetTextureBlendMode(newTexture, gPremultipliedBlend);
+            }
         }
 
         SDL_FreeSurface(loadedSurface);
@@ -113,17 +401,38 @@ bool LTexture::loadFromFile(std::string path)
 
 void LTexture::setColor(Uint8 red, Uint8 green, Uint8 blue)
 {
-    SDL_SetTextureColorMod(mTexture, red, green, blue);
+    mRed = red;
+    mGreen = green;
+    mBlue = blue;
+    applyModulation();
 }
 
 void LTexture::setBlendMode(SDL_BlendMode blending)
 {
+    // Premultiplied pixels blend with the matching custom mode
+    if (mPremultiplied && blending == SDL_BLENDMODE_BLEND) {
+        blending = gPremultipliedBlend;
+    }
+
     SDL_SetTextureBlendMode(mTexture, blending);
 }
 
 void LTexture::setAlpha(Uint8 alpha)
 {
-    SDL_SetTextureAlphaMod(mTexture, alpha);
+    mAlpha = alpha;
+    applyModulation();
+}
+
+void LTexture::applyModulation()
+{
+    // Premultiplied color has to fade along with alpha
+    if (mPremultiplied) {
+        SDL_SetTextureColorMod(mTexture, mRed * mAlpha / 255, mGreen * mAlpha / 255, mBlue * mAlpha / 255);
+    } else {
+        SDL_SetTextureColorMod(mTexture, mRed, mGreen, mBlue);
+    }
+
+    SDL_SetTextureAlphaMod(mTexture, mAlpha);
 }
 
 void LTexture::render(int x, int y, SDL_Rect* clip)
@@ -142,6 +451,722 @@ int LTexture::getHeight()
     return mHeight;
 }
 
+// x / 255 rounded per 16 bit lane, exact for x up to 255 * 255
+#if defined(__AVX2__)
+static inline __m256i div255(__m256i x)
+{
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+// Alpha of each pixel in all four of its lanes
+static inline __m256i broadcastAlpha(__m256i x)
+{
+    return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(x, 0xFF), 0xFF);
+}
+#elif defined(__SSE2__)
+static inline __m128i div255(__m128i x)
+{
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+static inline __m128i broadcastAlpha(__m128i x)
+{
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xFF), 0xFF);
+}
+#endif
+
+static inline Uint32 div255(Uint32 x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+void premultiplyPixels(Uint32* pixels, int count)
+{
+    int i = 0;
+
+    // Widen to 16 bit lanes, multiply color by alpha and alpha by 255
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alphaLane = _mm256_set1_epi64x(0xFFFF000000000000LL);
+    const __m256i opaque = _mm256_set1_epi16(255);
+    for (; i + 8 <= count; i += 8) {
+        __m256i p = _mm256_loadu_si256((const __m256i*)(pixels + i));
+        __m256i lo = _mm256_unpacklo_epi8(p, zero);
+        __m256i hi = _mm256_unpackhi_epi8(p, zero);
+
+        __m256i loFactor = _mm256_or_si256(_mm256_andnot_si256(alphaLane, broadcastAlpha(lo)), _mm256_and_si256(alphaLane, opaque));
+        __m256i hiFactor = _mm256_or_si256(_mm256_andnot_si256(alphaLane, broadcastAlpha(hi)), _mm256_and_si256(alphaLane, opaque));
+
+        lo = div255(_mm256_mullo_epi16(lo, loFactor));
+        hi = div255(_mm256_mullo_epi16(hi, hiFactor));
+        _mm256_storeu_si256((__m256i*)(pixels + i), _mm256_packus_epi16(lo, hi));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaLane = _mm_set_epi32((int)0xFFFF0000, 0, (int)0xFFFF0000, 0);
+    const __m128i opaque = _mm_set1_epi16(255);
+    for (; i + 4 <= count; i += 4) {
+        __m128i p = _mm_loadu_si128((const __m128i*)(pixels + i));
+        __m128i lo = _mm_unpacklo_epi8(p, zero);
+        __m128i hi = _mm_unpackhi_epi8(p, zero);
+
+        __m128i loFactor = _mm_or_si128(_mm_andnot_si128(alphaLane, broadcastAlpha(lo)), _mm_and_si128(alphaLane, opaque));
+        __m128i hiFactor = _mm_or_si128(_mm_andnot_si128(alphaLane, broadcastAlpha(hi)), _mm_and_si128(alphaLane, opaque));
+
+        lo = div255(_mm_mullo_epi16(lo, loFactor));
+        hi = div255(_mm_mullo_epi16(hi, hiFactor));
+        _mm_storeu_si128((__m128i*)(pixels + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        Uint32 p = pixels[i];
+        Uint32 a = p >> 24;
+        pixels[i] = (a << 24) | (div255(((p >> 16) & 0xFF) * a) << 16) | (div255(((p >> 8) & 0xFF) * a) << 8) | div255((p & 0xFF) * a);
+    }
+}
+
+void compositePremultiplied(const Uint32* src, Uint32* dst, int count, Uint32 mod)
+{
+    int i = 0;
+
+    // s * mod + d * (255 - s alpha) / 255, one multiply less than straight alpha
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i opaque = _mm256_set1_epi16(255);
+    const __m256i modulation = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)mod), zero);
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+
+        __m256i sLo = div255(_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), modulation));
+        __m256i sHi = div255(_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), modulation));
+
+        __m256i dLo = div255(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_sub_epi16(opaque, broadcastAlpha(sLo))));
+        __m256i dHi = div255(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_sub_epi16(opaque, broadcastAlpha(sHi))));
+
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(_mm256_add_epi16(sLo, dLo), _mm256_add_epi16(sHi, dHi)));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i opaque = _mm_set1_epi16(255);
+    const __m128i modulation = _mm_unpacklo_epi8(_mm_set1_epi32((int)mod), zero);
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+
+        __m128i sLo = div255(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), modulation));
+        __m128i sHi = div255(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), modulation));
+
+        __m128i dLo = div255(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(opaque, broadcastAlpha(sLo))));
+        __m128i dHi = div255(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(opaque, broadcastAlpha(sHi))));
+
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(_mm_add_epi16(sLo, dLo), _mm_add_epi16(sHi, dHi)));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        Uint32 s = src[i];
+        Uint32 d = dst[i];
+        Uint32 a = div255((s >> 24) * (mod >> 24));
+
+        Uint32 result = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            Uint32 channel = div255(((s >> shift) & 0xFF) * ((mod >> shift) & 0xFF)) + div255(((d >> shift) & 0xFF) * (255 - a));
+            result |= SDL_min(channel, 255u) << shift;
+        }
+        dst[i] = result;
+    }
+}
+
+void compositeStraight(const Uint32* src, Uint32* dst, int count, Uint32 mod)
+{
+    int i = 0;
+
+    // Color is weighted by alpha on every blend, alpha itself by 255
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i opaque = _mm256_set1_epi16(255);
+    const __m256i alphaLane = _mm256_set1_epi64x(0xFFFF000000000000LL);
+    const __m256i modulation = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)mod), zero);
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+
+        __m256i sLo = div255(_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), modulation));
+        __m256i sHi = div255(_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), modulation));
+        __m256i aLo = broadcastAlpha(sLo);
+        __m256i aHi = broadcastAlpha(sHi);
+
+        __m256i fLo = _mm256_or_si256(_mm256_andnot_si256(alphaLane, aLo), _mm256_and_si256(alphaLane, opaque));
+        __m256i fHi = _mm256_or_si256(_mm256_andnot_si256(alphaLane, aHi), _mm256_and_si256(alphaLane, opaque));
+
+        __m256i lo = div255(_mm256_add_epi16(_mm256_mullo_epi16(sLo, fLo), _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_sub_epi16(opaque, aLo))));
+        __m256i hi = div255(_mm256_add_epi16(_mm256_mullo_epi16(sHi, fHi), _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_sub_epi16(opaque, aHi))));
+
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i opaque = _mm_set1_epi16(255);
+    const __m128i alphaLane = _mm_set_epi32((int)0xFFFF0000, 0, (int)0xFFFF0000, 0);
+    const __m128i modulation = _mm_unpacklo_epi8(_mm_set1_epi32((int)mod), zero);
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+
+        __m128i sLo = div255(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), modulation));
+        __m128i sHi = div255(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), modulation));
+        __m128i aLo = broadcastAlpha(sLo);
+        __m128i aHi = broadcastAlpha(sHi);
+
+        __m128i fLo = _mm_or_si128(_mm_andnot_si128(alphaLane, aLo), _mm_and_si128(alphaLane, opaque));
+        __m128i fHi = _mm_or_si128(_mm_andnot_si128(alphaLane, aHi), _mm_and_si128(alphaLane, opaque));
+
+        __m128i lo = div255(_mm_add_epi16(_mm_mullo_epi16(sLo, fLo), _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(opaque, aLo))));
+        __m128i hi = div255(_mm_add_epi16(_mm_mullo_epi16(sHi, fHi), _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(opaque, aHi))));
+
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        Uint32 s = src[i];
+        Uint32 d = dst[i];
+        Uint32 a = div255((s >> 24) * (mod >> 24));
+
+        Uint32 result = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            Uint32 channel = div255(((s >> shift) & 0xFF) * ((mod >> shift) & 0xFF));
+            Uint32 factor = shift == 24 ? 255 : a;
+            result |= div255(channel * factor + ((d >> shift) & 0xFF) * (255 - a)) << shift;
+        }
+        dst[i] = result;
+    }
+}
+
+void runFillBenchmark()
+{
+    const int runs = 200;
+
+    SDL_Surface* loadedSurface = IMG_Load("fadeout.png");
+    if (loadedSurface == NULL) {
+        printf("Failed to load image fadeout.png! SDL_Image Error: %s\n", IMG_GetError());
+        return;
+    }
+
+    SDL_Surface* straight = SDL_ConvertSurfaceFormat(loadedSurface, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_Surface* premultiplied = SDL_ConvertSurfaceFormat(loadedSurface, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(loadedSurface);
+
+    SDL_Surface* target = NULL;
+    if (straight != NULL) {
+        target = SDL_CreateRGBSurfaceWithFormat(0, straight->w, straight->h, 32, SDL_PIXELFORMAT_ARGB8888);
+    }
+
+    if (straight == NULL || premultiplied == NULL || target == NULL) {
+        printf("Failed to create benchmark surfaces! SDL Error: %s\n", SDL_GetError());
+    } else {
+        int width = straight->w;
+        int height = straight->h;
+        double frequency = (double)SDL_GetPerformanceFrequency();
+        double megapixels = (double)width * height * runs / 1000000.0;
+
+        // Half transparent white, premultiplied it is half gray
+        Uint8 alpha = 0x80;
+        Uint32 straightMod = (Uint32)alpha << 24 | 0xFFFFFF;
+        Uint32 premultipliedMod = (Uint32)alpha << 24 | (Uint32)alpha << 16 | (Uint32)alpha << 8 | alpha;
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int y = 0; y < height; ++y) {
+            premultiplyPixels((Uint32*)((Uint8*)premultiplied->pixels + y * premultiplied->pitch), width);
+        }
+        double premultiplyMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+
+        // SDL's own blitter, which the software renderer uses for SDL_BLENDMODE_BLEND
+        SDL_SetSurfaceBlendMode(straight, SDL_BLENDMODE_BLEND);
+        SDL_SetSurfaceAlphaMod(straight, alpha);
+        SDL_FillRect(target, NULL, 0xFF808080);
+        start = SDL_GetPerformanceCounter();
+        for (int i = 0; i < runs; ++i) {
+            SDL_BlitSurface(straight, NULL, target, NULL);
+        }
+        double sdlSeconds = (SDL_GetPerformanceCounter() - start) / frequency;
+
+        SDL_FillRect(target, NULL, 0xFF808080);
+        start = SDL_GetPerformanceCounter();
+        for (int i = 0; i < runs; ++i) {
+            for (int y = 0; y < height; ++y) {
+                compositeStraight((const Uint32*)((const Uint8*)straight->pixels + y * straight->pitch), (Uint32*)((Uint8*)target->pixels + y * target->pitch), width, straightMod);
+            }
+        }
+        double straightSeconds = (SDL_GetPerformanceCounter() - start) / frequency;
+
+        SDL_FillRect(target, NULL, 0xFF808080);
+        start = SDL_GetPerformanceCounter();
+        for (int i = 0; i < runs; ++i) {
+            for (int y = 0; y < height; ++y) {
+                compositePremultiplied((const Uint32*)((const Uint8*)premultiplied->pixels + y * premultiplied->pitch), (Uint32*)((Uint8*)target->pixels + y * target->pitch), width, premultipliedMod);
+            }
+        }
+        double premultipliedSeconds = (SDL_GetPerformanceCounter() - start) / frequency;
+
+        printf("Premultiplied %dx%d at load in %.3f ms\n", width, height, premultiplyMs);
+        printf("SDL_BlitSurface blend:  %8.1f Mpixels/s\n", megapixels / sdlSeconds);
+        printf("Straight compositor:    %8.1f Mpixels/s\n", megapixels / straightSeconds);
+        printf("Premultiplied compositor: %6.1f Mpixels/s (%.2fx straight, %.2fx SDL)\n",
+            megapixels / premultipliedSeconds, straightSeconds / premultipliedSeconds, sdlSeconds / premultipliedSeconds);
+    }
+
+    SDL_FreeSurface(straight);
+    SDL_FreeSurface(premultiplied);
+    SDL_FreeSurface(target);
+}
+
+LFramePool::LFramePool()
+{
+    mFree = NULL;
+    mBlocksInUse = 0;
+    mFallbacks = 0;
+    mLargestFrame = 0;
+}
+
+LFramePool::~LFramePool()
+{
+    for (size_t i = 0; i < mChunks.size(); ++i) {
+        delete[] mChunks[i];
+    }
+}
+
+void* LFramePool::allocate(size_t size)
+{
+    mLargestFrame = SDL_max(mLargestFrame, size);
+
+    if (size > (size_t)FRAME_BLOCK_SIZE) {
+        ++mFallbacks;
+        return ::operator new(size);
+    }
+
+    // Carve a new chunk into blocks once the free list runs dry
+    if (mFree == NULL) {
+        unsigned char* chunk = new unsigned char[FRAME_BLOCK_SIZE * FRAME_CHUNK_BLOCKS];
+        mChunks.push_back(chunk);
+
+        for (int i = FRAME_CHUNK_BLOCKS - 1; i >= 0; --i) {
+            Block* block = (Block*)(chunk + i * FRAME_BLOCK_SIZE);
+            block->next = mFree;
+            mFree = block;
+        }
+    }
+
+    Block* block = mFree;
+    mFree = block->next;
+    ++mBlocksInUse;
+
+    return block;
+}
+
+void LFramePool::release(void* frame, size_t size)
+{
+    if (size > (size_t)FRAME_BLOCK_SIZE) {
+        ::operator delete(frame);
+        return;
+    }
+
+    Block* block = (Block*)frame;
+    block->next = mFree;
+    mFree = block;
+    --mBlocksInUse;
+}
+
+int LFramePool::getBlocksInUse()
+{
+    return mBlocksInUse;
+}
+
+Uint64 LFramePool::getFallbacks()
+{
+    return mFallbacks;
+}
+
+size_t LFramePool::getLargestFrame()
+{
+    return mLargestFrame;
+}
+
+LSequence::promise_type::promise_type()
+{
+    scheduler = NULL;
+    id = 0;
+    cancelled = false;
+}
+
+LSequence LSequence::promise_type::get_return_object()
+{
+    return LSequence(Handle::from_promise(*this));
+}
+
+std::suspend_always LSequence::promise_type::initial_suspend() noexcept
+{
+    // Nothing runs until the scheduler starts it
+    return std::suspend_always();
+}
+
+std::suspend_always LSequence::promise_type::final_suspend() noexcept
+{
+    // The scheduler destroys finished frames
+    return std::suspend_always();
+}
+
+void LSequence::promise_type::return_void()
+{
+}
+
+void LSequence::promise_type::unhandled_exception()
+{
+    abort();
+}
+
+void* LSequence::promise_type::operator new(size_t size)
+{
+    return gFramePool.allocate(size);
+}
+
+void LSequence::promise_type::operator delete(void* frame, size_t size)
+{
+    gFramePool.release(frame, size);
+}
+
+LSequence::LSequence(Handle handle)
+{
+    mHandle = handle;
+}
+
+LSequence::LSequence(LSequence&& other)
+{
+    mHandle = other.mHandle;
+    other.mHandle = Handle();
+}
+
+LSequence::~LSequence()
+{
+    if (mHandle) {
+        mHandle.destroy();
+    }
+}
+
+LSequence::Handle LSequence::release()
+{
+    Handle handle = mHandle;
+    mHandle = Handle();
+    return handle;
+}
+
+bool WaitSeconds::await_ready()
+{
+    // Even a zero wait yields until the next update
+    return false;
+}
+
+void WaitSeconds::await_suspend(LSequence::Handle handle)
+{
+    handle.promise().scheduler->sleep(handle, seconds);
+}
+
+void WaitSeconds::await_resume()
+{
+}
+
+bool Tween::await_ready()
+{
+    if (seconds <= 0) {
+        *value = to;
+        return true;
+    }
+
+    return false;
+}
+
+void Tween::await_suspend(LSequence::Handle handle)
+{
+    handle.promise().scheduler->tween(handle, value, from, to, seconds);
+}
+
+void Tween::await_resume()
+{
+}
+
+WaitSeconds waitSeconds(double seconds)
+{
+    WaitSeconds awaiter = {seconds};
+    return awaiter;
+}
+
+Tween tween(Uint8& value, Uint8 from, Uint8 to, double seconds)
+{
+    Tween awaiter = {&value, from, to, seconds};
+    return awaiter;
+}
+
+bool LScheduler::Timer::operator>(const Timer& other) const
+{
+    if (due != other.due) {
+        return due > other.due;
+    }
+
+    return order > other.order;
+}
+
+LScheduler::LScheduler()
+{
+    mNow = 0;
+    mTimerOrder = 0;
+    mNextId = 1;
+    mResumes = 0;
+}
+
+LScheduler::~LScheduler()
+{
+    clear();
+}
+
+Uint32 LScheduler::start(LSequence sequence)
+{
+    LSequence::Handle handle = sequence.release();
+
+    Uint32 id = mNextId++;
+    handle.promise().scheduler = this;
+    handle.promise().id = id;
+    mLive[id] = handle;
+
+    resume(handle);
+
+    return id;
+}
+
+void LScheduler::cancel(Uint32 id)
+{
+    // Its timer or tween still refers to the frame, so it goes when that comes up
+    std::unordered_map<Uint32, LSequence::Handle>::iterator live = mLive.find(id);
+    if (live != mLive.end()) {
+        live->second.promise().cancelled = true;
+    }
+}
+
+void LScheduler::clear()
+{
+    for (std::unordered_map<Uint32, LSequence::Handle>::iterator live = mLive.begin(); live != mLive.end(); ++live) {
+        live->second.destroy();
+    }
+    mLive.clear();
+
+    mTimers = std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer> >();
+    mTweens.clear();
+    mReady.clear();
+}
+
+void LScheduler::update(double now)
+{
+    mNow = now;
+    mReady.clear();
+
+    for (size_t i = 0; i < mTweens.size();) {
+        ActiveTween& active = mTweens[i];
+
+        bool done = active.handle.promise().cancelled;
+        if (!done) {
+            double progress = (now - active.start) / active.seconds;
+            if (progress >= 1) {
+                *active.value = active.to;
+                done = true;
+            } else {
+                *active.value = (Uint8)(active.from + lround((active.to - active.from) * progress));
+            }
+        }
+
+        if (done) {
+            mReady.push_back(active.handle);
+            active = mTweens.back();
+            mTweens.pop_back();
+        } else {
+            ++i;
+        }
+    }
+
+    // Only due timers are touched, everything sleeping past now is never looked at
+    while (!mTimers.empty() && mTimers.top().due <= now) {
+        mReady.push_back(mTimers.top().handle);
+        mTimers.pop();
+    }
+
+    for (size_t i = 0; i < mReady.size(); ++i) {
+        resume(mReady[i]);
+    }
+}
+
+void LScheduler::sleep(LSequence::Handle handle, double seconds)
+{
+    Timer timer = {mNow + seconds, mTimerOrder++, handle};
+    mTimers.push(timer);
+}
+
+void LScheduler::tween(LSequence::Handle handle, Uint8* value, Uint8 from, Uint8 to, double seconds)
+{
+    *value = from;
+
+    ActiveTween active = {value, from, to, mNow, seconds, handle};
+    mTweens.push_back(active);
+}
+
+int LScheduler::getLiveCount()
+{
+    return (int)mLive.size();
+}
+
+Uint64 LScheduler::getResumes()
+{
+    return mResumes;
+}
+
+void LScheduler::resume(LSequence::Handle handle)
+{
+    if (handle.promise().cancelled) {
+        destroy(handle);
+        return;
+    }
+
+    ++mResumes;
+    handle.resume();
+
+    if (handle.done()) {
+        destroy(handle);
+    }
+}
+
+void LScheduler::destroy(LSequence::Handle handle)
+{
+    mLive.erase(handle.promise().id);
+    handle.destroy();
+}
+
+LSequence fadeTo(Uint8& alpha, Uint8 target)
+{
+    co_await tween(alpha, alpha, target, abs(target - alpha) / 255.0);
+}
+
+LSequence blink(Uint8& alpha)
+{
+    for (int i = 0; i < 3; ++i) {
+        co_await tween(alpha, alpha, 0, 0.2);
+        co_await waitSeconds(0.1);
+        co_await tween(alpha, 0, 255, 0.2);
+        co_await waitSeconds(0.3);
+    }
+}
+
+// Waits, fades in, repeats, as a coroutine and as a hand-rolled state machine
+static LSequence benchmarkSequence(Uint8& value, double delay, int* completed)
+{
+    for (int i = 0; i < 4; ++i) {
+        co_await waitSeconds(delay);
+        co_await tween(value, 0, 255, 0.25);
+    }
+
+    ++*completed;
+}
+
+struct PolledSequence
+{
+    Uint8 value;
+    double delay;
+
+    // Even steps wait, odd steps fade, 8 when finished
+    int step;
+    double stepStart;
+};
+
+void runSequenceBenchmark()
+{
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    double frameSeconds = 1.0 / 60.0;
+
+    std::vector<double> delays(BENCHMARK_SEQUENCES);
+    for (int i = 0; i < BENCHMARK_SEQUENCES; ++i) {
+        delays[i] = 0.5 + (rand() % 2000) / 1000.0;
+    }
+
+    // Coroutines, only due ones are resumed
+    std::vector<Uint8> values(BENCHMARK_SEQUENCES, (Uint8)0);
+    int completed = 0;
+    LScheduler scheduler;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < BENCHMARK_SEQUENCES; ++i) {
+        scheduler.start(benchmarkSequence(values[i], delays[i], &completed));
+    }
+    double startMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+    int peakBlocks = gFramePool.getBlocksInUse();
+
+    start = SDL_GetPerformanceCounter();
+    for (int frame = 1; frame <= BENCHMARK_FRAMES; ++frame) {
+        scheduler.update(frame * frameSeconds);
+    }
+    double coroutineMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+
+    // Counters checked every frame
+    std::vector<PolledSequence> polled(BENCHMARK_SEQUENCES);
+    for (int i = 0; i < BENCHMARK_SEQUENCES; ++i) {
+        polled[i].value = 0;
+        polled[i].delay = delays[i];
+        polled[i].step = 0;
+        polled[i].stepStart = 0;
+    }
+    int polledCompleted = 0;
+
+    start = SDL_GetPerformanceCounter();
+    for (int frame = 1; frame <= BENCHMARK_FRAMES; ++frame) {
+        double now = frame * frameSeconds;
+        for (int i = 0; i < BENCHMARK_SEQUENCES; ++i) {
+            PolledSequence& sequence = polled[i];
+            if (sequence.step == 8) {
+                continue;
+            }
+
+            if (sequence.step % 2 == 0) {
+                if (now - sequence.stepStart >= sequence.delay) {
+                    sequence.value = 0;
+                    sequence.step++;
+                    sequence.stepStart = now;
+                }
+            } else {
+                double progress = (now - sequence.stepStart) / 0.25;
+                if (progress >= 1) {
+                    sequence.value = 255;
+                    sequence.step++;
+                    sequence.stepStart = now;
+                    if (sequence.step == 8) {
+                        ++polledCompleted;
+                    }
+                } else {
+                    sequence.value = (Uint8)lround(255 * progress);
+                }
+            }
+        }
+    }
+    double polledMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+
+    printf("%d sequences over %d frames\n", BENCHMARK_SEQUENCES, BENCHMARK_FRAMES);
+    printf("Coroutines: started in %.2f ms, %.3f ms/frame, %llu resumes, %d finished, %d still live\n",
+        startMs, coroutineMs / BENCHMARK_FRAMES, (unsigned long long)scheduler.getResumes(), completed, scheduler.getLiveCount());
+    printf("Polling:    %.3f ms/frame, %d finished (coroutines %.2fx faster)\n",
+        polledMs / BENCHMARK_FRAMES, polledCompleted, polledMs / coroutineMs);
+    printf("Frame pool: %d blocks of %d bytes at peak, largest frame %d bytes, %llu heap fallbacks\n",
+        peakBlocks, FRAME_BLOCK_SIZE, (int)gFramePool.getLargestFrame(), (unsigned long long)gFramePool.getFallbacks());
+}
+
 bool init()
 {
     bool success = true;
@@ -165,6 +1190,17 @@ bool init()
                     printf("SDL_Image could not initialize! SDL_Image Error: %s \n", IMG_GetError());
                     success = false;
                 }
+
+                // Renderers without custom blend modes keep straight alpha
+                gPremultipliedBlend = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+                    SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+
+                SDL_Texture* probe = SDL_CreateTexture(gRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, 1, 1);
+                gPremultipliedSupported = probe != NULL && SDL_SetTextureBlendMode(probe, gPremultipliedBlend) == 0;
+                if (!gPremultipliedSupported) {
+                    printf("Renderer has no premultiplied blend mode, using straight alpha\n");
+                }
+                SDL_DestroyTexture(probe);
             }
         }
     }
@@ -175,7 +1211,7 @@ bool init()
 bool loadMedia()
 {
     bool success = true;
-    if (!gModulatedTexture.loadFromFile("fadeout.png")) {
+    if (!gModulatedTexture.loadFromFile("fadeout.png", true)) {
         printf("Failed to load front texture!\n");
         success = false;
     } else {
@@ -192,6 +1228,8 @@ bool loadMedia()
 
 void close()
 {
+    gScheduler.clear();
+
     gModulatedTexture.free();
     gBackgroundTexture.free();
 
@@ -205,6 +1243,18 @@ void close()
 }
 
 int main (int argc, char *argv[]) {
+    // --bench-fill times software compositing without opening a window
+    if (argc > 1 && std::string(argv[1]) == "--bench-fill") {
+        runFillBenchmark();
+        return 0;
+    }
+
+    // --bench-sequences compares coroutine sequences with polled counters
+    if (argc > 1 && std::string(argv[1]) == "--bench-sequences") {
+        runSequenceBenchmark();
+        return 0;
+    }
+
     if (!init()) {
         printf("Failed to initialize!\n");
     } else {
@@ -217,26 +1267,30 @@ int main (int argc, char *argv[]) {
 
             Uint8 a = 255;
 
+            // Sequence driving a, replaced whenever a new one starts
+            Uint32 fade = 0;
+
+            double frequency = (double)SDL_GetPerformanceFrequency();
+
             while (!quit) {
                 while (SDL_PollEvent(&e) != 0) {
                     if (e.type == SDL_QUIT) {
                         quit = true;
-                    } else if (e.type == SDL_KEYDOWN) {
+                    } else if (e.type == SDL_KEYDOWN && e.key.repeat == 0) {
                         if (e.key.keysym.sym == SDLK_w) {
-                            if (a + 32 > 255) {
-                                a = 255;
-                            } else {
-                                a += 32;
-                            }
+                            gScheduler.cancel(fade);
+                            fade = gScheduler.start(fadeTo(a, 255));
                         } else if (e.key.keysym.sym == SDLK_s) {
-                            if (a - 32 < 0) {
-                                a = 0;
-                            } else {
-                                a -= 32;
-                            }
+                            gScheduler.cancel(fade);
+                            fade = gScheduler.start(fadeTo(a, 0));
+                        } else if (e.key.keysym.sym == SDLK_SPACE) {
+                            gScheduler.cancel(fade);
+                            fade = gScheduler.start(blink(a));
                         }
                     }
                 }
+
+                gScheduler.update(SDL_GetPerformanceCounter() / frequency);
                 // Clear screen
                 SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
                 SDL_RenderClear(gRenderer);
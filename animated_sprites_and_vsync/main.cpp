@@ -3,15 +3,93 @@
 #include <SDL2/SDL_error.h>
 #include <SDL2/SDL_events.h>
 #include <SDL2/SDL_image.h>
+#include <SDL2/SDL_keycode.h>
 #include <SDL2/SDL_render.h>
+#include <SDL2/SDL_rwops.h>
 #include <SDL2/SDL_surface.h>
 #include <SDL2/SDL_video.h>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 480;
-const int WALKING_ANIMATION_FRAMES = 4;
+
+// Simulation steps per second
+const int SIMULATION_RATE = 120;
+
+// Walking speed in pixels per second, frame timing comes from the sprite sheet
+const double WALK_SPEED = 200;
+
+// Seconds each mode runs in the benchmark and milliseconds between generated key presses
+const int BENCHMARK_SECONDS = 5;
+const int BENCHMARK_INPUT_INTERVAL = 200;
+
+// What the renderer draws, never changed once published
+struct SceneSnapshot
+{
+    Uint64 tick;
+    int animationFrame;
+    int x;
+
+    // Newest input the simulation applied and when it was sent
+    Uint32 inputSequence;
+    Uint32 inputTimestamp;
+};
+
+// Simulation state, owned by whichever thread simulates
+struct Simulation
+{
+    Uint64 tick;
+    double time;
+    double x;
+    int direction;
+    Uint32 inputSequence;
+    Uint32 inputTimestamp;
+};
+
+// Latest snapshot handed from one writer to one reader without locks, the
+// writer never waits and the reader always gets the newest complete one
+class LSnapshotBuffer
+{
+    public:
+        // Initialize
+        LSnapshotBuffer();
+
+        // Writer side, publishes snapshot replacing an unread one
+        void publish(const SceneSnapshot& snapshot);
+
+        // Reader side, switches to the newest snapshot, false when nothing new was published
+        bool consume();
+
+        // Reader side, snapshot switched to last
+        const SceneSnapshot& getFront();
+
+    private:
+        // Set on the shared slot index when it holds an unread snapshot
+        static const int FRESH = 4;
+
+        SceneSnapshot mSlots[3];
+
+        // Slot between writer and reader
+        std::atomic<int> mShared;
+
+        // Slots owned by writer and reader
+        int mBack;
+        int mFront;
+};
 
 class LTexture
 {
@@ -53,19 +131,185 @@ class LTexture
         int mHeight;
 };
 
+// Parsed JSON document, only as much as sprite sheet exports need
+struct LJsonValue
+{
+    enum Type
+    {
+        JSON_NULL,
+        JSON_BOOL,
+        JSON_NUMBER,
+        JSON_STRING,
+        JSON_ARRAY,
+        JSON_OBJECT
+    };
+
+    Type type;
+    bool boolean;
+    double number;
+    std::string string;
+
+    // Array elements, or object values in the order of keys
+    std::vector<LJsonValue> items;
+    std::vector<std::string> keys;
+
+    LJsonValue();
+
+    // Member of an object, NULL when missing
+    const LJsonValue* get(const char* key) const;
+
+    // Number or bool member of an object, fallback when missing
+    double getNumber(const char* key, double fallback) const;
+};
+
+// Frame of a sprite sheet, stored as is in the binary sidecar
+struct LSpriteFrame
+{
+    // Rectangle in the sheet texture, rotated clips are kept as exported
+    SDL_Rect clip;
+    Sint32 rotated;
+
+    // Where the trimmed clip sits in the untrimmed frame, and that frame's size
+    Sint32 offsetX;
+    Sint32 offsetY;
+    Sint32 sourceWidth;
+    Sint32 sourceHeight;
+
+    // Pivot relative to the untrimmed frame, 0 to 1
+    float pivotX;
+    float pivotY;
+
+    // Milliseconds shown when animated
+    Sint32 duration;
+
+    // Start of the name in the name table
+    Uint32 nameOffset;
+};
+
+// Sidecar layout: this header, the frames, then the NUL terminated names
+struct LSpriteSheetHeader
+{
+    char magic[4];
+    Uint32 version;
+    Uint32 frameSize;
+    Uint32 frameCount;
+    Uint32 namesSize;
+    Uint32 padding;
+
+    // JSON the sidecar was built from, a mismatch means rebuild
+    Sint64 jsonSize;
+    Sint64 jsonModified;
+};
+
+// Frames of an Aseprite or TexturePacker JSON export, array or hash layout
+class LSpriteSheet
+{
+    public:
+        // Initialize
+        LSpriteSheet();
+
+        // Deallocate
+        ~LSpriteSheet();
+
+        // Loads the export at path from its binary sidecar when that is current,
+        // otherwise parses the JSON and writes the sidecar for next time
+        bool loadFromFile(std::string path);
+
+        // Deallocate frames
+        void free();
+
+        int getFrameCount();
+
+        // Frame by index in export order
+        const LSpriteFrame& getFrame(int index);
+        SDL_Rect* getClip(int index);
+        const char* getName(int index);
+
+        // Index of the named frame, -1 when missing
+        int findFrame(std::string name);
+
+        // Index of the frame showing at milliseconds into the looped animation
+        int getFrameAt(double milliseconds);
+
+        // Whether the last load came from the sidecar
+        bool isFromSidecar();
+
+    private:
+        // Fills mParsedFrames and mParsedNames from JSON
+        bool parseExport(std::string path);
+
+        // Maps sidecar if it was built from a JSON of this size and time, reads it where mmap is unavailable
+        bool loadSidecar(std::string path, Sint64 jsonSize, Sint64 jsonModified);
+
+        // Releases what loadSidecar mapped or read
+        static void unloadSidecar(void* mapping, size_t size);
+
+        // Writes parsed frames next to the JSON
+        void writeSidecar(std::string path, Sint64 jsonSize, Sint64 jsonModified);
+
+        // Frames and names, pointing into the mapped sidecar or the parsed copies
+        LSpriteFrame* mFrames;
+        const char* mNames;
+        int mFrameCount;
+        double mTotalDuration;
+
+        std::vector<LSpriteFrame> mParsedFrames;
+        std::string mParsedNames;
+
+        // Sidecar mapping or copy, NULL when parsed
+        void* mMapping;
+        size_t mMappingSize;
+};
+
 bool init();
 
 bool loadMedia();
 
 void close();
 
+// Parses JSON text into root, false on malformed input
+bool parseJson(const char* text, LJsonValue* root);
+
+// Applies key events to the shared input state
+void handleEvent(SDL_Event* e);
+
+// Reads the shared input state into the simulation
+void applyInput(Simulation* simulation);
+
+// Advances simulation by dt seconds
+void stepSimulation(Simulation* simulation, double dt);
+
+// Copies what the renderer needs
+SceneSnapshot takeSnapshot(const Simulation& simulation);
+
+// Draws snapshot
+void renderSnapshot(const SceneSnapshot& snapshot);
+
+// Simulation thread body, publishes a snapshot every step until stopped
+void runSimulation(LSnapshotBuffer* buffer);
+
+// Runs input, simulation and rendering, on one thread or with simulation on
+// its own, for duration milliseconds or until quit when it is 0
+bool runMainLoop(bool threaded, Uint32 duration);
+
+// Pushes alternating arrow key presses until stopped
+void generateInput();
+
 SDL_Window* gWindow = NULL;
 
 SDL_Renderer* gRenderer = NULL;
 
-SDL_Rect gSpriteClips[WALKING_ANIMATION_FRAMES];
+LSpriteSheet gSpriteSheet;
 LTexture gSpriteSheetTexture;
 
+// Walking direction, input sequence and timestamp packed so they change together
+std::atomic<Uint64> gInputState(1);
+
+std::atomic<bool> gSimulationRunning(false);
+std::atomic<Uint64> gSimulationTicks(0);
+
+std::atomic<bool> gGeneratingInput(false);
+
 LTexture::LTexture()
 {
     mTexture = NULL;
@@ -90,6 +334,9 @@ LTexture::~LTexture()
 
 bool LTexture::loadFromFile(std::string path)
 {
+    // Get rid of preexisting texture
+    free();
+
     SDL_Texture* newTexture = NULL;
 
     SDL_Surface* loadedSurface = IMG_Load(path.c_str());
@@ -140,6 +387,242 @@ void LTexture::render(int x, int y, SDL_Rect* clip)
     SDL_RenderCopy(gRenderer, mTexture, clip, &renderQuad);
 }
 
+LSnapshotBuffer::LSnapshotBuffer()
+{
+    memset(mSlots, 0, sizeof(mSlots));
+    mFront = 0;
+    mShared = 1;
+    mBack = 2;
+}
+
+void LSnapshotBuffer::publish(const SceneSnapshot& snapshot)
+{
+    mSlots[mBack] = snapshot;
+
+    // Swap the written slot in, taking back whichever slot was shared
+    mBack = mShared.exchange(mBack | FRESH, std::memory_order_acq_rel) & ~FRESH;
+}
+
+bool LSnapshotBuffer::consume()
+{
+    if (!(mShared.load(std::memory_order_relaxed) & FRESH)) {
+        return false;
+    }
+
+    mFront = mShared.exchange(mFront, std::memory_order_acq_rel) & ~FRESH;
+    return true;
+}
+
+const SceneSnapshot& LSnapshotBuffer::getFront()
+{
+    return mSlots[mFront];
+}
+
+void handleEvent(SDL_Event* e)
+{
+    if ((e->type != SDL_KEYDOWN && e->type != SDL_KEYUP) || e->key.repeat) {
+        return;
+    }
+
+    SDL_Keycode key = e->key.keysym.sym;
+    if (key != SDLK_LEFT && key != SDLK_RIGHT) {
+        return;
+    }
+
+    Uint64 state = gInputState.load();
+    int direction = (int)(state & 3) - 1;
+    Uint32 sequence = (Uint32)(state >> 2) & 0x3FFFFFFF;
+
+    if (e->type == SDL_KEYDOWN) {
+        direction = key == SDLK_LEFT ? -1 : 1;
+    } else if ((key == SDLK_LEFT && direction < 0) || (key == SDLK_RIGHT && direction > 0)) {
+        direction = 0;
+    }
+
+    // Timestamp of the event itself, so time spent queued counts as latency
+    sequence = (sequence + 1) & 0x3FFFFFFF;
+    gInputState = (Uint64)e->key.timestamp << 32 | (Uint64)sequence << 2 | (Uint64)(direction + 1);
+}
+
+void applyInput(Simulation* simulation)
+{
+    Uint64 state = gInputState.load();
+
+    simulation->direction = (int)(state & 3) - 1;
+    simulation->inputSequence = (Uint32)(state >> 2) & 0x3FFFFFFF;
+    simulation->inputTimestamp = (Uint32)(state >> 32);
+}
+
+void stepSimulation(Simulation* simulation, double dt)
+{
+    simulation->time += dt;
+
+    simulation->x += simulation->direction * WALK_SPEED * dt;
+    simulation->x = SDL_max(0.0, SDL_min((double)(SCREEN_WIDTH - gSpriteSheet.getClip(0)->w), simulation->x));
+
+    ++simulation->tick;
+}
+
+SceneSnapshot takeSnapshot(const Simulation& simulation)
+{
+    SceneSnapshot snapshot;
+    snapshot.tick = simulation.tick;
+    snapshot.animationFrame = gSpriteSheet.getFrameAt(simulation.time * 1000);
+    snapshot.x = (int)simulation.x;
+    snapshot.inputSequence = simulation.inputSequence;
+    snapshot.inputTimestamp = simulation.inputTimestamp;
+
+    return snapshot;
+}
+
+void renderSnapshot(const SceneSnapshot& snapshot)
+{
+    SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+    SDL_RenderClear(gRenderer);
+
+    SDL_Rect* currentClip = gSpriteSheet.getClip(snapshot.animationFrame);
+    gSpriteSheetTexture.render(snapshot.x, (SCREEN_HEIGHT - currentClip->h) / 2, currentClip);
+}
+
+void runSimulation(LSnapshotBuffer* buffer)
+{
+    Simulation simulation;
+    memset(&simulation, 0, sizeof(simulation));
+    simulation.x = (SCREEN_WIDTH - gSpriteSheet.getClip(0)->w) / 2;
+
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    Uint64 period = SDL_GetPerformanceFrequency() / SIMULATION_RATE;
+    Uint64 next = SDL_GetPerformanceCounter();
+
+    while (gSimulationRunning) {
+        applyInput(&simulation);
+        stepSimulation(&simulation, 1.0 / SIMULATION_RATE);
+        buffer->publish(takeSnapshot(simulation));
+        ++gSimulationTicks;
+
+        // Sleep off what is left of the step, never blocked by the renderer
+        next += period;
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (next > now) {
+            SDL_Delay((Uint32)((next - now) * 1000.0 / frequency));
+        } else {
+            next = now;
+        }
+    }
+}
+
+void generateInput()
+{
+    bool left = false;
+
+    while (gGeneratingInput) {
+        SDL_Delay(BENCHMARK_INPUT_INTERVAL / 2 + rand() % BENCHMARK_INPUT_INTERVAL);
+
+        SDL_Event e;
+        memset(&e, 0, sizeof(e));
+        e.type = SDL_KEYDOWN;
+        e.key.keysym.sym = left ? SDLK_LEFT : SDLK_RIGHT;
+        e.key.timestamp = SDL_GetTicks();
+        SDL_PushEvent(&e);
+
+        left = !left;
+    }
+}
+
+bool runMainLoop(bool threaded, Uint32 duration)
+{
+    bool quit = false;
+
+    SDL_Event e;
+
+    LSnapshotBuffer buffer;
+    std::thread simulationThread;
+
+    // Single threaded the simulation catches up in fixed steps every frame
+    Simulation simulation;
+    memset(&simulation, 0, sizeof(simulation));
+    simulation.x = (SCREEN_WIDTH - gSpriteSheet.getClip(0)->w) / 2;
+    double accumulator = 0;
+
+    // Input left over from an earlier run is the starting state, not a new input to time
+    applyInput(&simulation);
+    Uint32 lastSequence = simulation.inputSequence;
+
+    gSimulationTicks = 0;
+    if (threaded) {
+        // Frames before the simulation thread first publishes show the starting scene
+        buffer.publish(takeSnapshot(simulation));
+        buffer.consume();
+
+        gSimulationRunning = true;
+        simulationThread = std::thread(runSimulation, &buffer);
+    }
+
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 last = start;
+    Uint32 startTicks = SDL_GetTicks();
+
+    int frames = 0;
+    int latencySamples = 0;
+    Uint32 latencyTotal = 0;
+    Uint32 latencyMax = 0;
+
+    while (!quit && (duration == 0 || SDL_GetTicks() - startTicks < duration)) {
+        while (SDL_PollEvent(&e) != 0) {
+            if (e.type == SDL_QUIT) {
+                quit = true;
+            } else {
+                handleEvent(&e);
+            }
+        }
+
+        SceneSnapshot snapshot;
+        if (threaded) {
+            buffer.consume();
+            snapshot = buffer.getFront();
+        } else {
+            Uint64 now = SDL_GetPerformanceCounter();
+            accumulator += (now - last) / frequency;
+            last = now;
+
+            applyInput(&simulation);
+            while (accumulator >= 1.0 / SIMULATION_RATE) {
+                stepSimulation(&simulation, 1.0 / SIMULATION_RATE);
+                accumulator -= 1.0 / SIMULATION_RATE;
+                ++gSimulationTicks;
+            }
+
+            snapshot = takeSnapshot(simulation);
+        }
+
+        renderSnapshot(snapshot);
+        SDL_RenderPresent(gRenderer);
+        ++frames;
+
+        // Input to present of the first frame showing the input
+        if (snapshot.inputSequence != lastSequence) {
+            Uint32 latency = SDL_GetTicks() - snapshot.inputTimestamp;
+            latencyTotal += latency;
+            latencyMax = SDL_max(latencyMax, latency);
+            ++latencySamples;
+            lastSequence = snapshot.inputSequence;
+        }
+    }
+
+    if (threaded) {
+        gSimulationRunning = false;
+        simulationThread.join();
+    }
+
+    double seconds = (SDL_GetPerformanceCounter() - start) / frequency;
+    printf("%s: %.1f frames/s, %.1f simulation steps/s, input to present %.1f ms average, %u ms max over %d inputs\n",
+        threaded ? "Threaded" : "Single threaded", frames / seconds, gSimulationTicks / seconds,
+        latencySamples > 0 ? (double)latencyTotal / latencySamples : 0.0, latencyMax, latencySamples);
+
+    return quit;
+}
+
 bool init()
 {
     bool success = true;
@@ -172,6 +655,511 @@ bool init()
     return success;
 }
 
+LJsonValue::LJsonValue()
+{
+    type = JSON_NULL;
+    boolean = false;
+    number = 0;
+}
+
+const LJsonValue* LJsonValue::get(const char* key) const
+{
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (keys[i] == key) {
+            return &items[i];
+        }
+    }
+
+    return NULL;
+}
+
+double LJsonValue::getNumber(const char* key, double fallback) const
+{
+    const LJsonValue* value = get(key);
+    if (value == NULL) {
+        return fallback;
+    }
+
+    if (value->type == JSON_BOOL) {
+        return value->boolean ? 1 : 0;
+    }
+
+    return value->type == JSON_NUMBER ? value->number : fallback;
+}
+
+static void skipWhitespace(const char** text)
+{
+    while (**text == ' ' || **text == '\t' || **text == '\n' || **text == '\r') {
+        ++*text;
+    }
+}
+
+static bool parseJsonString(const char** text, std::string* out)
+{
+    const char* p = *text + 1;
+    out->clear();
+
+    while (*p != '"') {
+        if (*p == '\0') {
+            return false;
+        }
+
+        if (*p != '\\') {
+            out->push_back(*p++);
+            continue;
+        }
+
+        ++p;
+        switch (*p) {
+            case 'b':
+            out->push_back('\b');
+            break;
+
+            case 'f':
+            out->push_back('\f');
+            break;
+
+            case 'n':
+            out->push_back('\n');
+            break;
+
+            case 'r':
+            out->push_back('\r');
+            break;
+
+            case 't':
+            out->push_back('\t');
+            break;
+
+            // Basic multilingual plane only, encoded as UTF-8
+            case 'u':
+            {
+                unsigned code = 0;
+                for (int i = 1; i <= 4; ++i) {
+                    char c = p[i];
+                    code <<= 4;
+                    if (c >= '0' && c <= '9') {
+                        code |= c - '0';
+                    } else if (c >= 'a' && c <= 'f') {
+                        code |= c - 'a' + 10;
+                    } else if (c >= 'A' && c <= 'F') {
+                        code |= c - 'A' + 10;
+                    } else {
+                        return false;
+                    }
+                }
+                p += 4;
+
+                if (code < 0x80) {
+                    out->push_back((char)code);
+                } else if (code < 0x800) {
+                    out->push_back((char)(0xC0 | code >> 6));
+                    out->push_back((char)(0x80 | (code & 0x3F)));
+                } else {
+                    out->push_back((char)(0xE0 | code >> 12));
+                    out->push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+                    out->push_back((char)(0x80 | (code & 0x3F)));
+                }
+                break;
+            }
+
+            case '\0':
+            return false;
+
+            default:
+            out->push_back(*p);
+            break;
+        }
+        ++p;
+    }
+
+    *text = p + 1;
+    return true;
+}
+
+static bool parseJsonValue(const char** text, LJsonValue* value, int depth)
+{
+    // Sprite sheet exports nest a few levels, anything deeper is not one
+    if (depth > 32) {
+        return false;
+    }
+
+    skipWhitespace(text);
+    const char* p = *text;
+
+    if (*p == '{' || *p == '[') {
+        bool object = *p == '{';
+        value->type = object ? LJsonValue::JSON_OBJECT : LJsonValue::JSON_ARRAY;
+        char close = object ? '}' : ']';
+
+        ++*text;
+        skipWhitespace(text);
+        if (**text == close) {
+            ++*text;
+            return true;
+        }
+
+        while (true) {
+            if (object) {
+                skipWhitespace(text);
+                std::string key;
+                if (**text != '"' || !parseJsonString(text, &key)) {
+                    return false;
+                }
+                skipWhitespace(text);
+                if (**text != ':') {
+                    return false;
+                }
+                ++*text;
+                value->keys.push_back(key);
+            }
+
+            value->items.push_back(LJsonValue());
+            if (!parseJsonValue(text, &value->items.back(), depth + 1)) {
+                return false;
+            }
+
+            skipWhitespace(text);
+            if (**text == ',') {
+                ++*text;
+            } else if (**text == close) {
+                ++*text;
+                return true;
+            } else {
+                return false;
+            }
+        }
+    }
+
+    if (*p == '"') {
+        value->type = LJsonValue::JSON_STRING;
+        return parseJsonString(text, &value->string);
+    }
+
+    if (strncmp(p, "true", 4) == 0 || strncmp(p, "false", 5) == 0) {
+        value->type = LJsonValue::JSON_BOOL;
+        value->boolean = *p == 't';
+        *text += value->boolean ? 4 : 5;
+        return true;
+    }
+
+    if (strncmp(p, "null", 4) == 0) {
+        value->type = LJsonValue::JSON_NULL;
+        *text += 4;
+        return true;
+    }
+
+    char* end = NULL;
+    value->type = LJsonValue::JSON_NUMBER;
+    value->number = strtod(p, &end);
+    if (end == p) {
+        return false;
+    }
+
+    *text = end;
+    return true;
+}
+
+bool parseJson(const char* text, LJsonValue* root)
+{
+    if (!parseJsonValue(&text, root, 0)) {
+        return false;
+    }
+
+    skipWhitespace(&text);
+    return *text == '\0';
+}
+
+LSpriteSheet::LSpriteSheet()
+{
+    mFrames = NULL;
+    mNames = NULL;
+    mFrameCount = 0;
+    mTotalDuration = 0;
+    mMapping = NULL;
+    mMappingSize = 0;
+}
+
+LSpriteSheet::~LSpriteSheet()
+{
+    free();
+}
+
+void LSpriteSheet::free()
+{
+    if (mMapping != NULL) {
+        unloadSidecar(mMapping, mMappingSize);
+        mMapping = NULL;
+        mMappingSize = 0;
+    }
+
+    mParsedFrames.clear();
+    mParsedNames.clear();
+    mFrames = NULL;
+    mNames = NULL;
+    mFrameCount = 0;
+    mTotalDuration = 0;
+}
+
+bool LSpriteSheet::loadFromFile(std::string path)
+{
+    free();
+
+    struct stat json;
+    if (stat(path.c_str(), &json) != 0) {
+        printf("Unable to find sprite sheet %s! %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    if (!loadSidecar(path + ".bin", json.st_size, json.st_mtime)) {
+        if (!parseExport(path)) {
+            return false;
+        }
+
+        writeSidecar(path + ".bin", json.st_size, json.st_mtime);
+
+        mFrames = mParsedFrames.empty() ? NULL : &mParsedFrames[0];
+        mNames = mParsedNames.c_str();
+        mFrameCount = (int)mParsedFrames.size();
+    }
+
+    for (int i = 0; i < mFrameCount; ++i) {
+        mTotalDuration += mFrames[i].duration;
+    }
+
+    return mFrameCount > 0;
+}
+
+bool LSpriteSheet::parseExport(std::string path)
+{
+    size_t size = 0;
+    char* text = (char*)SDL_LoadFile(path.c_str(), &size);
+    if (text == NULL) {
+        printf("Unable to read sprite sheet %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+        return false;
+    }
+
+    LJsonValue root;
+    bool parsed = parseJson(text, &root);
+    SDL_free(text);
+
+    const LJsonValue* frames = parsed ? root.get("frames") : NULL;
+    if (frames == NULL || (frames->type != LJsonValue::JSON_ARRAY && frames->type != LJsonValue::JSON_OBJECT)) {
+        printf("Sprite sheet %s has no frames!\n", path.c_str());
+        return false;
+    }
+
+    // Hash exports key frames by name, array exports carry a filename
+    for (size_t i = 0; i < frames->items.size(); ++i) {
+        const LJsonValue& entry = frames->items[i];
+        const LJsonValue* filename = entry.get("filename");
+        std::string name = frames->type == LJsonValue::JSON_OBJECT ? frames->keys[i] : (filename != NULL ? filename->string : "");
+
+        const LJsonValue* rect = entry.get("frame");
+        if (rect == NULL) {
+            printf("Frame %s of %s has no rectangle!\n", name.c_str(), path.c_str());
+            return false;
+        }
+
+        LSpriteFrame frame;
+        frame.clip.x = (int)rect->getNumber("x", 0);
+        frame.clip.y = (int)rect->getNumber("y", 0);
+        frame.clip.w = (int)rect->getNumber("w", 0);
+        frame.clip.h = (int)rect->getNumber("h", 0);
+        frame.rotated = (Sint32)entry.getNumber("rotated", 0);
+
+        // Untrimmed frames are their own source
+        const LJsonValue* spriteSource = entry.get("spriteSourceSize");
+        const LJsonValue* sourceSize = entry.get("sourceSize");
+        frame.offsetX = spriteSource != NULL ? (Sint32)spriteSource->getNumber("x", 0) : 0;
+        frame.offsetY = spriteSource != NULL ? (Sint32)spriteSource->getNumber("y", 0) : 0;
+        frame.sourceWidth = sourceSize != NULL ? (Sint32)sourceSize->getNumber("w", frame.clip.w) : frame.clip.w;
+        frame.sourceHeight = sourceSize != NULL ? (Sint32)sourceSize->getNumber("h", frame.clip.h) : frame.clip.h;
+
+        const LJsonValue* pivot = entry.get("pivot");
+        frame.pivotX = pivot != NULL ? (float)pivot->getNumber("x", 0.5) : 0.5f;
+        frame.pivotY = pivot != NULL ? (float)pivot->getNumber("y", 0.5) : 0.5f;
+
+        frame.duration = (Sint32)entry.getNumber("duration", 100);
+
+        frame.nameOffset = (Uint32)mParsedNames.size();
+        mParsedNames.append(name);
+        mParsedNames.push_back('\0');
+
+        mParsedFrames.push_back(frame);
+    }
+
+    return true;
+}
+
+bool LSpriteSheet::loadSidecar(std::string path, Sint64 jsonSize, Sint64 jsonModified)
+{
+    void* mapping = NULL;
+    size_t size = 0;
+
+#if defined(__linux__)
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+
+    struct stat sidecar;
+    if (fstat(file, &sidecar) == 0 && (size_t)sidecar.st_size >= sizeof(LSpriteSheetHeader)) {
+        // Private and writable so clips can be handed out as SDL_Rect*, nothing goes back to the file
+        size = sidecar.st_size;
+        mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+        if (mapping == MAP_FAILED) {
+            mapping = NULL;
+        }
+    }
+    close(file);
+#else
+    mapping = SDL_LoadFile(path.c_str(), &size);
+#endif
+
+    if (mapping == NULL) {
+        return false;
+    }
+
+    const LSpriteSheetHeader* header = (const LSpriteSheetHeader*)mapping;
+    bool current = size >= sizeof(LSpriteSheetHeader) && memcmp(header->magic, "LSPR", 4) == 0 && header->version == 1
+        && header->frameSize == sizeof(LSpriteFrame) && header->jsonSize == jsonSize && header->jsonModified == jsonModified
+        && sizeof(LSpriteSheetHeader) + (size_t)header->frameCount * sizeof(LSpriteFrame) + header->namesSize == size
+        && header->namesSize > 0;
+
+    const LSpriteFrame* frames = (const LSpriteFrame*)((Uint8*)mapping + sizeof(LSpriteSheetHeader));
+    const char* names = (const char*)(frames + (current ? header->frameCount : 0));
+    if (current && names[header->namesSize - 1] != '\0') {
+        current = false;
+    }
+
+    // A damaged sidecar with a current time must not send names past the table
+    for (Uint32 i = 0; current && i < header->frameCount; ++i) {
+        if (frames[i].nameOffset >= header->namesSize) {
+            current = false;
+        }
+    }
+
+    if (!current) {
+        unloadSidecar(mapping, size);
+        return false;
+    }
+
+    mMapping = mapping;
+    mMappingSize = size;
+    mFrames = (LSpriteFrame*)frames;
+    mNames = names;
+    mFrameCount = (int)header->frameCount;
+
+    return true;
+}
+
+void LSpriteSheet::unloadSidecar(void* mapping, size_t size)
+{
+#if defined(__linux__)
+    munmap(mapping, size);
+#else
+    // Read by SDL_LoadFile, only munmap needs the size
+    (void)size;
+    SDL_free(mapping);
+#endif
+}
+
+void LSpriteSheet::writeSidecar(std::string path, Sint64 jsonSize, Sint64 jsonModified)
+{
+    if (mParsedFrames.empty()) {
+        return;
+    }
+
+    LSpriteSheetHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "LSPR", 4);
+    header.version = 1;
+    header.frameSize = sizeof(LSpriteFrame);
+    header.frameCount = (Uint32)mParsedFrames.size();
+    header.namesSize = (Uint32)mParsedNames.size();
+    header.jsonSize = jsonSize;
+    header.jsonModified = jsonModified;
+
+    // Written aside and renamed so a reader never maps half a file
+    std::string temporary = path + ".tmp";
+    SDL_RWops* file = SDL_RWFromFile(temporary.c_str(), "wb");
+    if (file == NULL) {
+        printf("Unable to write sprite sheet cache %s! SDL Error: %s\n", temporary.c_str(), SDL_GetError());
+        return;
+    }
+
+    bool written = SDL_RWwrite(file, &header, sizeof(header), 1) == 1
+        && SDL_RWwrite(file, &mParsedFrames[0], sizeof(LSpriteFrame), mParsedFrames.size()) == mParsedFrames.size()
+        && SDL_RWwrite(file, mParsedNames.data(), mParsedNames.size(), 1) == 1;
+    SDL_RWclose(file);
+
+#if !defined(__linux__)
+    // rename does not replace an existing file everywhere, and nothing has the old one mapped here
+    if (written) {
+        remove(path.c_str());
+    }
+#endif
+
+    if (!written || rename(temporary.c_str(), path.c_str()) != 0) {
+        printf("Unable to write sprite sheet cache %s!\n", path.c_str());
+        remove(temporary.c_str());
+    }
+}
+
+int LSpriteSheet::getFrameCount()
+{
+    return mFrameCount;
+}
+
+const LSpriteFrame& LSpriteSheet::getFrame(int index)
+{
+    return mFrames[index];
+}
+
+SDL_Rect* LSpriteSheet::getClip(int index)
+{
+    return &mFrames[index].clip;
+}
+
+const char* LSpriteSheet::getName(int index)
+{
+    return mNames + mFrames[index].nameOffset;
+}
+
+int LSpriteSheet::findFrame(std::string name)
+{
+    for (int i = 0; i < mFrameCount; ++i) {
+        if (name == getName(i)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+int LSpriteSheet::getFrameAt(double milliseconds)
+{
+    if (mTotalDuration <= 0) {
+        return 0;
+    }
+
+    double time = fmod(milliseconds, mTotalDuration);
+    for (int i = 0; i < mFrameCount; ++i) {
+        time -= mFrames[i].duration;
+        if (time < 0) {
+            return i;
+        }
+    }
+
+    return mFrameCount - 1;
+}
+
+bool LSpriteSheet::isFromSidecar()
+{
+    return mMapping != NULL;
+}
+
 bool loadMedia()
 {
     bool success = true;
@@ -180,26 +1168,11 @@ bool loadMedia()
         printf("Failed to load walking animation texture!\n");
         success = false;
     } else {
-        // Set the sprite clips
-        gSpriteClips[0].x = 0;
-        gSpriteClips[0].y = 0;
-        gSpriteClips[0].w = 64;
-        gSpriteClips[0].h = 205;
-
-        gSpriteClips[1].x = 64;
-        gSpriteClips[1].y = 0;
-        gSpriteClips[1].w = 64;
-        gSpriteClips[1].h = 205;
-
-        gSpriteClips[2].x = 128;
-        gSpriteClips[2].y = 0;
-        gSpriteClips[2].w = 64;
-        gSpriteClips[2].h = 205;
-
-        gSpriteClips[3].x = 192;
-        gSpriteClips[3].y = 0;
-        gSpriteClips[3].w = 64;
-        gSpriteClips[3].h = 205;
+        // Walk cycle clips and frame durations come from the exported sheet
+        if (!gSpriteSheet.loadFromFile("foo.json")) {
+            printf("Failed to load walking animation frames!\n");
+            success = false;
+        }
     }
 
     return success;
@@ -207,6 +1180,7 @@ bool loadMedia()
 
 void close()
 {
+    gSpriteSheet.free();
     gSpriteSheetTexture.free();
 
     SDL_DestroyRenderer(gRenderer);
@@ -219,39 +1193,27 @@ void close()
 }
 
 int main (int argc, char *argv[]) {
+    // --threaded simulates on its own thread, --bench runs both modes with generated input
+    std::string mode = argc > 1 ? argv[1] : "";
+
     if (!init()) {
         printf("Failed to initialize!\n");
     } else {
         if (!loadMedia()) {
             printf("Failed to load media!\n");
-        } else {
-            bool quit = false;
-
-            SDL_Event e;
-
-            int frame = 0;
+        } else if (mode == "--bench") {
+            gGeneratingInput = true;
+            std::thread inputThread(generateInput);
 
-            while (!quit) {
-                while (SDL_PollEvent(&e) != 0) {
-                    if (e.type == SDL_QUIT) {
-                        quit = true;
-                    }
-                }
-
-                SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
-                SDL_RenderClear(gRenderer);
-
-                SDL_Rect* currentClip = &gSpriteClips[frame / 10];
-                gSpriteSheetTexture.render((SCREEN_WIDTH - currentClip->w) / 2, (SCREEN_HEIGHT - currentClip->h) / 2, currentClip);
-
-                SDL_RenderPresent(gRenderer);
-
-                ++frame;
-
-                if (frame / 10 >= WALKING_ANIMATION_FRAMES) {
-                    frame = 0;
-                }
+            bool quit = runMainLoop(false, BENCHMARK_SECONDS * 1000);
+            if (!quit) {
+                runMainLoop(true, BENCHMARK_SECONDS * 1000);
             }
+
+            gGeneratingInput = false;
+            inputThread.join();
+        } else {
+            runMainLoop(mode == "--threaded", 0);
         }
     }
 
@@ -3,10 +3,22 @@
 #include <SDL2/SDL_events.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_render.h>
+#include <SDL2/SDL_rwops.h>
 #include <SDL2/SDL_surface.h>
 #include <SDL2/SDL_video.h>
+#include <cerrno>
+#include <cmath>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <string>
+#include <vector>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 480;
@@ -43,18 +55,152 @@ class LTexture
         int mHeight;
 };
 
+// Parsed JSON document, only as much as sprite sheet exports need
+struct LJsonValue
+{
+    enum Type
+    {
+        JSON_NULL,
+        JSON_BOOL,
+        JSON_NUMBER,
+        JSON_STRING,
+        JSON_ARRAY,
+        JSON_OBJECT
+    };
+
+    Type type;
+    bool boolean;
+    double number;
+    std::string string;
+
+    // Array elements, or object values in the order of keys
+    std::vector<LJsonValue> items;
+    std::vector<std::string> keys;
+
+    LJsonValue();
+
+    // Member of an object, NULL when missing
+    const LJsonValue* get(const char* key) const;
+
+    // Number or bool member of an object, fallback when missing
+    double getNumber(const char* key, double fallback) const;
+};
+
+// Frame of a sprite sheet, stored as is in the binary sidecar
+struct LSpriteFrame
+{
+    // Rectangle in the sheet texture, rotated clips are kept as exported
+    SDL_Rect clip;
+    Sint32 rotated;
+
+    // Where the trimmed clip sits in the untrimmed frame, and that frame's size
+    Sint32 offsetX;
+    Sint32 offsetY;
+    Sint32 sourceWidth;
+    Sint32 sourceHeight;
+
+    // Pivot relative to the untrimmed frame, 0 to 1
+    float pivotX;
+    float pivotY;
+
+    // Milliseconds shown when animated
+    Sint32 duration;
+
+    // Start of the name in the name table
+    Uint32 nameOffset;
+};
+
+// Sidecar layout: this header, the frames, then the NUL terminated names
+struct LSpriteSheetHeader
+{
+    char magic[4];
+    Uint32 version;
+    Uint32 frameSize;
+    Uint32 frameCount;
+    Uint32 namesSize;
+    Uint32 padding;
+
+    // JSON the sidecar was built from, a mismatch means rebuild
+    Sint64 jsonSize;
+    Sint64 jsonModified;
+};
+
+// Frames of an Aseprite or TexturePacker JSON export, array or hash layout
+class LSpriteSheet
+{
+    public:
+        // Initialize
+        LSpriteSheet();
+
+        // Deallocate
+        ~LSpriteSheet();
+
+        // Loads the export at path from its binary sidecar when that is current,
+        // otherwise parses the JSON and writes the sidecar for next time
+        bool loadFromFile(std::string path);
+
+        // Deallocate frames
+        void free();
+
+        int getFrameCount();
+
+        // Frame by index in export order
+        const LSpriteFrame& getFrame(int index);
+        SDL_Rect* getClip(int index);
+        const char* getName(int index);
+
+        // Index of the named frame, -1 when missing
+        int findFrame(std::string name);
+
+        // Index of the frame showing at milliseconds into the looped animation
+        int getFrameAt(double milliseconds);
+
+        // Whether the last load came from the sidecar
+        bool isFromSidecar();
+
+    private:
+        // Fills mParsedFrames and mParsedNames from JSON
+        bool parseExport(std::string path);
+
+        // Maps sidecar if it was built from a JSON of this size and time, reads it where mmap is unavailable
+        bool loadSidecar(std::string path, Sint64 jsonSize, Sint64 jsonModified);
+
+        // Releases what loadSidecar mapped or read
+        static void unloadSidecar(void* mapping, size_t size);
+
+        // Writes parsed frames next to the JSON
+        void writeSidecar(std::string path, Sint64 jsonSize, Sint64 jsonModified);
+
+        // Frames and names, pointing into the mapped sidecar or the parsed copies
+        LSpriteFrame* mFrames;
+        const char* mNames;
+        int mFrameCount;
+        double mTotalDuration;
+
+        std::vector<LSpriteFrame> mParsedFrames;
+        std::string mParsedNames;
+
+        // Sidecar mapping or copy, NULL when parsed
+        void* mMapping;
+        size_t mMappingSize;
+};
+
 bool init();
 
 bool loadMedia();
 
 void close();
 
+// Parses JSON text into root, false on malformed input
+bool parseJson(const char* text, LJsonValue* root);
+
 SDL_Window* gWindow = NULL;
 
 SDL_Renderer* gRenderer = NULL;
 
 // Scene sprites
 SDL_Rect gSpriteClips[4];
+LSpriteSheet gSpriteSheet;
 LTexture gSpriteSheetTexture;
 
 bool init()
@@ -165,6 +311,511 @@ int LTexture::getHeight()
     return mHeight;
 }
 
+LJsonValue::LJsonValue()
+{
+    type = JSON_NULL;
+    boolean = false;
+    number = 0;
+}
+
+const LJsonValue* LJsonValue::get(const char* key) const
+{
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (keys[i] == key) {
+            return &items[i];
+        }
+    }
+
+    return NULL;
+}
+
+double LJsonValue::getNumber(const char* key, double fallback) const
+{
+    const LJsonValue* value = get(key);
+    if (value == NULL) {
+        return fallback;
+    }
+
+    if (value->type == JSON_BOOL) {
+        return value->boolean ? 1 : 0;
+    }
+
+    return value->type == JSON_NUMBER ? value->number : fallback;
+}
+
+static void skipWhitespace(const char** text)
+{
+    while (**text == ' ' || **text == '\t' || **text == '\n' || **text == '\r') {
+        ++*text;
+    }
+}
+
+static bool parseJsonString(const char** text, std::string* out)
+{
+    const char* p = *text + 1;
+    out->clear();
+
+    while (*p != '"') {
+        if (*p == '\0') {
+            return false;
+        }
+
+        if (*p != '\\') {
+            out->push_back(*p++);
+            continue;
+        }
+
+        ++p;
+        switch (*p) {
+            case 'b':
+            out->push_back('\b');
+            break;
+
+            case 'f':
+            out->push_back('\f');
+            break;
+
+            case 'n':
+            out->push_back('\n');
+            break;
+
+            case 'r':
+            out->push_back('\r');
+            break;
+
+            case 't':
+            out->push_back('\t');
+            break;
+
+            // Basic multilingual plane only, encoded as UTF-8
+            case 'u':
+            {
+                unsigned code = 0;
+                for (int i = 1; i <= 4; ++i) {
+                    char c = p[i];
+                    code <<= 4;
+                    if (c >= '0' && c <= '9') {
+                        code |= c - '0';
+                    } else if (c >= 'a' && c <= 'f') {
+                        code |= c - 'a' + 10;
+                    } else if (c >= 'A' && c <= 'F') {
+                        code |= c - 'A' + 10;
+                    } else {
+                        return false;
+                    }
+                }
+                p += 4;
+
+                if (code < 0x80) {
+                    out->push_back((char)code);
+                } else if (code < 0x800) {
+                    out->push_back((char)(0xC0 | code >> 6));
+                    out->push_back((char)(0x80 | (code & 0x3F)));
+                } else {
+                    out->push_back((char)(0xE0 | code >> 12));
+                    out->push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+                    out->push_back((char)(0x80 | (code & 0x3F)));
+                }
+                break;
+            }
+
+            case '\0':
+            return false;
+
+            default:
+            out->push_back(*p);
+            break;
+        }
+        ++p;
+    }
+
+    *text = p + 1;
+    return true;
+}
+
+static bool parseJsonValue(const char** text, LJsonValue* value, int depth)
+{
+    // Sprite sheet exports nest a few levels, anything deeper is not one
+    if (depth > 32) {
+        return false;
+    }
+
+    skipWhitespace(text);
+    const char* p = *text;
+
+    if (*p == '{' || *p == '[') {
+        bool object = *p == '{';
+        value->type = object ? LJsonValue::JSON_OBJECT : LJsonValue::JSON_ARRAY;
+        char close = object ? '}' : ']';
+
+        ++*text;
+        skipWhitespace(text);
+        if (**text == close) {
+            ++*text;
+            return true;
+        }
+
+        while (true) {
+            if (object) {
+                skipWhitespace(text);
+                std::string key;
+                if (**text != '"' || !parseJsonString(text, &key)) {
+                    return false;
+                }
+                skipWhitespace(text);
+                if (**text != ':') {
+                    return false;
+                }
+                ++*text;
+                value->keys.push_back(key);
+            }
+
+            value->items.push_back(LJsonValue());
+            if (!parseJsonValue(text, &value->items.back(), depth + 1)) {
+                return false;
+            }
+
+            skipWhitespace(text);
+            if (**text == ',') {
+                ++*text;
+            } else if (**text == close) {
+                ++*text;
+                return true;
+            } else {
+                return false;
+            }
+        }
+    }
+
+    if (*p == '"') {
+        value->type = LJsonValue::JSON_STRING;
+        return parseJsonString(text, &value->string);
+    }
+
+    if (strncmp(p, "true", 4) == 0 || strncmp(p, "false", 5) == 0) {
+        value->type = LJsonValue::JSON_BOOL;
+        value->boolean = *p == 't';
+        *text += value->boolean ? 4 : 5;
+        return true;
+    }
+
+    if (strncmp(p, "null", 4) == 0) {
+        value->type = LJsonValue::JSON_NULL;
+        *text += 4;
+        return true;
+    }
+
+    char* end = NULL;
+    value->type = LJsonValue::JSON_NUMBER;
+    value->number = strtod(p, &end);
+    if (end == p) {
+        return false;
+    }
+
+    *text = end;
+    return true;
+}
+
+bool parseJson(const char* text, LJsonValue* root)
+{
+    if (!parseJsonValue(&text, root, 0)) {
+        return false;
+    }
+
+    skipWhitespace(&text);
+    return *text == '\0';
+}
+
+LSpriteSheet::LSpriteSheet()
+{
+    mFrames = NULL;
+    mNames = NULL;
+    mFrameCount = 0;
+    mTotalDuration = 0;
+    mMapping = NULL;
+    mMappingSize = 0;
+}
+
+LSpriteSheet::~LSpriteSheet()
+{
+    free();
+}
+
+void LSpriteSheet::free()
+{
+    if (mMapping != NULL) {
+        unloadSidecar(mMapping, mMappingSize);
+        mMapping = NULL;
+        mMappingSize = 0;
+    }
+
+    mParsedFrames.clear();
+    mParsedNames.clear();
+    mFrames = NULL;
+    mNames = NULL;
+    mFrameCount = 0;
+    mTotalDuration = 0;
+}
+
+bool LSpriteSheet::loadFromFile(std::string path)
+{
+    free();
+
+    struct stat json;
+    if (stat(path.c_str(), &json) != 0) {
+        printf("Unable to find sprite sheet %s! %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    if (!loadSidecar(path + ".bin", json.st_size, json.st_mtime)) {
+        if (!parseExport(path)) {
+            return false;
+        }
+
+        writeSidecar(path + ".bin", json.st_size, json.st_mtime);
+
+        mFrames = mParsedFrames.empty() ? NULL : &mParsedFrames[0];
+        mNames = mParsedNames.c_str();
+        mFrameCount = (int)mParsedFrames.size();
+    }
+
+    for (int i = 0; i < mFrameCount; ++i) {
+        mTotalDuration += mFrames[i].duration;
+    }
+
+    return mFrameCount > 0;
+}
+
+bool LSpriteSheet::parseExport(std::string path)
+{
+    size_t size = 0;
+    char* text = (char*)SDL_LoadFile(path.c_str(), &size);
+    if (text == NULL) {
+        printf("Unable to read sprite sheet %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+        return false;
+    }
+
+    LJsonValue root;
+    bool parsed = parseJson(text, &root);
+    SDL_free(text);
+
+    const LJsonValue* frames = parsed ? root.get("frames") : NULL;
+    if (frames == NULL || (frames->type != LJsonValue::JSON_ARRAY && frames->type != LJsonValue::JSON_OBJECT)) {
+        printf("Sprite sheet %s has no frames!\n", path.c_str());
+        return false;
+    }
+
+    // Hash exports key frames by name, array exports carry a filename
+    for (size_t i = 0; i < frames->items.size(); ++i) {
+        const LJsonValue& entry = frames->items[i];
+        const LJsonValue* filename = entry.get("filename");
+        std::string name = frames->type == LJsonValue::JSON_OBJECT ? frames->keys[i] : (filename != NULL ? filename->string : "");
+
+        const LJsonValue* rect = entry.get("frame");
+        if (rect == NULL) {
+            printf("Frame %s of %s has no rectangle!\n", name.c_str(), path.c_str());
+            return false;
+        }
+
+        LSpriteFrame frame;
+        frame.clip.x = (int)rect->getNumber("x", 0);
+        frame.clip.y = (int)rect->getNumber("y", 0);
+        frame.clip.w = (int)rect->getNumber("w", 0);
+        frame.clip.h = (int)rect->getNumber("h", 0);
+        frame.rotated = (Sint32)entry.getNumber("rotated", 0);
+
+        // Untrimmed frames are their own source
+        const LJsonValue* spriteSource = entry.get("spriteSourceSize");
+        const LJsonValue* sourceSize = entry.get("sourceSize");
+        frame.offsetX = spriteSource != NULL ? (Sint32)spriteSource->getNumber("x", 0) : 0;
+        frame.offsetY = spriteSource != NULL ? (Sint32)spriteSource->getNumber("y", 0) : 0;
+        frame.sourceWidth = sourceSize != NULL ? (Sint32)sourceSize->getNumber("w", frame.clip.w) : frame.clip.w;
+        frame.sourceHeight = sourceSize != NULL ? (Sint32)sourceSize->getNumber("h", frame.clip.h) : frame.clip.h;
+
+        const LJsonValue* pivot = entry.get("pivot");
+        frame.pivotX = pivot != NULL ? (float)pivot->getNumber("x", 0.5) : 0.5f;
+        frame.pivotY = pivot != NULL ? (float)pivot->getNumber("y", 0.5) : 0.5f;
+
+        frame.duration = (Sint32)entry.getNumber("duration", 100);
+
+        frame.nameOffset = (Uint32)mParsedNames.size();
+        mParsedNames.append(name);
+        mParsedNames.push_back('\0');
+
+        mParsedFrames.push_back(frame);
+    }
+
+    return true;
+}
+
+bool LSpriteSheet::loadSidecar(std::string path, Sint64 jsonSize, Sint64 jsonModified)
+{
+    void* mapping = NULL;
+    size_t size = 0;
+
+#if defined(__linux__)
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+
+    struct stat sidecar;
+    if (fstat(file, &sidecar) == 0 && (size_t)sidecar.st_size >= sizeof(LSpriteSheetHeader)) {
+        // Private and writable so clips can be handed out as SDL_Rect*, nothing goes back to the file
+        size = sidecar.st_size;
+        mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+        if (mapping == MAP_FAILED) {
+            mapping = NULL;
+        }
+    }
+    close(file);
+#else
+    mapping = SDL_LoadFile(path.c_str(), &size);
+#endif
+
+    if (mapping == NULL) {
+        return false;
+    }
+
+    const LSpriteSheetHeader* header = (const LSpriteSheetHeader*)mapping;
+    bool current = size >= sizeof(LSpriteSheetHeader) && memcmp(header->magic, "LSPR", 4) == 0 && header->version == 1
+        && header->frameSize == sizeof(LSpriteFrame) && header->jsonSize == jsonSize && header->jsonModified == jsonModified
+        && sizeof(LSpriteSheetHeader) + (size_t)header->frameCount * sizeof(LSpriteFrame) + header->namesSize == size
+        && header->namesSize > 0;
+
+    const LSpriteFrame* frames = (const LSpriteFrame*)((Uint8*)mapping + sizeof(LSpriteSheetHeader));
+    const char* names = (const char*)(frames + (current ? header->frameCount : 0));
+    if (current && names[header->namesSize - 1] != '\0') {
+        current = false;
+    }
+
+    // A damaged sidecar with a current time must not send names past the table
+    for (Uint32 i = 0; current && i < header->frameCount; ++i) {
+        if (frames[i].nameOffset >= header->namesSize) {
+            current = false;
+        }
+    }
+
+    if (!current) {
+        unloadSidecar(mapping, size);
+        return false;
+    }
+
+    mMapping = mapping;
+    mMappingSize = size;
+    mFrames = (LSpriteFrame*)frames;
+    mNames = names;
+    mFrameCount = (int)header->frameCount;
+
+    return true;
+}
+
+void LSpriteSheet::unloadSidecar(void* mapping, size_t size)
+{
+#if defined(__linux__)
+    munmap(mapping, size);
+#else
+    // Read by SDL_LoadFile, only munmap needs the size
+    (void)size;
+    SDL_free(mapping);
+#endif
+}
+
+void LSpriteSheet::writeSidecar(std::string path, Sint64 jsonSize, Sint64 jsonModified)
+{
+    if (mParsedFrames.empty()) {
+        return;
+    }
+
+    LSpriteSheetHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "LSPR", 4);
+    header.version = 1;
+    header.frameSize = sizeof(LSpriteFrame);
+    header.frameCount = (Uint32)mParsedFrames.size();
+    header.namesSize = (Uint32)mParsedNames.size();
+    header.jsonSize = jsonSize;
+    header.jsonModified = jsonModified;
+
+    // Written aside and renamed so a reader never maps half a file
+    std::string temporary = path + ".tmp";
+    SDL_RWops* file = SDL_RWFromFile(temporary.c_str(), "wb");
+    if (file == NULL) {
+        printf("Unable to write sprite sheet cache %s! SDL Error: %s\n", temporary.c_str(), SDL_GetError());
+        return;
+    }
+
+    bool written = SDL_RWwrite(file, &header, sizeof(header), 1) == 1
+        && SDL_RWwrite(file, &mParsedFrames[0], sizeof(LSpriteFrame), mParsedFrames.size()) == mParsedFrames.size()
+        && SDL_RWwrite(file, mParsedNames.data(), mParsedNames.size(), 1) == 1;
+    SDL_RWclose(file);
+
+#if !defined(__linux__)
+    // rename does not replace an existing file everywhere, and nothing has the old one mapped here
+    if (written) {
+        remove(path.c_str());
+    }
+#endif
+
+    if (!written || rename(temporary.c_str(), path.c_str()) != 0) {
+        printf("Unable to write sprite sheet cache %s!\n", path.c_str());
+        remove(temporary.c_str());
+    }
+}
+
+int LSpriteSheet::getFrameCount()
+{
+    return mFrameCount;
+}
+
+const LSpriteFrame& LSpriteSheet::getFrame(int index)
+{
+    return mFrames[index];
+}
+
+SDL_Rect* LSpriteSheet::getClip(int index)
+{
+    return &mFrames[index].clip;
+}
+
+const char* LSpriteSheet::getName(int index)
+{
+    return mNames + mFrames[index].nameOffset;
+}
+
+int LSpriteSheet::findFrame(std::string name)
+{
+    for (int i = 0; i < mFrameCount; ++i) {
+        if (name == getName(i)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+int LSpriteSheet::getFrameAt(double milliseconds)
+{
+    if (mTotalDuration <= 0) {
+        return 0;
+    }
+
+    double time = fmod(milliseconds, mTotalDuration);
+    for (int i = 0; i < mFrameCount; ++i) {
+        time -= mFrames[i].duration;
+        if (time < 0) {
+            return i;
+        }
+    }
+
+    return mFrameCount - 1;
+}
+
+bool LSpriteSheet::isFromSidecar()
+{
+    return mMapping != NULL;
+}
+
 bool loadMedia()
 {
     bool success = true;
@@ -173,29 +824,23 @@ bool loadMedia()
         printf("Failed to load sprite sheet texture\n");
         success = false;
     } else {
-        // Set top left sprite
-        gSpriteClips[0].x = 0;
-        gSpriteClips[0].y = 0;
-        gSpriteClips[0].w = 100;
-        gSpriteClips[0].h = 100;
-
-        // Set top right sprite
-        gSpriteClips[1].x = 100;
-        gSpriteClips[1].y = 0;
-        gSpriteClips[1].w = 100;
-        gSpriteClips[1].h = 100;
-
-        // Set bottom left sprite
-        gSpriteClips[2].x = 0;
-        gSpriteClips[2].y = 100;
-        gSpriteClips[2].w = 100;
-        gSpriteClips[2].h = 100;
-
-        // Set bottom right sprite
-        gSpriteClips[3].x = 100;
-        gSpriteClips[3].y = 100;
-        gSpriteClips[3].w = 100;
-        gSpriteClips[3].h = 100;
+        // Clips come from the exported sheet, by name so the packer is free to reorder them
+        const char* clipNames[4] = { "top_left", "top_right", "bottom_left", "bottom_right" };
+
+        if (!gSpriteSheet.loadFromFile("dots.json")) {
+            printf("Failed to load sprite sheet frames!\n");
+            success = false;
+        } else {
+            for (int i = 0; i < 4; ++i) {
+                int frame = gSpriteSheet.findFrame(clipNames[i]);
+                if (frame < 0) {
+                    printf("Sprite sheet has no frame %s!\n", clipNames[i]);
+                    success = false;
+                } else {
+                    gSpriteClips[i] = *gSpriteSheet.getClip(frame);
+                }
+            }
+        }
     }
 
     return success;
@@ -203,6 +848,7 @@ bool loadMedia()
 
 void close()
 {
+    gSpriteSheet.free();
     gSpriteSheetTexture.free();
 
     SDL_DestroyRenderer(gRenderer);
@@ -5,8 +5,20 @@
 #include <SDL2/SDL_render.h>
 #include <SDL2/SDL_surface.h>
 #include <SDL2/SDL_video.h>
+#include <atomic>
+#include <cerrno>
 #include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 480;
@@ -23,6 +35,9 @@ class LTexture
         // Loads image from specified path
         bool loadFromFile(std::string path);
 
+        // Replaces pixels with surface, in place when dimensions match
+        bool updateFromSurface(SDL_Surface* surface);
+
         // Deallocates texture
         void free();
 
@@ -42,6 +57,51 @@ class LTexture
         int mHeight;
 };
 
+class LAssetWatcher
+{
+    public:
+        // Initialize
+        LAssetWatcher();
+
+        // Stops watching
+        ~LAssetWatcher();
+
+        // Reloads texture whenever the file at path changes, call before start
+        void watch(LTexture* texture, std::string path);
+
+        // Starts watching directory on a background thread
+        bool start(std::string directory);
+
+        // Stops the background thread
+        void stop();
+
+        // Uploads finished reloads, call once per frame on the render thread
+        void applyReloads();
+
+    private:
+        // Background thread waiting on inotify and decoding changed files
+        void run();
+
+        // Decodes file into a surface matching the texture format
+        SDL_Surface* decode(std::string path);
+
+        // inotify instance
+        int mInotify;
+
+        // Directory being watched
+        std::string mDirectory;
+
+        // Textures per watched file name, read only once started
+        std::map<std::string, std::vector<LTexture*> > mWatched;
+
+        // Decoded surfaces waiting for upload
+        std::mutex mMutex;
+        std::map<std::string, SDL_Surface*> mDecoded;
+
+        std::thread mThread;
+        std::atomic<bool> mRunning;
+};
+
 bool init();
 
 bool loadMedia();
@@ -55,6 +115,8 @@ SDL_Renderer* gRenderer = NULL;
 LTexture gFooTexture;
 LTexture gBackgroundTexture;
 
+LAssetWatcher gAssetWatcher;
+
 LTexture::LTexture()
 {
     // Initialize
@@ -110,6 +172,49 @@ bool LTexture::loadFromFile(std::string path)
     return mTexture != NULL;
 }
 
+bool LTexture::updateFromSurface(SDL_Surface* surface)
+{
+    // Same dimensions, overwrite the pixels of the existing texture
+    if (mTexture != NULL && surface->w == mWidth && surface->h == mHeight) {
+        Uint32 format;
+        SDL_QueryTexture(mTexture, &format, NULL, NULL, NULL);
+
+        SDL_Surface* converted = surface;
+        if (surface->format->format != format) {
+            converted = SDL_ConvertSurfaceFormat(surface, format, 0);
+            if (converted == NULL) {
+                printf("Unable to convert surface to %s! SDL Error: %s\n", SDL_GetPixelFormatName(format), SDL_GetError());
+                return false;
+            }
+        }
+
+        bool success = true;
+        if (SDL_UpdateTexture(mTexture, NULL, converted->pixels, converted->pitch) < 0) {
+            printf("Unable to update texture! SDL Error: %s\n", SDL_GetError());
+            success = false;
+        }
+
+        if (converted != surface) {
+            SDL_FreeSurface(converted);
+        }
+
+        return success;
+    }
+
+    // Dimensions changed, texture has to be recreated
+    free();
+
+    mTexture = SDL_CreateTextureFromSurface(gRenderer, surface);
+    if (mTexture == NULL) {
+        printf("Unable to create texture from surface! SDL Error: %s\n", SDL_GetError());
+    } else {
+        mWidth = surface->w;
+        mHeight = surface->h;
+    }
+
+    return mTexture != NULL;
+}
+
 void LTexture::render(int x, int y)
 {
     // Set rendering space and render to screen
@@ -127,6 +232,155 @@ int LTexture::getHeight()
     return  mHeight;
 }
 
+LAssetWatcher::LAssetWatcher()
+{
+    mInotify = -1;
+    mRunning = false;
+}
+
+LAssetWatcher::~LAssetWatcher()
+{
+    stop();
+}
+
+void LAssetWatcher::watch(LTexture* texture, std::string path)
+{
+    mWatched[path].push_back(texture);
+}
+
+bool LAssetWatcher::start(std::string directory)
+{
+#if defined(__linux__)
+    mInotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (mInotify < 0) {
+        printf("Unable to start asset watcher! inotify Error: %s\n", strerror(errno));
+        return false;
+    }
+
+    // Editors either rewrite the file or rename a temporary over it
+    if (inotify_add_watch(mInotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        printf("Unable to watch %s! inotify Error: %s\n", directory.c_str(), strerror(errno));
+        close(mInotify);
+        mInotify = -1;
+        return false;
+    }
+
+    mDirectory = directory;
+    mRunning = true;
+    mThread = std::thread(&LAssetWatcher::run, this);
+    return true;
+#else
+    printf("Asset watcher is only supported on Linux!\n");
+    return false;
+#endif
+}
+
+void LAssetWatcher::stop()
+{
+    if (mRunning) {
+        mRunning = false;
+        mThread.join();
+    }
+
+#if defined(__linux__)
+    if (mInotify >= 0) {
+        close(mInotify);
+        mInotify = -1;
+    }
+#endif
+
+    std::map<std::string, SDL_Surface*>::iterator it;
+    for (it = mDecoded.begin(); it != mDecoded.end(); ++it) {
+        SDL_FreeSurface(it->second);
+    }
+    mDecoded.clear();
+}
+
+void LAssetWatcher::run()
+{
+#if defined(__linux__)
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    while (mRunning) {
+        // Wake up regularly to notice stop()
+        pollfd fd = {mInotify, POLLIN, 0};
+        if (poll(&fd, 1, 100) <= 0) {
+            continue;
+        }
+
+        ssize_t length = read(mInotify, buffer, sizeof(buffer));
+        for (char* ptr = buffer; length > 0 && ptr < buffer + length; ) {
+            const struct inotify_event* event = (const struct inotify_event*)ptr;
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->len == 0 || mWatched.find(event->name) == mWatched.end()) {
+                continue;
+            }
+
+            std::string name = event->name;
+            SDL_Surface* surface = decode(mDirectory + "/" + name);
+            if (surface == NULL) {
+                continue;
+            }
+
+            // A newer decode of the same file replaces one not yet uploaded
+            std::lock_guard<std::mutex> lock(mMutex);
+            std::map<std::string, SDL_Surface*>::iterator pending = mDecoded.find(name);
+            if (pending != mDecoded.end()) {
+                SDL_FreeSurface(pending->second);
+                pending->second = surface;
+            } else {
+                mDecoded[name] = surface;
+            }
+        }
+    }
+#endif
+}
+
+SDL_Surface* LAssetWatcher::decode(std::string path)
+{
+    SDL_Surface* loadedSurface = IMG_Load(path.c_str());
+    if (loadedSurface == NULL) {
+        printf("Failed to reload image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
+        return NULL;
+    }
+
+    // Color key image, conversion turns key pixels transparent
+    SDL_SetColorKey(loadedSurface, SDL_TRUE, SDL_MapRGB(loadedSurface->format, 0, 0xFF, 0xFF));
+
+    // Decode straight into the format textures are created with
+    SDL_Surface* formattedSurface = SDL_ConvertSurfaceFormat(loadedSurface, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (formattedSurface == NULL) {
+        printf("Failed to convert image %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+    }
+
+    SDL_FreeSurface(loadedSurface);
+    return formattedSurface;
+}
+
+void LAssetWatcher::applyReloads()
+{
+    std::map<std::string, SDL_Surface*> decoded;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        decoded.swap(mDecoded);
+    }
+
+    std::map<std::string, SDL_Surface*>::iterator it;
+    for (it = decoded.begin(); it != decoded.end(); ++it) {
+        // Lookup only, the watcher thread reads the map concurrently
+        std::vector<LTexture*>& textures = mWatched.find(it->first)->second;
+        for (size_t i = 0; i < textures.size(); ++i) {
+            if (!textures[i]->updateFromSurface(it->second)) {
+                printf("Failed to reload %s!\n", it->first.c_str());
+            }
+        }
+
+        printf("Reloaded %s\n", it->first.c_str());
+        SDL_FreeSurface(it->second);
+    }
+}
+
 bool init()
 {
     bool success = true;
@@ -168,18 +422,28 @@ bool loadMedia()
         printf("Failed to load Foo' texture image!\n");
         success = false;
     }
+    else
+    {
+        gAssetWatcher.watch(&gFooTexture, "foo.png");
+    }
 
     if (!gBackgroundTexture.loadFromFile("background.png"))
     {
         printf("Failed to load background texture image!\n");
         success = false;
     }
+    else
+    {
+        gAssetWatcher.watch(&gBackgroundTexture, "background.png");
+    }
 
     return success;
 }
 
 void close()
 {
+    gAssetWatcher.stop();
+
     gFooTexture.free();
     gBackgroundTexture.free();
 
@@ -204,6 +468,8 @@ int main (int argc, char *argv[])
 
             SDL_Event e;
 
+            gAssetWatcher.start(".");
+
             while (!quit) {
                 while (SDL_PollEvent(&e) != 0) {
                     if (e.type == SDL_QUIT) {
@@ -211,6 +477,9 @@ int main (int argc, char *argv[])
                     }
                 }
 
+                // Upload assets changed on disk
+                gAssetWatcher.applyReloads();
+
                 // Clear screen
                 SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
                 SDL_RenderClear(gRenderer);
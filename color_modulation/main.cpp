@@ -6,7 +6,17 @@
 #include <SDL2/SDL_surface.h>
 #include <SDL2/SDL_video.h>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 480;
@@ -45,18 +55,124 @@ class LTexture
         int mHeight;
 };
 
+// Colors in an indexed sprite palette
+const int PALETTE_SIZE = 256;
+
+// Recolored variants in the palette benchmark
+const int PALETTE_VARIANTS = 1000;
+
+struct LPalette
+{
+    Uint32 colors[PALETTE_SIZE];
+};
+
+class LIndexedSprite
+{
+    public:
+        // Initialize
+        LIndexedSprite();
+
+        // Deallocate
+        ~LIndexedSprite();
+
+        // Load image at specified path, reducing it to at most 256 colors
+        bool loadFromFile(std::string path);
+
+        // Deallocates indices and texture
+        void free();
+
+        // Palette the image was loaded with
+        const LPalette& getPalette();
+
+        // Expands indices through palette into ARGB8888 pixels
+        void expand(const LPalette& palette, Uint32* pixels, int pitch);
+
+        // Renders sprite with given palette at given point
+        void render(int x, int y, const LPalette& palette);
+
+        // Gets image dimensions
+        int getWidth();
+        int getHeight();
+
+        // Bytes held per sprite, the texture is shared by every palette
+        size_t getIndexBytes();
+        size_t getTextureBytes();
+
+    private:
+        // One palette index per pixel
+        std::vector<Uint8> mIndices;
+
+        LPalette mPalette;
+
+        // Streaming texture the current palette was expanded into
+        SDL_Texture* mTexture;
+        LPalette mUploadedPalette;
+        bool mUploaded;
+
+        // Image dimensions
+        int mWidth;
+        int mHeight;
+};
+
 bool init();
 
 bool loadMedia();
 
 void close();
 
+// Draws the texture with given color modulation
+void renderFrame(Uint8 r, Uint8 g, Uint8 b);
+
+// Looks up count palette indices into ARGB8888 colors
+void expandIndices(const Uint8* indices, const Uint32* palette, Uint32* colors, int count);
+
+// Rotates red, green and blue of every color by rotation then multiplies them
+void recolorPalette(const LPalette& source, Uint8 r, Uint8 g, Uint8 b, int rotation, LPalette* recolored);
+
+// Draws the indexed sprite with a recolored palette
+void renderIndexedFrame(Uint8 r, Uint8 g, Uint8 b, int rotation);
+
+// Compares memory and speed of recolored indexed sprites against full textures
+void runPaletteBenchmark();
+
+// Largest per channel difference still treated as equal
+const Uint8 GOLDEN_TOLERANCE = 2;
+
+// Frames from this many pixels up are diffed on several threads
+const int GOLDEN_PARALLEL_PIXELS = 1 << 20;
+
+// Creates a software renderer on an offscreen surface, no display needed
+bool initHeadless();
+
+// Reads back the rendered frame as ARGB8888
+SDL_Surface* captureFrame();
+
+// Counts pixels with any channel differing by more than tolerance
+int diffPixels(const Uint32* a, const Uint32* b, int count, Uint8 tolerance);
+
+// Counts mismatching pixels of two equally sized ARGB8888 surfaces
+int diffSurfaces(SDL_Surface* a, SDL_Surface* b, Uint8 tolerance);
+
+// Writes heatmap of per pixel differences to path
+bool saveDiffHeatmap(SDL_Surface* frame, SDL_Surface* golden, std::string path);
+
+// Captures frame into path, or compares it against path when compare is set
+bool runGolden(std::string path, bool compare);
+
+// Times diffing two 4K frames
+void runDiffBenchmark();
+
 SDL_Window* gWindow = NULL;
 
 SDL_Renderer* gRenderer = NULL;
 
+// Offscreen target of the headless renderer
+SDL_Surface* gCaptureSurface = NULL;
+
 LTexture gModulatedTexture;
 
+LIndexedSprite gIndexedSprite;
+
 LTexture::LTexture()
 {
     // Initialize
@@ -87,6 +203,9 @@ void LTexture::setColor(Uint8 red, Uint8 green, Uint8 blue)
 
 bool LTexture::loadFromFile(std::string path)
 {
+    // Get rid of preexisting texture
+    free();
+
     SDL_Texture* newTexture = NULL;
 
     SDL_Surface* loadedSurface = IMG_Load(path.c_str());
@@ -124,6 +243,201 @@ int LTexture::getHeight()
     return mHeight;
 }
 
+LIndexedSprite::LIndexedSprite()
+{
+    mTexture = NULL;
+    mUploaded = false;
+    mWidth = 0;
+    mHeight = 0;
+    memset(&mPalette, 0, sizeof(mPalette));
+}
+
+LIndexedSprite::~LIndexedSprite()
+{
+    free();
+}
+
+void LIndexedSprite::free()
+{
+    if (mTexture != NULL) {
+        SDL_DestroyTexture(mTexture);
+        mTexture = NULL;
+    }
+
+    mIndices.clear();
+    mUploaded = false;
+    mWidth = 0;
+    mHeight = 0;
+}
+
+bool LIndexedSprite::loadFromFile(std::string path)
+{
+    free();
+
+    SDL_Surface* loadedSurface = IMG_Load(path.c_str());
+    if (loadedSurface == NULL) {
+        printf("Failed to load image from %s! SDL_Image Error: %s\n", path.c_str(), IMG_GetError());
+        return false;
+    }
+
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(loadedSurface, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(loadedSurface);
+    if (converted == NULL) {
+        printf("Unable to convert %s to ARGB8888! SDL Error: %s\n", path.c_str(), SDL_GetError());
+        return false;
+    }
+
+    mTexture = SDL_CreateTexture(gRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, converted->w, converted->h);
+    if (mTexture == NULL) {
+        printf("Unable to create streaming texture for %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+        SDL_FreeSurface(converted);
+        return false;
+    }
+    SDL_SetTextureBlendMode(mTexture, SDL_BLENDMODE_BLEND);
+
+    mWidth = converted->w;
+    mHeight = converted->h;
+    mIndices.resize((size_t)mWidth * mHeight);
+
+    // Drop low bits of every channel until the colors fit the palette
+    bool fits = false;
+    int dropped = 0;
+    for (; dropped <= 8 && !fits; ++dropped) {
+        Uint32 channelMask = (0xFF << dropped) & 0xFF;
+        Uint32 mask = channelMask * 0x01010101;
+        Uint32 half = dropped > 0 ? (1 << (dropped - 1)) * 0x01010101 : 0;
+
+        std::unordered_map<Uint32, Uint8> lookup;
+        int colorCount = 0;
+        fits = true;
+
+        for (int y = 0; y < mHeight && fits; ++y) {
+            const Uint32* row = (const Uint32*)((const Uint8*)converted->pixels + y * converted->pitch);
+            for (int x = 0; x < mWidth; ++x) {
+                Uint32 color = row[x] & mask;
+
+                std::unordered_map<Uint32, Uint8>::iterator found = lookup.find(color);
+                if (found != lookup.end()) {
+                    mIndices[y * mWidth + x] = found->second;
+                } else if (colorCount == PALETTE_SIZE) {
+                    fits = false;
+                    break;
+                } else {
+                    // Centered in the range of colors that were merged
+                    mPalette.colors[colorCount] = color | half;
+                    lookup[color] = (Uint8)colorCount;
+                    mIndices[y * mWidth + x] = (Uint8)colorCount++;
+                }
+            }
+        }
+
+        for (int i = colorCount; fits && i < PALETTE_SIZE; ++i) {
+            mPalette.colors[i] = 0;
+        }
+    }
+
+    if (dropped > 1) {
+        printf("Reduced %s to %d bits per channel to fit %d colors\n", path.c_str(), 8 - (dropped - 1), PALETTE_SIZE);
+    }
+
+    SDL_FreeSurface(converted);
+    return true;
+}
+
+const LPalette& LIndexedSprite::getPalette()
+{
+    return mPalette;
+}
+
+void LIndexedSprite::expand(const LPalette& palette, Uint32* pixels, int pitch)
+{
+    for (int y = 0; y < mHeight; ++y) {
+        expandIndices(&mIndices[y * mWidth], palette.colors, (Uint32*)((Uint8*)pixels + y * pitch), mWidth);
+    }
+}
+
+void LIndexedSprite::render(int x, int y, const LPalette& palette)
+{
+    // Only a different palette needs expanding again
+    if (!mUploaded || memcmp(&mUploadedPalette, &palette, sizeof(LPalette)) != 0) {
+        void* pixels;
+        int pitch;
+        if (SDL_LockTexture(mTexture, NULL, &pixels, &pitch) < 0) {
+            printf("Unable to lock palette texture! SDL Error: %s\n", SDL_GetError());
+            return;
+        }
+
+        expand(palette, (Uint32*)pixels, pitch);
+        SDL_UnlockTexture(mTexture);
+
+        mUploadedPalette = palette;
+        mUploaded = true;
+    }
+
+    SDL_Rect renderQuad = {x, y, mWidth, mHeight};
+    SDL_RenderCopy(gRenderer, mTexture, NULL, &renderQuad);
+}
+
+int LIndexedSprite::getWidth()
+{
+    return mWidth;
+}
+
+int LIndexedSprite::getHeight()
+{
+    return mHeight;
+}
+
+size_t LIndexedSprite::getIndexBytes()
+{
+    return mIndices.size() + sizeof(LPalette);
+}
+
+size_t LIndexedSprite::getTextureBytes()
+{
+    return (size_t)mWidth * mHeight * 4;
+}
+
+void expandIndices(const Uint8* indices, const Uint32* palette, Uint32* colors, int count)
+{
+    int i = 0;
+
+#if defined(__AVX2__)
+    // Eight indices widened to 32 bits fetch their colors in one gather
+    for (; i + 8 <= count; i += 8) {
+        __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(indices + i)));
+        _mm256_storeu_si256((__m256i*)(colors + i), _mm256_i32gather_epi32((const int*)palette, index, 4));
+    }
+#elif defined(__SSE2__)
+    // Four lookups per store, the table stays in L1
+    for (; i + 4 <= count; i += 4) {
+        __m128i color = _mm_setr_epi32((int)palette[indices[i]], (int)palette[indices[i + 1]], (int)palette[indices[i + 2]], (int)palette[indices[i + 3]]);
+        _mm_storeu_si128((__m128i*)(colors + i), color);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        colors[i] = palette[indices[i]];
+    }
+}
+
+void recolorPalette(const LPalette& source, Uint8 r, Uint8 g, Uint8 b, int rotation, LPalette* recolored)
+{
+    const Uint8 mods[3] = {b, g, r};
+
+    for (int i = 0; i < PALETTE_SIZE; ++i) {
+        Uint32 color = source.colors[i];
+        Uint32 channels[3] = {color & 0xFF, (color >> 8) & 0xFF, (color >> 16) & 0xFF};
+
+        Uint32 result = color & 0xFF000000;
+        for (int c = 0; c < 3; ++c) {
+            result |= (channels[(c + rotation) % 3] * mods[c] / 255) << (c * 8);
+        }
+
+        recolored->colors[i] = result;
+    }
+}
+
 bool init()
 {
     bool success = true;
@@ -153,6 +467,327 @@ bool init()
     return success;
 }
 
+bool initHeadless()
+{
+    bool success = true;
+
+    gCaptureSurface = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (gCaptureSurface == NULL) {
+        printf("Failed to create capture surface! SDL Error: %s\n", SDL_GetError());
+        success = false;
+    } else {
+        gRenderer = SDL_CreateSoftwareRenderer(gCaptureSurface);
+        if (gRenderer == NULL) {
+            printf("Failed to create software renderer! SDL Error: %s\n", SDL_GetError());
+            success = false;
+        } else {
+            SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+
+            int imgFlag = IMG_INIT_PNG;
+            if (!(IMG_Init(imgFlag) & imgFlag)) {
+                printf("SDL_Image failed to initialize! SDL_Image Error: %s\n", IMG_GetError());
+                success = false;
+            }
+        }
+    }
+
+    return success;
+}
+
+SDL_Surface* captureFrame()
+{
+    SDL_Surface* frame = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (frame == NULL) {
+        printf("Failed to create frame surface! SDL Error: %s\n", SDL_GetError());
+        return NULL;
+    }
+
+    if (SDL_RenderReadPixels(gRenderer, NULL, SDL_PIXELFORMAT_ARGB8888, frame->pixels, frame->pitch) < 0) {
+        printf("Failed to read back frame! SDL Error: %s\n", SDL_GetError());
+        SDL_FreeSurface(frame);
+        return NULL;
+    }
+
+    return frame;
+}
+
+int diffPixels(const Uint32* a, const Uint32* b, int count, Uint8 tolerance)
+{
+    int matches = 0;
+    int i = 0;
+
+    // |a - b| per byte from two saturating subtractions, then anything
+    // left after subtracting tolerance is a mismatching channel
+#if defined(__AVX2__)
+    const __m256i tol = _mm256_set1_epi8((char)tolerance);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i matched = _mm256_setzero_si256();
+    for (; i + 8 <= count; i += 8) {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i diff = _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va));
+        __m256i over = _mm256_subs_epu8(diff, tol);
+        matched = _mm256_sub_epi32(matched, _mm256_cmpeq_epi32(over, zero));
+    }
+
+    Uint32 lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, matched);
+    for (int lane = 0; lane < 8; ++lane) {
+        matches += lanes[lane];
+    }
+#elif defined(__SSE2__)
+    const __m128i tol = _mm_set1_epi8((char)tolerance);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i matched = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i diff = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+        __m128i over = _mm_subs_epu8(diff, tol);
+        matched = _mm_sub_epi32(matched, _mm_cmpeq_epi32(over, zero));
+    }
+
+    Uint32 lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, matched);
+    for (int lane = 0; lane < 4; ++lane) {
+        matches += lanes[lane];
+    }
+#endif
+
+    for (; i < count; ++i) {
+        bool match = true;
+        for (int shift = 0; shift < 32; shift += 8) {
+            int ca = (a[i] >> shift) & 0xFF;
+            int cb = (b[i] >> shift) & 0xFF;
+            if (ca - cb > tolerance || cb - ca > tolerance) {
+                match = false;
+            }
+        }
+
+        if (match) {
+            ++matches;
+        }
+    }
+
+    return count - matches;
+}
+
+int diffSurfaces(SDL_Surface* a, SDL_Surface* b, Uint8 tolerance)
+{
+    int threadCount = 1;
+    if (a->w * a->h >= GOLDEN_PARALLEL_PIXELS) {
+        threadCount = SDL_max(1, SDL_GetCPUCount());
+    }
+
+    // Each thread diffs a band of rows
+    std::vector<int> mismatches(threadCount, 0);
+    std::vector<std::thread> threads;
+    int rowsPerThread = (a->h + threadCount - 1) / threadCount;
+
+    for (int t = 0; t < threadCount; ++t) {
+        int first = t * rowsPerThread;
+        int last = SDL_min(a->h, first + rowsPerThread);
+
+        auto band = [=, &mismatches]() {
+            for (int y = first; y < last; ++y) {
+                const Uint32* rowA = (const Uint32*)((const Uint8*)a->pixels + y * a->pitch);
+                const Uint32* rowB = (const Uint32*)((const Uint8*)b->pixels + y * b->pitch);
+                mismatches[t] += diffPixels(rowA, rowB, a->w, tolerance);
+            }
+        };
+
+        if (t == threadCount - 1) {
+            band();
+        } else {
+            threads.push_back(std::thread(band));
+        }
+    }
+
+    int total = 0;
+    for (size_t t = 0; t < threads.size(); ++t) {
+        threads[t].join();
+    }
+    for (int t = 0; t < threadCount; ++t) {
+        total += mismatches[t];
+    }
+
+    return total;
+}
+
+bool saveDiffHeatmap(SDL_Surface* frame, SDL_Surface* golden, std::string path)
+{
+    SDL_Surface* heatmap = SDL_CreateRGBSurfaceWithFormat(0, frame->w, frame->h, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (heatmap == NULL) {
+        printf("Failed to create heatmap surface! SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+
+    // Matching pixels show as a faint copy of the golden, mismatches in red by severity
+    for (int y = 0; y < frame->h; ++y) {
+        const Uint32* rowFrame = (const Uint32*)((const Uint8*)frame->pixels + y * frame->pitch);
+        const Uint32* rowGolden = (const Uint32*)((const Uint8*)golden->pixels + y * golden->pitch);
+        Uint32* rowHeat = (Uint32*)((Uint8*)heatmap->pixels + y * heatmap->pitch);
+
+        for (int x = 0; x < frame->w; ++x) {
+            int maxDiff = 0;
+            int luma = 0;
+            for (int shift = 0; shift < 32; shift += 8) {
+                int ca = (rowFrame[x] >> shift) & 0xFF;
+                int cb = (rowGolden[x] >> shift) & 0xFF;
+                maxDiff = SDL_max(maxDiff, ca > cb ? ca - cb : cb - ca);
+                luma += cb;
+            }
+
+            if (maxDiff > GOLDEN_TOLERANCE) {
+                Uint32 red = 0x80 + maxDiff / 2;
+                rowHeat[x] = 0xFF000000 | (red << 16);
+            } else {
+                Uint32 gray = luma / 16;
+                rowHeat[x] = 0xFF000000 | (gray << 16) | (gray << 8) | gray;
+            }
+        }
+    }
+
+    bool success = true;
+    if (IMG_SavePNG(heatmap, path.c_str()) < 0) {
+        printf("Failed to save heatmap %s! SDL_Image Error: %s\n", path.c_str(), IMG_GetError());
+        success = false;
+    }
+
+    SDL_FreeSurface(heatmap);
+    return success;
+}
+
+bool runGolden(std::string path, bool compare)
+{
+    SDL_Surface* frame = captureFrame();
+    if (frame == NULL) {
+        return false;
+    }
+
+    bool success = true;
+
+    if (!compare) {
+        if (IMG_SavePNG(frame, path.c_str()) < 0) {
+            printf("Failed to save golden image %s! SDL_Image Error: %s\n", path.c_str(), IMG_GetError());
+            success = false;
+        } else {
+            printf("Captured %s\n", path.c_str());
+        }
+    } else {
+        SDL_Surface* loadedSurface = IMG_Load(path.c_str());
+        SDL_Surface* golden = NULL;
+        if (loadedSurface == NULL) {
+            printf("Failed to load golden image %s! SDL_Image Error: %s\n", path.c_str(), IMG_GetError());
+        } else {
+            golden = SDL_ConvertSurfaceFormat(loadedSurface, SDL_PIXELFORMAT_ARGB8888, 0);
+            SDL_FreeSurface(loadedSurface);
+        }
+
+        if (golden == NULL) {
+            success = false;
+        } else if (golden->w != frame->w || golden->h != frame->h) {
+            printf("Golden image %s is %dx%d, frame is %dx%d!\n", path.c_str(), golden->w, golden->h, frame->w, frame->h);
+            success = false;
+        } else {
+            Uint64 start = SDL_GetPerformanceCounter();
+            int mismatches = diffSurfaces(frame, golden, GOLDEN_TOLERANCE);
+            double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+            printf("Compared against %s in %.3f ms, %d pixels over tolerance\n", path.c_str(), ms, mismatches);
+            if (mismatches > 0) {
+                saveDiffHeatmap(frame, golden, path + ".diff.png");
+                success = false;
+            }
+        }
+
+        SDL_FreeSurface(golden);
+    }
+
+    SDL_FreeSurface(frame);
+    return success;
+}
+
+void runDiffBenchmark()
+{
+    const int width = 3840;
+    const int height = 2160;
+    const int runs = 20;
+
+    SDL_Surface* a = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Surface* b = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (a == NULL || b == NULL) {
+        printf("Failed to create benchmark surfaces! SDL Error: %s\n", SDL_GetError());
+    } else {
+        SDL_FillRect(a, NULL, 0xFF808080);
+        SDL_FillRect(b, NULL, 0xFF818081);
+
+        // Warm up caches and thread startup once
+        diffSurfaces(a, b, GOLDEN_TOLERANCE);
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        int mismatches = 0;
+        for (int i = 0; i < runs; ++i) {
+            mismatches = diffSurfaces(a, b, GOLDEN_TOLERANCE);
+        }
+        double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency() / runs;
+
+        printf("Diffed %dx%d frames in %.3f ms, %d pixels over tolerance\n", width, height, ms, mismatches);
+    }
+
+    SDL_FreeSurface(a);
+    SDL_FreeSurface(b);
+}
+
+void runPaletteBenchmark()
+{
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    int width = gIndexedSprite.getWidth();
+    int height = gIndexedSprite.getHeight();
+
+    // A tinted full color texture per variant against shared indices and a palette each
+    size_t fullBytes = (size_t)PALETTE_VARIANTS * gIndexedSprite.getTextureBytes();
+    size_t indexedBytes = gIndexedSprite.getIndexBytes() + gIndexedSprite.getTextureBytes() + (size_t)PALETTE_VARIANTS * sizeof(LPalette);
+    printf("%d variants of %dx%d: %.1f MB as textures, %.1f MB indexed (%.1fx less)\n",
+        PALETTE_VARIANTS, width, height, fullBytes / 1048576.0, indexedBytes / 1048576.0, (double)fullBytes / indexedBytes);
+
+    std::vector<LPalette> palettes(PALETTE_VARIANTS);
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < PALETTE_VARIANTS; ++i) {
+        recolorPalette(gIndexedSprite.getPalette(), (Uint8)(i * 37), (Uint8)(i * 91), (Uint8)(i * 13), i % 3, &palettes[i]);
+    }
+    double swapUs = (SDL_GetPerformanceCounter() - start) * 1000000.0 / frequency / PALETTE_VARIANTS;
+
+    // Expansion alone, into memory
+    std::vector<Uint32> pixels((size_t)width * height);
+    start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < PALETTE_VARIANTS; ++i) {
+        gIndexedSprite.expand(palettes[i], &pixels[0], width * 4);
+    }
+    double expandSeconds = (SDL_GetPerformanceCounter() - start) / frequency;
+    double megapixels = (double)PALETTE_VARIANTS * width * height / 1000000.0;
+
+    // Every variant expanded, uploaded and drawn
+    start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < PALETTE_VARIANTS; ++i) {
+        gIndexedSprite.render(0, 0, palettes[i]);
+    }
+    SDL_RenderFlush(gRenderer);
+    double indexedMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency / PALETTE_VARIANTS;
+
+    // Color modulation of one full color texture for comparison
+    start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < PALETTE_VARIANTS; ++i) {
+        gModulatedTexture.setColor((Uint8)(i * 37), (Uint8)(i * 91), (Uint8)(i * 13));
+        gModulatedTexture.render(0, 0);
+    }
+    SDL_RenderFlush(gRenderer);
+    double modulatedMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency / PALETTE_VARIANTS;
+
+    printf("Palette swap %.2f us, expansion %.0f Mpixels/s\n", swapUs, megapixels / expandSeconds);
+    printf("Draw per variant: %.3f ms indexed, %.3f ms color modulated\n", indexedMs, modulatedMs);
+}
+
 bool loadMedia()
 {
     bool success = true;
@@ -161,29 +796,87 @@ bool loadMedia()
         success = false;
     }
 
+    if (!gIndexedSprite.loadFromFile("colors.png")) {
+        printf("Failed to load indexed colors sprite!\n");
+        success = false;
+    }
+
     return success;
 }
 
 void close()
 {
     gModulatedTexture.free();
+    gIndexedSprite.free();
 
     SDL_DestroyRenderer(gRenderer);
     SDL_DestroyWindow(gWindow);
+    SDL_FreeSurface(gCaptureSurface);
     gWindow = NULL;
     gRenderer = NULL;
+    gCaptureSurface = NULL;
 
     IMG_Quit();
     SDL_Quit();
 }
 
+void renderFrame(Uint8 r, Uint8 g, Uint8 b)
+{
+    // Clear screen
+    SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+    SDL_RenderClear(gRenderer);
+
+    // Modulate and render texture
+    gModulatedTexture.setColor(r, g, b);
+    gModulatedTexture.render(0, 0);
+}
+
+void renderIndexedFrame(Uint8 r, Uint8 g, Uint8 b, int rotation)
+{
+    SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+    SDL_RenderClear(gRenderer);
+
+    // Recoloring only rewrites 256 palette entries
+    LPalette palette;
+    recolorPalette(gIndexedSprite.getPalette(), r, g, b, rotation, &palette);
+    gIndexedSprite.render(0, 0, palette);
+}
 
 int main (int argc, char *argv[]) {
-    if (!init()) {
+    // --capture <png> [r g b] or --compare <png> [r g b] render one frame
+    // offscreen, --bench-diff times the image differ, --bench-palette
+    // compares recolored indexed sprites against full color textures
+    std::string mode = argc > 1 ? argv[1] : "";
+    bool golden = mode == "--capture" || mode == "--compare";
+    bool headless = golden || mode == "--bench-palette";
+    bool passed = true;
+
+    if (mode == "--bench-diff") {
+        runDiffBenchmark();
+        return 0;
+    }
+
+    if (golden && argc < 3) {
+        printf("Usage: %s %s <png> [r g b]\n", argv[0], mode.c_str());
+        return 1;
+    }
+
+    if (!(headless ? initHeadless() : init())) {
         printf("Failed to initialize!\n");
+        passed = false;
     } else {
         if (!loadMedia()) {
             printf("Failed to load media!\n");
+            passed = false;
+        } else if (mode == "--bench-palette") {
+            runPaletteBenchmark();
+        } else if (headless) {
+            Uint8 r = argc > 5 ? (Uint8)atoi(argv[3]) : 255;
+            Uint8 g = argc > 5 ? (Uint8)atoi(argv[4]) : 255;
+            Uint8 b = argc > 5 ? (Uint8)atoi(argv[5]) : 255;
+
+            renderFrame(r, g, b);
+            passed = runGolden(argv[2], mode == "--compare");
         } else {
             bool quit = false;
 
@@ -193,11 +886,15 @@ int main (int argc, char *argv[]) {
             Uint8 g = 255;
             Uint8 b = 255;
 
+            // Recolor through the palette of the indexed sprite instead
+            bool indexed = false;
+            int rotation = 0;
+
             while (!quit) {
                 while (SDL_PollEvent(&e) != 0) {
                     if (e.type == SDL_QUIT) {
                         quit = true;
-                    } else if (e.key.keysym.sym) {
+                    } else if (e.type == SDL_KEYDOWN) {
                         switch (e.key.keysym.sym) {
                             // Increase red
                             case SDLK_q:
@@ -228,17 +925,25 @@ int main (int argc, char *argv[]) {
                             case SDLK_d:
                             b -= 32;
                             break;
+
+                            // Toggle indexed sprite
+                            case SDLK_p:
+                            indexed = !indexed;
+                            break;
+
+                            // Rotate color channels of the palette
+                            case SDLK_c:
+                            rotation = (rotation + 1) % 3;
+                            break;
                         }
                     }
                 }
 
-                // Clear screen
-                SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
-                SDL_RenderClear(gRenderer);
-
-                // Modulate and render texture
-                gModulatedTexture.setColor(r, g, b);
-                gModulatedTexture.render(0, 0);
+                if (indexed) {
+                    renderIndexedFrame(r, g, b, rotation);
+                } else {
+                    renderFrame(r, g, b);
+                }
 
                 // Update screen
                 SDL_RenderPresent(gRenderer);
@@ -248,5 +953,5 @@ int main (int argc, char *argv[]) {
 
     close();
 
-    return 0;
+    return passed ? 0 : 1;
 }
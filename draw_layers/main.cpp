@@ -0,0 +1,661 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_blendmode.h>
+#include <SDL2/SDL_error.h>
+#include <SDL2/SDL_events.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_rect.h>
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_surface.h>
+#include <SDL2/SDL_video.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+const int SCREEN_WIDTH = 640;
+const int SCREEN_HEIGHT = 480;
+
+// Draw key layout, most significant first: layer, depth, texture id, blend mode, unused
+const int DRAW_KEY_LAYER_SHIFT = 56;
+const int DRAW_KEY_DEPTH_SHIFT = 32;
+const int DRAW_KEY_TEXTURE_SHIFT = 16;
+const int DRAW_KEY_BLEND_SHIFT = 8;
+const Uint32 DRAW_KEY_DEPTH_MASK = 0xFFFFFF;
+
+// Layers of the demo scene
+const Uint8 LAYER_SHADOWS = 0;
+const Uint8 LAYER_SPRITES = 1;
+
+// Sprites in the demo scene and their size on screen
+const int TOTAL_SPRITES = 20000;
+const int SPRITE_SIZE = 16;
+
+// Keys sorted per frame by the benchmark and frames timed
+const int BENCHMARK_KEYS = 1000000;
+const int BENCHMARK_FRAMES = 10;
+
+class LTexture
+{
+    public:
+        // Initialize
+        LTexture();
+
+        // Deallocate
+        ~LTexture();
+
+        // Load image at specified path
+        bool loadFromFile(std::string path);
+
+        // Creates texture from surface, the surface is left to the caller
+        bool loadFromSurface(SDL_Surface* surface);
+
+        // Deallocate texture
+        void free();
+
+        // Gets the hardware texture for batching
+        SDL_Texture* getTexture();
+
+        // Gets image dimensions
+        int getWidth();
+        int getHeight();
+
+    private:
+        // The actual hardware texture
+        SDL_Texture* mTexture;
+
+        // Image dimensions
+        int mWidth;
+        int mHeight;
+};
+
+// Draws submitted in any order, ordered by 64 bit keys and drawn as geometry batches
+class LDrawList
+{
+    public:
+        // Initialize
+        LDrawList();
+
+        // Registers texture, returns its id in draw keys
+        Uint16 addTexture(LTexture* texture);
+
+        // Queues clip of texture drawn to quad, by layer, then depth, then texture and blending
+        void submit(Uint8 layer, Uint32 depth, Uint16 texture, SDL_BlendMode blending, const SDL_Rect& clip, const SDL_FRect& quad, SDL_Color color);
+
+        // Orders queued draws by key
+        void sort();
+
+        // Sorts unless already sorted, draws queued quads with one SDL_RenderGeometry per run of texture and blending, then empties the list
+        void flush(SDL_Renderer* renderer);
+
+        // Gets draws queued
+        int getCount();
+
+        // Gets SDL_RenderGeometry calls of the last flush
+        int getBatchCount();
+
+        // Packs a draw key, only the standard blend modes fit
+        static Uint64 makeKey(Uint8 layer, Uint32 depth, Uint16 texture, SDL_BlendMode blending);
+
+    private:
+        struct DrawCommand
+        {
+            SDL_Rect clip;
+            SDL_FRect quad;
+            SDL_Color color;
+        };
+
+        // Textures by id
+        std::vector<LTexture*> mTextures;
+
+        std::vector<DrawCommand> mCommands;
+
+        // Key and command index of each draw, with scratch space for the sort
+        std::vector<Uint64> mKeys;
+        std::vector<Uint32> mIndices;
+        std::vector<Uint64> mScratchKeys;
+        std::vector<Uint32> mScratchIndices;
+
+        // Whether keys are in order since the last submit
+        bool mSorted;
+
+        // Geometry of the batch being built
+        std::vector<SDL_Vertex> mVertices;
+        std::vector<int> mVertexIndices;
+
+        int mBatchCount;
+};
+
+// Sprite walking around the screen
+struct Sprite
+{
+    float x;
+    float y;
+    float vx;
+    float vy;
+    int clip;
+};
+
+bool init();
+
+bool loadMedia();
+
+void close();
+
+// Sorts keys ascending with an LSD radix sort on bytes, moving values along, stable.
+// Uses scratch arrays of count elements, bytes equal across all keys cost no pass.
+// Returns the number of scatter passes
+int radixSort(Uint64* keys, Uint32* values, Uint64* scratchKeys, Uint32* scratchValues, size_t count);
+
+// Creates a soft round shadow
+SDL_Surface* createShadowSurface(int size);
+
+// Moves sprites and queues them with their shadows
+void submitScene(LDrawList& list);
+
+// Times radix sorting 1M random keys against std::sort
+void runSortBenchmark();
+
+SDL_Window* gWindow = NULL;
+
+SDL_Renderer* gRenderer = NULL;
+
+LTexture gDotsTexture;
+LTexture gShadowTexture;
+
+SDL_Rect gSpriteClips[4];
+
+LDrawList gDrawList;
+Uint16 gDotsId = 0;
+Uint16 gShadowId = 0;
+
+std::vector<Sprite> gSprites;
+
+LTexture::LTexture()
+{
+    mTexture = NULL;
+    mWidth = 0;
+    mHeight = 0;
+}
+
+LTexture::~LTexture()
+{
+    free();
+}
+
+void LTexture::free()
+{
+    if (mTexture != NULL) {
+        SDL_DestroyTexture(mTexture);
+        mTexture = NULL;
+        mWidth = 0;
+        mHeight = 0;
+    }
+}
+
+bool LTexture::loadFromFile(std::string path)
+{
+    free();
+
+    SDL_Surface* loadedSurface = IMG_Load(path.c_str());
+    if (loadedSurface == NULL) {
+        printf("Unable to load image %s! SDL_Image Error: %s\n", path.c_str(), IMG_GetError());
+        return false;
+    }
+
+    SDL_SetColorKey(loadedSurface, SDL_TRUE, SDL_MapRGB(loadedSurface->format, 0, 0xFF, 0xFF));
+    bool success = loadFromSurface(loadedSurface);
+    SDL_FreeSurface(loadedSurface);
+
+    return success;
+}
+
+bool LTexture::loadFromSurface(SDL_Surface* surface)
+{
+    free();
+
+    mTexture = SDL_CreateTextureFromSurface(gRenderer, surface);
+    if (mTexture == NULL) {
+        printf("Unable to create texture! SDL Error: %s\n", SDL_GetError());
+    } else {
+        mWidth = surface->w;
+        mHeight = surface->h;
+    }
+
+    return mTexture != NULL;
+}
+
+SDL_Texture* LTexture::getTexture()
+{
+    return mTexture;
+}
+
+int LTexture::getWidth()
+{
+    return mWidth;
+}
+
+int LTexture::getHeight()
+{
+    return mHeight;
+}
+
+LDrawList::LDrawList()
+{
+    mSorted = true;
+    mBatchCount = 0;
+}
+
+Uint16 LDrawList::addTexture(LTexture* texture)
+{
+    mTextures.push_back(texture);
+    return (Uint16)(mTextures.size() - 1);
+}
+
+Uint64 LDrawList::makeKey(Uint8 layer, Uint32 depth, Uint16 texture, SDL_BlendMode blending)
+{
+    return (Uint64)layer << DRAW_KEY_LAYER_SHIFT
+        | (Uint64)(depth & DRAW_KEY_DEPTH_MASK) << DRAW_KEY_DEPTH_SHIFT
+        | (Uint64)texture << DRAW_KEY_TEXTURE_SHIFT
+        | (Uint64)(blending & 0xFF) << DRAW_KEY_BLEND_SHIFT;
+}
+
+void LDrawList::submit(Uint8 layer, Uint32 depth, Uint16 texture, SDL_BlendMode blending, const SDL_Rect& clip, const SDL_FRect& quad, SDL_Color color)
+{
+    DrawCommand command = {clip, quad, color};
+
+    mKeys.push_back(makeKey(layer, depth, texture, blending));
+    mIndices.push_back((Uint32)mCommands.size());
+    mCommands.push_back(command);
+    mSorted = false;
+}
+
+void LDrawList::sort()
+{
+    // Scratch only ever grows, so steady frames allocate nothing
+    if (mScratchKeys.size() < mKeys.size()) {
+        mScratchKeys.resize(mKeys.size());
+        mScratchIndices.resize(mKeys.size());
+    }
+
+    if (!mKeys.empty()) {
+        radixSort(&mKeys[0], &mIndices[0], &mScratchKeys[0], &mScratchIndices[0], mKeys.size());
+    }
+
+    mSorted = true;
+}
+
+void LDrawList::flush(SDL_Renderer* renderer)
+{
+    if (!mSorted) {
+        sort();
+    }
+
+    mBatchCount = 0;
+    mVertices.clear();
+    mVertexIndices.clear();
+
+    // Texture and blending of the batch being built, they sit in the key below the depth
+    Uint64 batchState = 0;
+
+    for (size_t i = 0; i <= mKeys.size(); ++i) {
+        Uint64 state = i < mKeys.size() ? mKeys[i] & 0xFFFFFFFF : 0;
+
+        if (!mVertices.empty() && (i == mKeys.size() || state != batchState)) {
+            LTexture* texture = mTextures[(batchState >> DRAW_KEY_TEXTURE_SHIFT) & 0xFFFF];
+            SDL_SetTextureBlendMode(texture->getTexture(), (SDL_BlendMode)((batchState >> DRAW_KEY_BLEND_SHIFT) & 0xFF));
+            SDL_RenderGeometry(renderer, texture->getTexture(), &mVertices[0], (int)mVertices.size(), &mVertexIndices[0], (int)mVertexIndices.size());
+
+            mVertices.clear();
+            mVertexIndices.clear();
+            ++mBatchCount;
+        }
+
+        if (i == mKeys.size()) {
+            break;
+        }
+
+        batchState = state;
+
+        const DrawCommand& command = mCommands[mIndices[i]];
+        LTexture* texture = mTextures[(state >> DRAW_KEY_TEXTURE_SHIFT) & 0xFFFF];
+        float u0 = (float)command.clip.x / texture->getWidth();
+        float v0 = (float)command.clip.y / texture->getHeight();
+        float u1 = (float)(command.clip.x + command.clip.w) / texture->getWidth();
+        float v1 = (float)(command.clip.y + command.clip.h) / texture->getHeight();
+        float x0 = command.quad.x;
+        float y0 = command.quad.y;
+        float x1 = command.quad.x + command.quad.w;
+        float y1 = command.quad.y + command.quad.h;
+
+        int first = (int)mVertices.size();
+        SDL_Vertex corners[4] = {
+            {{x0, y0}, command.color, {u0, v0}},
+            {{x1, y0}, command.color, {u1, v0}},
+            {{x1, y1}, command.color, {u1, v1}},
+            {{x0, y1}, command.color, {u0, v1}}
+        };
+        mVertices.insert(mVertices.end(), corners, corners + 4);
+
+        int quadIndices[6] = {first, first + 1, first + 2, first, first + 2, first + 3};
+        mVertexIndices.insert(mVertexIndices.end(), quadIndices, quadIndices + 6);
+    }
+
+    // Keep capacity for the next frame
+    mCommands.clear();
+    mKeys.clear();
+    mIndices.clear();
+}
+
+int LDrawList::getCount()
+{
+    return (int)mKeys.size();
+}
+
+int LDrawList::getBatchCount()
+{
+    return mBatchCount;
+}
+
+int radixSort(Uint64* keys, Uint32* values, Uint64* scratchKeys, Uint32* scratchValues, size_t count)
+{
+    // Counts of every byte value for all eight digits in one read of the keys
+    static size_t histograms[8][256];
+    memset(histograms, 0, sizeof(histograms));
+
+    for (size_t i = 0; i < count; ++i) {
+        Uint64 key = keys[i];
+        for (int digit = 0; digit < 8; ++digit) {
+            ++histograms[digit][(key >> (digit * 8)) & 0xFF];
+        }
+    }
+
+    Uint64* sourceKeys = keys;
+    Uint32* sourceValues = values;
+    Uint64* targetKeys = scratchKeys;
+    Uint32* targetValues = scratchValues;
+    int passes = 0;
+
+    for (int digit = 0; digit < 8 && count > 0; ++digit) {
+        int shift = digit * 8;
+        size_t* histogram = histograms[digit];
+
+        // Every key has the same byte here, order would not change
+        if (histogram[(sourceKeys[0] >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (int bucket = 0; bucket < 256; ++bucket) {
+            size_t size = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += size;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            Uint64 key = sourceKeys[i];
+            size_t target = histogram[(key >> shift) & 0xFF]++;
+            targetKeys[target] = key;
+            targetValues[target] = sourceValues[i];
+        }
+
+        std::swap(sourceKeys, targetKeys);
+        std::swap(sourceValues, targetValues);
+        ++passes;
+    }
+
+    // Odd pass counts leave the result in scratch
+    if (sourceKeys != keys) {
+        memcpy(keys, sourceKeys, count * sizeof(Uint64));
+        memcpy(values, sourceValues, count * sizeof(Uint32));
+    }
+
+    return passes;
+}
+
+SDL_Surface* createShadowSurface(int size)
+{
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, size, size, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (surface == NULL) {
+        printf("Unable to create shadow surface! SDL Error: %s\n", SDL_GetError());
+        return NULL;
+    }
+
+    // Black, alpha falling off towards the edge
+    float radius = size / 2.0f;
+    for (int y = 0; y < size; ++y) {
+        Uint32* row = (Uint32*)((Uint8*)surface->pixels + y * surface->pitch);
+        for (int x = 0; x < size; ++x) {
+            float dx = (x + 0.5f - radius) / radius;
+            float dy = (y + 0.5f - radius) / radius;
+            float falloff = 1.0f - (dx * dx + dy * dy);
+            Uint32 alpha = falloff > 0 ? (Uint32)(falloff * 255) : 0;
+            row[x] = alpha << 24;
+        }
+    }
+
+    return surface;
+}
+
+void submitScene(LDrawList& list)
+{
+    SDL_Color white = {0xFF, 0xFF, 0xFF, 0xFF};
+    SDL_Color shade = {0xFF, 0xFF, 0xFF, 0x60};
+    SDL_Rect shadowClip = {0, 0, gShadowTexture.getWidth(), gShadowTexture.getHeight()};
+
+    for (size_t i = 0; i < gSprites.size(); ++i) {
+        Sprite& sprite = gSprites[i];
+
+        sprite.x += sprite.vx;
+        sprite.y += sprite.vy;
+        if (sprite.x < 0 || sprite.x > SCREEN_WIDTH - SPRITE_SIZE) {
+            sprite.vx = -sprite.vx;
+        }
+        if (sprite.y < 0 || sprite.y > SCREEN_HEIGHT - SPRITE_SIZE) {
+            sprite.vy = -sprite.vy;
+        }
+
+        // Lower sprites are nearer, so the bottom edge is the depth
+        Uint32 depth = (Uint32)SDL_max(0.0f, sprite.y + SPRITE_SIZE);
+
+        SDL_FRect shadowQuad = {sprite.x, sprite.y + SPRITE_SIZE * 0.75f, (float)SPRITE_SIZE, SPRITE_SIZE * 0.5f};
+        list.submit(LAYER_SHADOWS, 0, gShadowId, SDL_BLENDMODE_BLEND, shadowClip, shadowQuad, shade);
+
+        SDL_FRect spriteQuad = {sprite.x, sprite.y, (float)SPRITE_SIZE, (float)SPRITE_SIZE};
+        list.submit(LAYER_SPRITES, depth, gDotsId, SDL_BLENDMODE_BLEND, gSpriteClips[sprite.clip], spriteQuad, white);
+    }
+}
+
+void runSortBenchmark()
+{
+    double frequency = (double)SDL_GetPerformanceFrequency();
+
+    std::vector<Uint64> keys(BENCHMARK_KEYS);
+    std::vector<Uint32> values(BENCHMARK_KEYS);
+    std::vector<Uint64> scratchKeys(BENCHMARK_KEYS);
+    std::vector<Uint32> scratchValues(BENCHMARK_KEYS);
+    std::vector<std::pair<Uint64, Uint32> > pairs(BENCHMARK_KEYS);
+
+    double radixMs = 0;
+    double comparisonMs = 0;
+    int passes = 0;
+    bool matches = true;
+
+    for (int frame = 0; frame < BENCHMARK_FRAMES; ++frame) {
+        // A frame's worth of draws: few layers, y depth, a handful of textures and blend modes
+        for (int i = 0; i < BENCHMARK_KEYS; ++i) {
+            Uint8 layer = (Uint8)(rand() % 4);
+            Uint32 depth = (Uint32)(rand() % 4096);
+            Uint16 texture = (Uint16)(rand() % 16);
+            SDL_BlendMode blending = rand() % 8 == 0 ? SDL_BLENDMODE_ADD : SDL_BLENDMODE_BLEND;
+
+            keys[i] = LDrawList::makeKey(layer, depth, texture, blending);
+            values[i] = (Uint32)i;
+            pairs[i] = std::make_pair(keys[i], (Uint32)i);
+        }
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        passes = radixSort(&keys[0], &values[0], &scratchKeys[0], &scratchValues[0], keys.size());
+        radixMs += (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+
+        start = SDL_GetPerformanceCounter();
+        std::sort(pairs.begin(), pairs.end());
+        comparisonMs += (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+
+        // Radix sort is stable, so equal keys keep submission order just like the pair sort
+        for (int i = 0; i < BENCHMARK_KEYS; ++i) {
+            if (keys[i] != pairs[i].first || values[i] != pairs[i].second) {
+                matches = false;
+                break;
+            }
+        }
+    }
+
+    printf("Sorting %d draw keys per frame over %d frames\n", BENCHMARK_KEYS, BENCHMARK_FRAMES);
+    printf("Radix sort: %7.2f ms/frame, %d of 8 passes\n", radixMs / BENCHMARK_FRAMES, passes);
+    printf("std::sort:  %7.2f ms/frame (%.2fx radix)\n", comparisonMs / BENCHMARK_FRAMES, comparisonMs / radixMs);
+    printf("Orders %s\n", matches ? "match" : "DIFFER");
+}
+
+bool init()
+{
+    bool success = true;
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        printf("SDL failed to initialize!\n");
+        success = false;
+    } else {
+        gWindow = SDL_CreateWindow("SDL Tutorial", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
+        if (gWindow == NULL) {
+            printf("Failed to create window! SDL Error: %s\n", SDL_GetError());
+            success = false;
+        } else {
+            gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+            if (gRenderer == NULL) {
+                printf("Failed to create renderer! SDL Error: %s\n", SDL_GetError());
+                success = false;
+            } else {
+                int imgFlag = IMG_INIT_PNG;
+                if (!(IMG_Init(imgFlag) & imgFlag)) {
+                    printf("SDL_Image failed to initialize! SDL_Image Error: %s\n", IMG_GetError());
+                    success = false;
+                }
+            }
+        }
+    }
+
+    return success;
+}
+
+bool loadMedia()
+{
+    bool success = true;
+
+    if (!gDotsTexture.loadFromFile("dots.png")) {
+        printf("Failed to load sprite sheet texture!\n");
+        success = false;
+    } else {
+        for (int i = 0; i < 4; ++i) {
+            gSpriteClips[i].x = (i % 2) * 100;
+            gSpriteClips[i].y = (i / 2) * 100;
+            gSpriteClips[i].w = 100;
+            gSpriteClips[i].h = 100;
+        }
+    }
+
+    SDL_Surface* shadow = createShadowSurface(32);
+    if (shadow == NULL || !gShadowTexture.loadFromSurface(shadow)) {
+        printf("Failed to create shadow texture!\n");
+        success = false;
+    }
+    SDL_FreeSurface(shadow);
+
+    gDotsId = gDrawList.addTexture(&gDotsTexture);
+    gShadowId = gDrawList.addTexture(&gShadowTexture);
+
+    gSprites.resize(TOTAL_SPRITES);
+    for (size_t i = 0; i < gSprites.size(); ++i) {
+        gSprites[i].x = (float)(rand() % (SCREEN_WIDTH - SPRITE_SIZE));
+        gSprites[i].y = (float)(rand() % (SCREEN_HEIGHT - SPRITE_SIZE));
+        gSprites[i].vx = (rand() % 200 - 100) / 100.0f;
+        gSprites[i].vy = (rand() % 200 - 100) / 100.0f;
+        gSprites[i].clip = rand() % 4;
+    }
+
+    return success;
+}
+
+void close()
+{
+    gDotsTexture.free();
+    gShadowTexture.free();
+
+    SDL_DestroyRenderer(gRenderer);
+    SDL_DestroyWindow(gWindow);
+    gWindow = NULL;
+    gRenderer = NULL;
+
+    IMG_Quit();
+    SDL_Quit();
+}
+
+int main (int argc, char *argv[])
+{
+    // --bench times sorting 1M draw keys without opening a window
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        runSortBenchmark();
+        return 0;
+    }
+
+    if (!init()) {
+        printf("Failed to initialize!\n");
+    } else {
+        if (!loadMedia()) {
+            printf("Failed to load media!\n");
+        } else {
+            bool quit = false;
+
+            SDL_Event e;
+
+            double frequency = (double)SDL_GetPerformanceFrequency();
+            double sortMs = 0;
+            Uint64 batches = 0;
+            int frames = 0;
+
+            while (!quit) {
+                while (SDL_PollEvent(&e) != 0) {
+                    if (e.type == SDL_QUIT) {
+                        quit = true;
+                    }
+                }
+
+                SDL_SetRenderDrawColor(gRenderer, 0x60, 0xA0, 0x60, 0xFF);
+                SDL_RenderClear(gRenderer);
+
+                // Submission order no longer matters, the keys decide
+                submitScene(gDrawList);
+
+                Uint64 start = SDL_GetPerformanceCounter();
+                gDrawList.sort();
+                sortMs += (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+
+                gDrawList.flush(gRenderer);
+                batches += gDrawList.getBatchCount();
+                ++frames;
+
+                SDL_RenderPresent(gRenderer);
+            }
+
+            if (frames > 0) {
+                printf("%d draws per frame, sorted in %.3f ms, %.1f batches per frame\n",
+                    TOTAL_SPRITES * 2, sortMs / frames, (double)batches / frames);
+            }
+        }
+    }
+
+    close();
+
+    return 0;
+}
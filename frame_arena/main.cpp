@@ -0,0 +1,505 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_error.h>
+#include <SDL2/SDL_events.h>
+#include <SDL2/SDL_rect.h>
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_video.h>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+const int SCREEN_WIDTH = 640;
+const int SCREEN_HEIGHT = 480;
+
+// Initial size of each arena, grown to the high water mark on reset
+const size_t ARENA_CHUNK_SIZE = 64 * 1024;
+
+// Quads drawn per viewport
+const int QUAD_COLUMNS = 40;
+const int QUAD_ROWS = 30;
+
+// Viewports the screen is split into
+const int TOTAL_VIEWPORTS = 4;
+
+// Threads building vertices alongside the main thread
+const int WORKER_COUNT = 3;
+
+// Frames between statistics lines
+const int STATS_INTERVAL = 300;
+
+class LFrameArena : public std::pmr::memory_resource
+{
+    public:
+        // Initialize with capacity of the first chunk
+        LFrameArena(size_t capacity = ARENA_CHUNK_SIZE);
+
+        // Deallocate chunks
+        ~LFrameArena();
+
+        // Releases everything allocated this frame
+        void reset();
+
+        // Bytes allocated this frame
+        size_t getUsed();
+
+        // Most bytes any frame allocated
+        size_t getHighWaterMark();
+
+        // Bytes reserved from the heap
+        size_t getCapacity();
+
+        // Chunks taken from the heap because a frame outgrew the arena
+        int getOverflows();
+
+    private:
+        // Bump allocation, overflowing into a new chunk when full
+        void* do_allocate(size_t bytes, size_t alignment) override;
+
+        // Individual frees are no-ops, reset releases everything
+        void do_deallocate(void*, size_t, size_t) override;
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+        // Adds a chunk of at least size bytes
+        void addChunk(size_t size);
+
+        // Heap blocks backing the arena
+        std::vector<char*> mChunks;
+        std::vector<size_t> mChunkSizes;
+
+        // Bump position in the last chunk
+        size_t mOffset;
+
+        // Bytes used by filled chunks before the last one
+        size_t mUsedBefore;
+
+        size_t mHighWaterMark;
+        int mOverflows;
+};
+
+bool init();
+
+bool loadMedia();
+
+void close();
+
+// Arena of the calling thread, created on first use
+LFrameArena& frameArena();
+
+// Presents the frame and resets every thread's arena
+void presentFrame();
+
+// Writes vertices and indices of quad rows [firstRow, lastRow) of a viewport
+void buildQuads(SDL_Vertex* vertices, int* indices, const SDL_Rect& viewport, int firstRow, int lastRow, int frame);
+
+// Waits for frames and builds its share of quads
+void workerMain(int index);
+
+SDL_Window* gWindow = NULL;
+
+SDL_Renderer* gRenderer = NULL;
+
+// Every thread's arena, reset together at present
+std::mutex gArenasMutex;
+std::vector<LFrameArena*> gArenas;
+
+// C++ heap allocations since start, counted by the global operator new,
+// SDL's own mallocs are not seen here
+std::atomic<int> gHeapAllocations(0);
+
+// Work handed to the workers each frame
+std::mutex gWorkMutex;
+std::condition_variable gWorkStart;
+std::condition_variable gWorkDone;
+int gWorkFrame = 0;
+int gWorkPending = 0;
+
+// Frame number the quads are built for, the same one the main thread uses
+int gWorkBuildFrame = 0;
+bool gWorkQuit = false;
+SDL_Vertex* gWorkVertices = NULL;
+int* gWorkIndices = NULL;
+const SDL_Rect* gWorkViewports = NULL;
+
+std::thread gWorkers[WORKER_COUNT];
+
+void* operator new(size_t size)
+{
+    ++gHeapAllocations;
+
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+LFrameArena::LFrameArena(size_t capacity)
+{
+    mOffset = 0;
+    mUsedBefore = 0;
+    mHighWaterMark = 0;
+    mOverflows = 0;
+
+    addChunk(capacity);
+}
+
+LFrameArena::~LFrameArena()
+{
+    for (size_t i = 0; i < mChunks.size(); ++i) {
+        ::operator delete(mChunks[i]);
+    }
+}
+
+void LFrameArena::addChunk(size_t size)
+{
+    mChunks.push_back((char*)::operator new(size));
+    mChunkSizes.push_back(size);
+}
+
+void* LFrameArena::do_allocate(size_t bytes, size_t alignment)
+{
+    // Align the address itself, chunks only promise the default new alignment
+    void* p = mChunks.back() + mOffset;
+    size_t space = mChunkSizes.back() - mOffset;
+
+    if (std::align(alignment, bytes, p, space) == NULL) {
+        // Frame outgrew the arena, continue in a fresh chunk
+        mUsedBefore += mOffset;
+        addChunk(SDL_max(mChunkSizes.back() * 2, bytes + alignment));
+        ++mOverflows;
+
+        p = mChunks.back();
+        space = mChunkSizes.back();
+        std::align(alignment, bytes, p, space);
+    }
+
+    mOffset = (char*)p + bytes - mChunks.back();
+    return p;
+}
+
+void LFrameArena::do_deallocate(void*, size_t, size_t)
+{
+}
+
+bool LFrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+void LFrameArena::reset()
+{
+    size_t used = getUsed();
+    if (used > mHighWaterMark) {
+        mHighWaterMark = used;
+    }
+
+    // Merge overflow chunks so the next frame of this size fits in one
+    if (mChunks.size() > 1) {
+        size_t total = getCapacity();
+        for (size_t i = 0; i < mChunks.size(); ++i) {
+            ::operator delete(mChunks[i]);
+        }
+        mChunks.clear();
+        mChunkSizes.clear();
+        addChunk(total);
+    }
+
+    mOffset = 0;
+    mUsedBefore = 0;
+}
+
+size_t LFrameArena::getUsed()
+{
+    return mUsedBefore + mOffset;
+}
+
+size_t LFrameArena::getHighWaterMark()
+{
+    return mHighWaterMark;
+}
+
+size_t LFrameArena::getCapacity()
+{
+    size_t total = 0;
+    for (size_t i = 0; i < mChunkSizes.size(); ++i) {
+        total += mChunkSizes[i];
+    }
+
+    return total;
+}
+
+int LFrameArena::getOverflows()
+{
+    return mOverflows;
+}
+
+LFrameArena& frameArena()
+{
+    thread_local LFrameArena* arena = NULL;
+
+    if (arena == NULL) {
+        arena = new LFrameArena();
+
+        std::lock_guard<std::mutex> lock(gArenasMutex);
+        gArenas.push_back(arena);
+    }
+
+    return *arena;
+}
+
+void presentFrame()
+{
+    SDL_RenderPresent(gRenderer);
+
+    // Workers are idle between frames, so their arenas can go too
+    std::lock_guard<std::mutex> lock(gArenasMutex);
+    for (size_t i = 0; i < gArenas.size(); ++i) {
+        gArenas[i]->reset();
+    }
+}
+
+void buildQuads(SDL_Vertex* vertices, int* indices, const SDL_Rect& viewport, int firstRow, int lastRow, int frame)
+{
+    float quadWidth = (float)viewport.w / QUAD_COLUMNS;
+    float quadHeight = (float)viewport.h / QUAD_ROWS;
+
+    // Per row scratch from the calling thread's arena
+    std::pmr::vector<Uint8> brightness(QUAD_COLUMNS, &frameArena());
+
+    for (int row = firstRow; row < lastRow; ++row) {
+        for (int column = 0; column < QUAD_COLUMNS; ++column) {
+            brightness[column] = (Uint8)(127 + 127 * sinf((column + row + frame) * 0.1f));
+        }
+
+        for (int column = 0; column < QUAD_COLUMNS; ++column) {
+            int quad = row * QUAD_COLUMNS + column;
+            SDL_Vertex* v = vertices + quad * 4;
+            int* i = indices + quad * 6;
+
+            float x = viewport.x + column * quadWidth;
+            float y = viewport.y + row * quadHeight;
+            SDL_Color color = {brightness[column], (Uint8)(row * 8), (Uint8)(column * 6), 0xFF};
+
+            v[0].position.x = x;
+            v[0].position.y = y;
+            v[1].position.x = x + quadWidth - 1;
+            v[1].position.y = y;
+            v[2].position.x = x + quadWidth - 1;
+            v[2].position.y = y + quadHeight - 1;
+            v[3].position.x = x;
+            v[3].position.y = y + quadHeight - 1;
+            for (int corner = 0; corner < 4; ++corner) {
+                v[corner].color = color;
+                v[corner].tex_coord.x = 0;
+                v[corner].tex_coord.y = 0;
+            }
+
+            int base = quad * 4;
+            i[0] = base;
+            i[1] = base + 1;
+            i[2] = base + 2;
+            i[3] = base;
+            i[4] = base + 2;
+            i[5] = base + 3;
+        }
+    }
+}
+
+void workerMain(int index)
+{
+    int lastFrame = 0;
+
+    while (true) {
+        std::unique_lock<std::mutex> lock(gWorkMutex);
+        gWorkStart.wait(lock, [&]() { return gWorkQuit || gWorkFrame != lastFrame; });
+        if (gWorkQuit) {
+            return;
+        }
+        lastFrame = gWorkFrame;
+        int buildFrame = gWorkBuildFrame;
+        lock.unlock();
+
+        // Worker i fills viewport i + 1, the main thread does viewport 0
+        int viewport = index + 1;
+        int quads = QUAD_COLUMNS * QUAD_ROWS;
+        buildQuads(gWorkVertices + viewport * quads * 4, gWorkIndices + viewport * quads * 6, gWorkViewports[viewport], 0, QUAD_ROWS, buildFrame);
+
+        lock.lock();
+        if (--gWorkPending == 0) {
+            gWorkDone.notify_one();
+        }
+    }
+}
+
+bool init()
+{
+    bool success = true;
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        printf("SDL failed to initialize!\n");
+        success = false;
+    } else {
+        gWindow = SDL_CreateWindow("SDL Tutorial", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
+        if (gWindow == NULL) {
+            printf("Failed to create window! SDL Error: %s\n", SDL_GetError());
+            success = false;
+        } else {
+            gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+            if (gRenderer == NULL) {
+                printf("Failed to create renderer! SDL Error: %s\n", SDL_GetError());
+                success = false;
+            } else {
+                SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+            }
+        }
+    }
+
+    return success;
+}
+
+bool loadMedia()
+{
+    bool success = true;
+
+    for (int i = 0; i < WORKER_COUNT; ++i) {
+        gWorkers[i] = std::thread(workerMain, i);
+    }
+
+    return success;
+}
+
+void close()
+{
+    {
+        std::lock_guard<std::mutex> lock(gWorkMutex);
+        gWorkQuit = true;
+    }
+    gWorkStart.notify_all();
+    for (int i = 0; i < WORKER_COUNT; ++i) {
+        if (gWorkers[i].joinable()) {
+            gWorkers[i].join();
+        }
+    }
+
+    for (size_t i = 0; i < gArenas.size(); ++i) {
+        printf("Arena %d: high water mark %zu bytes, capacity %zu bytes, %d overflows\n", (int)i, gArenas[i]->getHighWaterMark(), gArenas[i]->getCapacity(), gArenas[i]->getOverflows());
+        delete gArenas[i];
+    }
+    gArenas.clear();
+
+    SDL_DestroyRenderer(gRenderer);
+    SDL_DestroyWindow(gWindow);
+    gWindow = NULL;
+    gRenderer = NULL;
+
+    SDL_Quit();
+}
+
+int main (int argc, char *argv[])
+{
+    if (!init()) {
+        printf("Failed to initialize!\n");
+    } else {
+        if (!loadMedia()) {
+            printf("Failed to load media!\n");
+        } else {
+            bool quit = false;
+
+            SDL_Event e;
+
+            int frame = 0;
+
+            // Frames since the last statistics line that touched the heap
+            int allocatingFrames = 0;
+
+            while (!quit) {
+                int heapBefore = gHeapAllocations;
+
+                while (SDL_PollEvent(&e) != 0) {
+                    if (e.type == SDL_QUIT) {
+                        quit = true;
+                    }
+                }
+
+                LFrameArena& arena = frameArena();
+
+                // Viewports, vertices and indices all live until present
+                std::pmr::vector<SDL_Rect> viewports(&arena);
+                for (int i = 0; i < TOTAL_VIEWPORTS; ++i) {
+                    SDL_Rect viewport = {(i % 2) * SCREEN_WIDTH / 2, (i / 2) * SCREEN_HEIGHT / 2, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2};
+                    viewports.push_back(viewport);
+                }
+
+                int quads = QUAD_COLUMNS * QUAD_ROWS * TOTAL_VIEWPORTS;
+                std::pmr::vector<SDL_Vertex> vertices(quads * 4, &arena);
+                std::pmr::vector<int> indices(quads * 6, &arena);
+
+                // Hand viewports 1..N to the workers and build viewport 0 here
+                {
+                    std::lock_guard<std::mutex> lock(gWorkMutex);
+                    gWorkVertices = vertices.data();
+                    gWorkIndices = indices.data();
+                    gWorkViewports = viewports.data();
+                    gWorkPending = WORKER_COUNT;
+                    gWorkBuildFrame = frame;
+                    ++gWorkFrame;
+                }
+                gWorkStart.notify_all();
+
+                buildQuads(vertices.data(), indices.data(), viewports[0], 0, QUAD_ROWS, frame);
+
+                {
+                    std::unique_lock<std::mutex> lock(gWorkMutex);
+                    gWorkDone.wait(lock, []() { return gWorkPending == 0; });
+                }
+
+                SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+                SDL_RenderClear(gRenderer);
+
+                SDL_RenderGeometry(gRenderer, NULL, vertices.data(), (int)vertices.size(), indices.data(), (int)indices.size());
+
+                SDL_SetRenderDrawColor(gRenderer, 0x00, 0x00, 0x00, 0xFF);
+                for (size_t i = 0; i < viewports.size(); ++i) {
+                    SDL_RenderDrawRect(gRenderer, &viewports[i]);
+                }
+
+                presentFrame();
+
+                if (gHeapAllocations != heapBefore) {
+                    ++allocatingFrames;
+                }
+
+                ++frame;
+
+                if (frame % STATS_INTERVAL == 0) {
+                    printf("Frames %d-%d: %d of %d touched the heap\n", frame - STATS_INTERVAL, frame, allocatingFrames, STATS_INTERVAL);
+                    allocatingFrames = 0;
+                }
+            }
+        }
+    }
+
+    close();
+
+    return 0;
+}
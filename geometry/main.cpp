@@ -4,21 +4,48 @@
 #include <SDL2/SDL_render.h>
 #include <SDL2/SDL_video.h>
 #include <cstdio>
+#include <cstring>
+#include <string>
 
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 480;
 
-bool init();
+// Frames drawn per render driver when probing, after warming up
+const int PROBE_WARMUP_FRAMES = 5;
+const int PROBE_FRAMES = 60;
+
+// Times the scene is drawn in each probe frame
+const int PROBE_SCENE_REPEATS = 20;
+
+// Remembers the fastest driver in the pref path
+const char* RENDERER_CONFIG_FILE = "renderer.cfg";
+
+bool init(bool reprobe);
 
 bool loadMedia();
 
 void close();
 
+// Draws rectangles, lines and points
+void drawScene(SDL_Renderer* renderer);
+
+// Creates renderer with the driver cached for this machine, probing every driver when there is none
+SDL_Renderer* createFastestRenderer(SDL_Window* window, bool reprobe);
+
+// Milliseconds per frame of the scene on a render driver, negative when it can not be created
+double probeRenderDriver(SDL_Window* window, int index);
+
+// SDL version, video driver and render drivers the cached choice was made with
+std::string getRendererFingerprint();
+
+// Where the cached choice is kept
+std::string getRendererConfigPath();
+
 SDL_Window* gWindow = NULL;
 
 SDL_Renderer* gRenderer = NULL;
 
-bool init()
+bool init(bool reprobe)
 {
     bool success = true;
 
@@ -31,7 +58,7 @@ bool init()
             printf("Unable to crete window! SDL Error: %s\n", SDL_GetError());
             success = false;
         } else {
-            gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED);
+            gRenderer = createFastestRenderer(gWindow, reprobe);
             if (gRenderer == NULL) {
                 printf("Unable to create renderer! SDL Error: %s\n", SDL_GetError());
                 success = false;
@@ -42,6 +69,178 @@ bool init()
     return success;
 }
 
+void drawScene(SDL_Renderer* renderer)
+{
+    SDL_Rect fillRect = { SCREEN_WIDTH / 4, SCREEN_HEIGHT / 4, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 };
+    SDL_SetRenderDrawColor(renderer, 0xFF, 0x00, 0x00, 0xFF);
+    SDL_RenderFillRect(renderer, &fillRect);
+
+    SDL_Rect outlineRect = { SCREEN_WIDTH / 6, SCREEN_HEIGHT / 6, SCREEN_WIDTH * 2 / 3, SCREEN_HEIGHT * 2 / 3 };
+    SDL_SetRenderDrawColor(renderer, 0x00, 0xFF, 0x00, 0xFF);
+    SDL_RenderDrawRect(renderer, &outlineRect);
+
+    SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0xFF, 0xFF);
+    SDL_RenderDrawLine(renderer, 0, SCREEN_HEIGHT / 2, SCREEN_WIDTH, SCREEN_HEIGHT / 2);
+
+    SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0x00, 0xFF);
+    for (int i = 0; i < SCREEN_HEIGHT; i += 4) {
+        SDL_RenderDrawPoint(renderer, SCREEN_WIDTH/2, i);
+    }
+}
+
+std::string getRendererFingerprint()
+{
+    SDL_version version;
+    SDL_GetVersion(&version);
+
+    const char* videoDriver = SDL_GetCurrentVideoDriver();
+
+    std::string fingerprint = std::to_string(version.major) + "." + std::to_string(version.minor) + "." + std::to_string(version.patch);
+    fingerprint += "/";
+    fingerprint += videoDriver != NULL ? videoDriver : "none";
+
+    for (int i = 0; i < SDL_GetNumRenderDrivers(); ++i) {
+        SDL_RendererInfo info;
+        if (SDL_GetRenderDriverInfo(i, &info) == 0) {
+            fingerprint += i == 0 ? "/" : ",";
+            fingerprint += info.name;
+        }
+    }
+
+    return fingerprint;
+}
+
+std::string getRendererConfigPath()
+{
+    std::string path = RENDERER_CONFIG_FILE;
+
+    char* prefPath = SDL_GetPrefPath("LazyFoo", "SDL Tutorial");
+    if (prefPath != NULL) {
+        path = std::string(prefPath) + RENDERER_CONFIG_FILE;
+        SDL_free(prefPath);
+    }
+
+    return path;
+}
+
+double probeRenderDriver(SDL_Window* window, int index)
+{
+    SDL_Renderer* renderer = SDL_CreateRenderer(window, index, 0);
+    if (renderer == NULL) {
+        return -1;
+    }
+
+    double ms = 0;
+    for (int frame = 0; frame < PROBE_WARMUP_FRAMES + PROBE_FRAMES; ++frame) {
+        Uint64 start = SDL_GetPerformanceCounter();
+
+        SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+        SDL_RenderClear(renderer);
+
+        for (int i = 0; i < PROBE_SCENE_REPEATS; ++i) {
+            drawScene(renderer);
+        }
+
+        // Reading a pixel back waits for the frame to finish on the GPU
+        Uint32 pixel;
+        SDL_Rect pixelRect = {0, 0, 1, 1};
+        SDL_RenderReadPixels(renderer, &pixelRect, SDL_PIXELFORMAT_ARGB8888, &pixel, sizeof(pixel));
+        SDL_RenderPresent(renderer);
+
+        if (frame >= PROBE_WARMUP_FRAMES) {
+            ms += (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+        }
+    }
+
+    SDL_DestroyRenderer(renderer);
+    return ms / PROBE_FRAMES;
+}
+
+SDL_Renderer* createFastestRenderer(SDL_Window* window, bool reprobe)
+{
+    // A driver forced through SDL_RENDER_DRIVER wins without probing
+    if (SDL_GetHint(SDL_HINT_RENDER_DRIVER) != NULL) {
+        return SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    }
+
+    std::string configPath = getRendererConfigPath();
+    std::string fingerprint = getRendererFingerprint();
+
+    // Cached choice, only valid for the same SDL and drivers
+    std::string cachedDriver;
+    FILE* config = reprobe ? NULL : fopen(configPath.c_str(), "r");
+    if (config != NULL) {
+        char line[512];
+        bool matches = false;
+        while (fgets(line, sizeof(line), config) != NULL) {
+            line[strcspn(line, "\r\n")] = '\0';
+            if (strncmp(line, "fingerprint ", 12) == 0) {
+                matches = fingerprint == line + 12;
+            } else if (strncmp(line, "driver ", 7) == 0) {
+                cachedDriver = line + 7;
+            }
+        }
+        fclose(config);
+
+        if (!matches) {
+            cachedDriver.clear();
+        }
+    }
+
+    int numDrivers = SDL_GetNumRenderDrivers();
+    if (!cachedDriver.empty()) {
+        for (int i = 0; i < numDrivers; ++i) {
+            SDL_RendererInfo info;
+            if (SDL_GetRenderDriverInfo(i, &info) == 0 && cachedDriver == info.name) {
+                SDL_Renderer* renderer = SDL_CreateRenderer(window, i, 0);
+                if (renderer != NULL) {
+                    return renderer;
+                }
+                printf("Cached render driver %s failed, probing again! SDL Error: %s\n", info.name, SDL_GetError());
+            }
+        }
+    }
+
+    // Time the scene on every driver and keep the fastest
+    int fastest = -1;
+    double fastestMs = 0;
+    std::string fastestName;
+    for (int i = 0; i < numDrivers; ++i) {
+        SDL_RendererInfo info;
+        if (SDL_GetRenderDriverInfo(i, &info) < 0) {
+            continue;
+        }
+
+        double ms = probeRenderDriver(window, i);
+        if (ms < 0) {
+            printf("Render driver %s unavailable! SDL Error: %s\n", info.name, SDL_GetError());
+            continue;
+        }
+
+        printf("Render driver %s: %.3f ms per frame\n", info.name, ms);
+        if (fastest < 0 || ms < fastestMs) {
+            fastest = i;
+            fastestMs = ms;
+            fastestName = info.name;
+        }
+    }
+
+    if (fastest < 0) {
+        return SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    }
+
+    config = fopen(configPath.c_str(), "w");
+    if (config == NULL) {
+        printf("Unable to save render driver choice to %s!\n", configPath.c_str());
+    } else {
+        fprintf(config, "fingerprint %s\ndriver %s\nms %.3f\n", fingerprint.c_str(), fastestName.c_str(), fastestMs);
+        fclose(config);
+    }
+
+    printf("Using render driver %s\n", fastestName.c_str());
+    return SDL_CreateRenderer(window, fastest, 0);
+}
+
 bool loadMedia()
 {
     bool success = true;
@@ -62,7 +261,10 @@ void close()
 
 int main (int argc, char *argv[])
 {
-    if (!init()) {
+    // --reprobe ignores the cached render driver and times them all again
+    bool reprobe = argc > 1 && strcmp(argv[1], "--reprobe") == 0;
+
+    if (!init(reprobe)) {
         printf("Failed to initialize!\n");
     } else {
         if (!loadMedia()) {
@@ -82,21 +284,7 @@ int main (int argc, char *argv[])
                 SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
                 SDL_RenderClear(gRenderer);
 
-                SDL_Rect fillRect = { SCREEN_WIDTH / 4, SCREEN_HEIGHT / 4, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 };
-                SDL_SetRenderDrawColor(gRenderer, 0xFF, 0x00, 0x00, 0xFF);
-                SDL_RenderFillRect(gRenderer, &fillRect);
-
-                SDL_Rect outlineRect = { SCREEN_WIDTH / 6, SCREEN_HEIGHT / 6, SCREEN_WIDTH * 2 / 3, SCREEN_HEIGHT * 2 / 3 };
-                SDL_SetRenderDrawColor(gRenderer, 0x00, 0xFF, 0x00, 0xFF);
-                SDL_RenderDrawRect(gRenderer, &outlineRect);
-
-                SDL_SetRenderDrawColor(gRenderer, 0x00, 0x00, 0xFF, 0xFF);
-                SDL_RenderDrawLine(gRenderer, 0, SCREEN_HEIGHT / 2, SCREEN_WIDTH, SCREEN_HEIGHT / 2);
-
-                SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0x00, 0xFF);
-                for (int i = 0; i < SCREEN_HEIGHT; i += 4) {
-                    SDL_RenderDrawPoint(gRenderer, SCREEN_WIDTH/2, i);
-                }
+                drawScene(gRenderer);
 
                 SDL_RenderPresent(gRenderer);
             }
@@ -0,0 +1,777 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_cpuinfo.h>
+#include <SDL2/SDL_error.h>
+#include <SDL2/SDL_events.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_rwops.h>
+#include <SDL2/SDL_surface.h>
+#include <SDL2/SDL_video.h>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int SCREEN_WIDTH = 640;
+const int SCREEN_HEIGHT = 480;
+
+// Jobs a deque holds, a power of two
+const int JOB_DEQUE_CAPACITY = 4096;
+
+// Jobs per pool block, a thread's pool grows by a block when it wraps onto jobs still in flight
+const int JOB_POOL_SIZE = 4096;
+
+// Empty steal attempts before an idle worker parks
+const int JOB_IDLE_SPINS = 64;
+
+// Bytes of data stored inline in a job
+const int JOB_PAYLOAD_SIZE = 64;
+
+// Sprites moved each frame in the window
+const int DEMO_SPRITES = 50000;
+
+// Sprites per job when updating
+const int SPRITE_GRAIN = 1024;
+
+// Sprites and frames of the update benchmark
+const int BENCHMARK_SPRITES = 1000000;
+const int BENCHMARK_FRAMES = 20;
+
+// Images decoded by the decode benchmark and their size
+const int BENCHMARK_IMAGES = 64;
+const int BENCHMARK_IMAGE_SIZE = 512;
+
+// Unit of work, finished once it and every child it spawned ran
+struct alignas(64) LJob
+{
+    void (*function)(LJob* job, void* data);
+
+    // Job waiting on this one, NULL for roots
+    LJob* parent;
+
+    // This job plus unfinished children
+    std::atomic<int> unfinished;
+
+    // Arguments copied in when the job was created
+    alignas(16) unsigned char payload[JOB_PAYLOAD_SIZE];
+};
+
+// Chase-Lev deque, the owning thread pushes and pops at the bottom,
+// any other thread steals from the top
+class LJobDeque
+{
+    public:
+        // Initialize
+        LJobDeque();
+
+        // Owner only, false when full
+        bool push(LJob* job);
+
+        // Owner only, newest job or NULL
+        LJob* pop();
+
+        // Any thread, oldest job or NULL when empty or another thread won the race
+        LJob* steal();
+
+        // Any thread, whether nothing is queued right now
+        bool isEmpty();
+
+    private:
+        std::atomic<LJob*> mJobs[JOB_DEQUE_CAPACITY];
+
+        // Next job to steal and next free slot
+        std::atomic<Sint64> mTop;
+        std::atomic<Sint64> mBottom;
+};
+
+class LJobSystem
+{
+    public:
+        // Initialize
+        LJobSystem();
+
+        // Stops workers
+        ~LJobSystem();
+
+        // Starts threadCount - 1 workers, the calling thread works while waiting
+        void start(int threadCount);
+
+        // Stops and joins workers
+        void stop();
+
+        // Creates job with size bytes of data copied in, a child of parent when given
+        LJob* create(void (*function)(LJob* job, void* data), LJob* parent = NULL, const void* data = NULL, size_t size = 0);
+
+        // Queues job on the calling thread's deque, running it right away when full
+        void run(LJob* job);
+
+        // Runs own and stolen jobs until job and all its children finished
+        void wait(LJob* job);
+
+        // Calls function over [0, count) split into ranges of at most grain, returns when all ran
+        void parallelFor(int count, int grain, void (*function)(int begin, int end, void* data), void* data);
+
+        int getThreadCount();
+
+        // Jobs taken from another thread's deque since start
+        Uint64 getSteals();
+
+    private:
+        // Own newest job, or one stolen from a random thread
+        LJob* getJob();
+
+        // Runs job and marks it finished
+        void execute(LJob* job);
+
+        // Finishes job once its children are done, then its parent
+        void finish(LJob* job);
+
+        // Worker thread body
+        void workerMain(int index);
+
+        // Sleeps until run() queues work or the system stops
+        void park();
+
+        // Whether any deque holds a job
+        bool hasWork();
+
+        // Allocates a pool block with every job marked finished
+        static LJob* createPoolBlock();
+
+        int mThreadCount;
+
+        // Deque and job pool blocks per thread, index 0 is the thread that called start
+        std::vector<LJobDeque*> mDeques;
+        std::vector<std::vector<LJob*> > mPools;
+        std::vector<size_t> mPoolNext;
+
+        std::vector<std::thread> mThreads;
+        std::atomic<bool> mRunning;
+        std::atomic<Uint64> mSteals;
+
+        // Parked workers and wake ups handed out to them, wake ups guarded by the mutex
+        std::mutex mSleepMutex;
+        std::condition_variable mWake;
+        std::atomic<int> mSleeping;
+        int mWakeups;
+};
+
+// Sprite bouncing around the screen
+struct Sprite
+{
+    float x;
+    float y;
+    float vx;
+    float vy;
+    float phase;
+};
+
+bool init();
+
+bool loadMedia();
+
+void close();
+
+// Spreads sprites over the screen with random velocities
+void spawnSprites(std::vector<Sprite>& sprites);
+
+// Moves sprites [begin, end) one frame, data is the sprite array
+void updateSprites(int begin, int end, void* data);
+
+// Times sprite updates and image decodes from one thread up to every core
+void runBenchmark();
+
+SDL_Window* gWindow = NULL;
+
+SDL_Renderer* gRenderer = NULL;
+
+LJobSystem gJobSystem;
+
+std::vector<Sprite> gSprites;
+
+// Index of the calling thread in the running job system
+thread_local int tThreadIndex = 0;
+
+LJobDeque::LJobDeque()
+{
+    for (int i = 0; i < JOB_DEQUE_CAPACITY; ++i) {
+        mJobs[i].store(NULL, std::memory_order_relaxed);
+    }
+
+    mTop = 0;
+    mBottom = 0;
+}
+
+bool LJobDeque::push(LJob* job)
+{
+    Sint64 bottom = mBottom.load(std::memory_order_relaxed);
+    Sint64 top = mTop.load(std::memory_order_acquire);
+    if (bottom - top >= JOB_DEQUE_CAPACITY) {
+        return false;
+    }
+
+    mJobs[bottom & (JOB_DEQUE_CAPACITY - 1)].store(job, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    mBottom.store(bottom + 1, std::memory_order_relaxed);
+
+    return true;
+}
+
+LJob* LJobDeque::pop()
+{
+    Sint64 bottom = mBottom.load(std::memory_order_relaxed) - 1;
+    mBottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    Sint64 top = mTop.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+        // Empty
+        mBottom.store(bottom + 1, std::memory_order_relaxed);
+        return NULL;
+    }
+
+    LJob* job = mJobs[bottom & (JOB_DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (top == bottom) {
+        // Last job, race thieves for it
+        if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            job = NULL;
+        }
+        mBottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    return job;
+}
+
+LJob* LJobDeque::steal()
+{
+    Sint64 top = mTop.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    Sint64 bottom = mBottom.load(std::memory_order_acquire);
+
+    if (top >= bottom) {
+        return NULL;
+    }
+
+    LJob* job = mJobs[top & (JOB_DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return NULL;
+    }
+
+    return job;
+}
+
+bool LJobDeque::isEmpty()
+{
+    return mTop.load(std::memory_order_acquire) >= mBottom.load(std::memory_order_acquire);
+}
+
+LJobSystem::LJobSystem()
+{
+    mThreadCount = 0;
+    mRunning = false;
+    mSteals = 0;
+    mSleeping = 0;
+    mWakeups = 0;
+}
+
+LJobSystem::~LJobSystem()
+{
+    stop();
+}
+
+void LJobSystem::start(int threadCount)
+{
+    stop();
+
+    mThreadCount = SDL_max(1, threadCount);
+    for (int i = 0; i < mThreadCount; ++i) {
+        mDeques.push_back(new LJobDeque());
+        mPools.push_back(std::vector<LJob*>(1, createPoolBlock()));
+        mPoolNext.push_back(0);
+    }
+
+    tThreadIndex = 0;
+    mSteals = 0;
+    mSleeping = 0;
+    mWakeups = 0;
+    mRunning = true;
+    for (int i = 1; i < mThreadCount; ++i) {
+        mThreads.push_back(std::thread(&LJobSystem::workerMain, this, i));
+    }
+}
+
+void LJobSystem::stop()
+{
+    // Under the mutex so a worker about to park can not miss it
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mRunning = false;
+    }
+    mWake.notify_all();
+
+    for (size_t i = 0; i < mThreads.size(); ++i) {
+        mThreads[i].join();
+    }
+    mThreads.clear();
+
+    for (size_t i = 0; i < mDeques.size(); ++i) {
+        delete mDeques[i];
+        for (size_t b = 0; b < mPools[i].size(); ++b) {
+            delete[] mPools[i][b];
+        }
+    }
+    mDeques.clear();
+    mPools.clear();
+    mPoolNext.clear();
+    mThreadCount = 0;
+}
+
+LJob* LJobSystem::create(void (*function)(LJob* job, void* data), LJob* parent, const void* data, size_t size)
+{
+    int thread = tThreadIndex;
+    std::vector<LJob*>& blocks = mPools[thread];
+    size_t capacity = blocks.size() * JOB_POOL_SIZE;
+    size_t next = mPoolNext[thread] % capacity;
+    LJob* job = &blocks[next / JOB_POOL_SIZE][next % JOB_POOL_SIZE];
+
+    // Wrapped onto a job still in flight, grow instead of overwriting it
+    if (job->unfinished.load(std::memory_order_acquire) > 0) {
+        blocks.push_back(createPoolBlock());
+        next = capacity;
+        job = &blocks.back()[0];
+    }
+    mPoolNext[thread] = next + 1;
+
+    job->function = function;
+    job->parent = parent;
+    job->unfinished.store(1, std::memory_order_relaxed);
+    if (size > 0) {
+        memcpy(job->payload, data, SDL_min(size, (size_t)JOB_PAYLOAD_SIZE));
+    }
+
+    if (parent != NULL) {
+        parent->unfinished.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return job;
+}
+
+void LJobSystem::run(LJob* job)
+{
+    if (!mDeques[tThreadIndex]->push(job)) {
+        execute(job);
+        return;
+    }
+
+    // Pairs with the fence in park(), either the worker sees the job or this sees the worker
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mSleeping.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        if (mWakeups < mSleeping.load(std::memory_order_relaxed)) {
+            ++mWakeups;
+            mWake.notify_one();
+        }
+    }
+}
+
+void LJobSystem::wait(LJob* job)
+{
+    while (job->unfinished.load(std::memory_order_acquire) > 0) {
+        LJob* next = getJob();
+        if (next != NULL) {
+            execute(next);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+LJob* LJobSystem::getJob()
+{
+    LJob* job = mDeques[tThreadIndex]->pop();
+    if (job != NULL || mThreadCount == 1) {
+        return job;
+    }
+
+    // Random victim, xorshift state per thread
+    static thread_local Uint32 seed = 0x9E3779B9u ^ (Uint32)tThreadIndex;
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    int victim = (int)(seed % (Uint32)mThreadCount);
+    if (victim == tThreadIndex) {
+        return NULL;
+    }
+
+    job = mDeques[victim]->steal();
+    if (job != NULL) {
+        mSteals.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return job;
+}
+
+void LJobSystem::execute(LJob* job)
+{
+    job->function(job, job->payload);
+    finish(job);
+}
+
+void LJobSystem::finish(LJob* job)
+{
+    // Read first, once finished the owner may hand the slot out again
+    LJob* parent = job->parent;
+    if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1 && parent != NULL) {
+        finish(parent);
+    }
+}
+
+void LJobSystem::workerMain(int index)
+{
+    tThreadIndex = index;
+
+    int idle = 0;
+    while (mRunning) {
+        LJob* job = getJob();
+        if (job != NULL) {
+            execute(job);
+            idle = 0;
+        } else if (++idle < JOB_IDLE_SPINS) {
+            std::this_thread::yield();
+        } else {
+            park();
+            idle = 0;
+        }
+    }
+}
+
+void LJobSystem::park()
+{
+    std::unique_lock<std::mutex> lock(mSleepMutex);
+    mSleeping.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // Work queued before run() could see this thread sleeping
+    if (mRunning && !hasWork()) {
+        mWake.wait(lock, [this] { return mWakeups > 0 || !mRunning; });
+        if (mWakeups > 0) {
+            --mWakeups;
+        }
+    }
+
+    mSleeping.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool LJobSystem::hasWork()
+{
+    for (int i = 0; i < mThreadCount; ++i) {
+        if (!mDeques[i]->isEmpty()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+LJob* LJobSystem::createPoolBlock()
+{
+    LJob* block = new LJob[JOB_POOL_SIZE];
+    for (int i = 0; i < JOB_POOL_SIZE; ++i) {
+        block[i].unfinished.store(0, std::memory_order_relaxed);
+    }
+
+    return block;
+}
+
+// Range of a parallel for, split in halves until it fits the grain
+struct ParallelForRange
+{
+    void (*function)(int begin, int end, void* data);
+    void* data;
+    int begin;
+    int end;
+    int grain;
+    LJobSystem* system;
+};
+
+static void parallelForJob(LJob* job, void* data)
+{
+    ParallelForRange* range = (ParallelForRange*)data;
+
+    // Keep the left half and queue the right one where idle threads can steal it
+    while (range->end - range->begin > range->grain) {
+        ParallelForRange right = *range;
+        right.begin = range->begin + (range->end - range->begin) / 2;
+        range->end = right.begin;
+
+        range->system->run(range->system->create(parallelForJob, job, &right, sizeof(right)));
+    }
+
+    range->function(range->begin, range->end, range->data);
+}
+
+void LJobSystem::parallelFor(int count, int grain, void (*function)(int begin, int end, void* data), void* data)
+{
+    ParallelForRange range = {function, data, 0, count, SDL_max(1, grain), this};
+
+    LJob* root = create(parallelForJob, NULL, &range, sizeof(range));
+    run(root);
+    wait(root);
+}
+
+int LJobSystem::getThreadCount()
+{
+    return mThreadCount;
+}
+
+Uint64 LJobSystem::getSteals()
+{
+    return mSteals;
+}
+
+void spawnSprites(std::vector<Sprite>& sprites)
+{
+    for (size_t i = 0; i < sprites.size(); ++i) {
+        sprites[i].x = (float)(rand() % SCREEN_WIDTH);
+        sprites[i].y = (float)(rand() % SCREEN_HEIGHT);
+        sprites[i].vx = (float)(rand() % 200 - 100) / 100.0f;
+        sprites[i].vy = (float)(rand() % 200 - 100) / 100.0f;
+        sprites[i].phase = (float)(rand() % 628) / 100.0f;
+    }
+}
+
+void updateSprites(int begin, int end, void* data)
+{
+    Sprite* sprites = (Sprite*)data;
+
+    for (int i = begin; i < end; ++i) {
+        Sprite& sprite = sprites[i];
+
+        // Wobble sideways while moving, bounce off the edges
+        sprite.phase += 0.05f;
+        sprite.x += sprite.vx + 0.5f * sinf(sprite.phase);
+        sprite.y += sprite.vy + 0.5f * cosf(sprite.phase);
+
+        if (sprite.x < 0 || sprite.x >= SCREEN_WIDTH) {
+            sprite.vx = -sprite.vx;
+            sprite.x = SDL_max(0.0f, SDL_min((float)(SCREEN_WIDTH - 1), sprite.x));
+        }
+        if (sprite.y < 0 || sprite.y >= SCREEN_HEIGHT) {
+            sprite.vy = -sprite.vy;
+            sprite.y = SDL_max(0.0f, SDL_min((float)(SCREEN_HEIGHT - 1), sprite.y));
+        }
+    }
+}
+
+// Encoded image and where each decode job stores its result
+struct DecodeJob
+{
+    const void* png;
+    int size;
+    SDL_Surface** result;
+};
+
+static void decodeJob(LJob*, void* data)
+{
+    DecodeJob* decode = (DecodeJob*)data;
+    *decode->result = IMG_Load_RW(SDL_RWFromConstMem(decode->png, decode->size), 1);
+}
+
+// Root of the decode batch, spawns one child per image and finishes after all of them
+struct DecodeBatch
+{
+    const void* png;
+    int size;
+    SDL_Surface** results;
+    int count;
+};
+
+static void decodeBatchJob(LJob* job, void* data)
+{
+    DecodeBatch* batch = (DecodeBatch*)data;
+
+    for (int i = 0; i < batch->count; ++i) {
+        DecodeJob decode = {batch->png, batch->size, &batch->results[i]};
+        gJobSystem.run(gJobSystem.create(decodeJob, job, &decode, sizeof(decode)));
+    }
+}
+
+void runBenchmark()
+{
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    int cpuCount = SDL_GetCPUCount();
+
+    // Noisy gradient so the PNG takes real work to decode
+    std::vector<unsigned char> png(BENCHMARK_IMAGE_SIZE * BENCHMARK_IMAGE_SIZE * 8);
+    int pngSize = 0;
+    SDL_Surface* image = SDL_CreateRGBSurfaceWithFormat(0, BENCHMARK_IMAGE_SIZE, BENCHMARK_IMAGE_SIZE, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (image == NULL) {
+        printf("Failed to create benchmark image! SDL Error: %s\n", SDL_GetError());
+    } else {
+        for (int y = 0; y < image->h; ++y) {
+            Uint32* row = (Uint32*)((Uint8*)image->pixels + y * image->pitch);
+            for (int x = 0; x < image->w; ++x) {
+                row[x] = 0xFF000000 | (Uint32)(x & 0xFF) << 16 | (Uint32)(y & 0xFF) << 8 | (Uint32)(rand() & 0x3F);
+            }
+        }
+
+        SDL_RWops* rw = SDL_RWFromMem(&png[0], (int)png.size());
+        if (IMG_SavePNG_RW(image, rw, 0) == 0) {
+            pngSize = (int)SDL_RWtell(rw);
+        } else {
+            printf("Failed to encode benchmark image! SDL_Image Error: %s\n", IMG_GetError());
+        }
+        SDL_RWclose(rw);
+        SDL_FreeSurface(image);
+    }
+
+    std::vector<Sprite> sprites(BENCHMARK_SPRITES);
+    std::vector<SDL_Surface*> decoded(BENCHMARK_IMAGES, (SDL_Surface*)NULL);
+
+    double updateBaseline = 0;
+    double decodeBaseline = 0;
+
+    for (int threads = 1; threads <= cpuCount; ++threads) {
+        gJobSystem.start(threads);
+
+        spawnSprites(sprites);
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int frame = 0; frame < BENCHMARK_FRAMES; ++frame) {
+            gJobSystem.parallelFor(BENCHMARK_SPRITES, SPRITE_GRAIN, updateSprites, &sprites[0]);
+        }
+        double updateMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency / BENCHMARK_FRAMES;
+
+        double decodeMs = 0;
+        if (pngSize > 0) {
+            DecodeBatch batch = {&png[0], pngSize, &decoded[0], BENCHMARK_IMAGES};
+
+            start = SDL_GetPerformanceCounter();
+            LJob* root = gJobSystem.create(decodeBatchJob, NULL, &batch, sizeof(batch));
+            gJobSystem.run(root);
+            gJobSystem.wait(root);
+            decodeMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+
+            for (int i = 0; i < BENCHMARK_IMAGES; ++i) {
+                SDL_FreeSurface(decoded[i]);
+                decoded[i] = NULL;
+            }
+        }
+
+        if (threads == 1) {
+            updateBaseline = updateMs;
+            decodeBaseline = decodeMs;
+        }
+
+        printf("%2d threads: update %d sprites %7.2f ms (%.2fx), decode %d PNGs %7.2f ms (%.2fx), %llu steals\n",
+            threads, BENCHMARK_SPRITES, updateMs, updateBaseline / updateMs,
+            BENCHMARK_IMAGES, decodeMs, decodeMs > 0 ? decodeBaseline / decodeMs : 0.0,
+            (unsigned long long)gJobSystem.getSteals());
+
+        gJobSystem.stop();
+    }
+}
+
+bool init()
+{
+    bool success = true;
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        printf("SDL failed to initialize!\n");
+        success = false;
+    } else {
+        gWindow = SDL_CreateWindow("SDL Tutorial", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
+        if (gWindow == NULL) {
+            printf("Failed to create window! SDL Error: %s\n", SDL_GetError());
+            success = false;
+        } else {
+            gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+            if (gRenderer == NULL) {
+                printf("Failed to create renderer! SDL Error: %s\n", SDL_GetError());
+                success = false;
+            } else {
+                gJobSystem.start(SDL_GetCPUCount());
+            }
+        }
+    }
+
+    return success;
+}
+
+bool loadMedia()
+{
+    bool success = true;
+
+    gSprites.resize(DEMO_SPRITES);
+    spawnSprites(gSprites);
+
+    return success;
+}
+
+void close()
+{
+    gJobSystem.stop();
+
+    SDL_DestroyRenderer(gRenderer);
+    SDL_DestroyWindow(gWindow);
+    gWindow = NULL;
+    gRenderer = NULL;
+
+    SDL_Quit();
+}
+
+int main (int argc, char *argv[])
+{
+    // --bench times sprite updates and PNG decodes from 1 to SDL_GetCPUCount() threads
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        runBenchmark();
+        return 0;
+    }
+
+    if (!init()) {
+        printf("Failed to initialize!\n");
+    } else {
+        if (!loadMedia()) {
+            printf("Failed to load media!\n");
+        } else {
+            bool quit = false;
+
+            SDL_Event e;
+
+            std::vector<SDL_FPoint> points(DEMO_SPRITES);
+
+            while (!quit) {
+                while (SDL_PollEvent(&e) != 0) {
+                    if (e.type == SDL_QUIT) {
+                        quit = true;
+                    }
+                }
+
+                gJobSystem.parallelFor(DEMO_SPRITES, SPRITE_GRAIN, updateSprites, &gSprites[0]);
+
+                for (int i = 0; i < DEMO_SPRITES; ++i) {
+                    points[i].x = gSprites[i].x;
+                    points[i].y = gSprites[i].y;
+                }
+
+                SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+                SDL_RenderClear(gRenderer);
+
+                SDL_SetRenderDrawColor(gRenderer, 0x00, 0x00, 0x00, 0xFF);
+                SDL_RenderDrawPointsF(gRenderer, &points[0], DEMO_SPRITES);
+
+                SDL_RenderPresent(gRenderer);
+            }
+        }
+    }
+
+    close();
+
+    return 0;
+}
@@ -1,14 +1,31 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_error.h>
 #include <SDL2/SDL_events.h>
+#include <SDL2/SDL_mouse.h>
+#include <SDL2/SDL_rwops.h>
+#include <SDL2/SDL_scancode.h>
 #include <SDL2/SDL_surface.h>
 #include <SDL2/SDL_video.h>
+#include <atomic>
+#include <bitset>
+#include <condition_variable>
 #include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 480;
 
+// Input recording header and the event types it stores, indexed by each record's type byte
+const char INPUT_LOG_MAGIC[] = "LINP";
+const Uint16 INPUT_LOG_VERSION = 1;
+const Uint32 INPUT_RECORD_TYPES[] = {SDL_QUIT, SDL_KEYDOWN, SDL_KEYUP, SDL_MOUSEMOTION, SDL_MOUSEBUTTONDOWN, SDL_MOUSEBUTTONUP};
+const int INPUT_RECORD_TYPE_COUNT = 6;
+
 enum KeyPressSurfaces {
     KEY_PRESS_SURFACE_DEFAULT,
     KEY_PRESS_SURFACE_UP,
@@ -18,6 +35,216 @@ enum KeyPressSurfaces {
     KEY_PRESS_SURFACE_TOTAL
 };
 
+// Actions that select a direction image
+enum InputAction {
+    INPUT_ACTION_UP,
+    INPUT_ACTION_DOWN,
+    INPUT_ACTION_LEFT,
+    INPUT_ACTION_RIGHT,
+    INPUT_ACTION_TOTAL
+};
+
+class LInput {
+    public:
+        // Initialize
+        LInput();
+
+        // Lets an event type through the event filter
+        void subscribe(Uint32 type);
+
+        // Installs the event filter, drops every type nobody subscribed to
+        void installFilter();
+
+        // Maps action to scancode
+        void bindAction(int action, SDL_Scancode scancode);
+
+        // Drains the event queue, call once per frame
+        void update();
+
+        // Whether the user requested quit
+        bool quitRequested();
+
+        // Key state and edges of the last update
+        bool isKeyDown(SDL_Scancode scancode);
+        bool wasKeyPressed(SDL_Scancode scancode);
+        bool wasKeyReleased(SDL_Scancode scancode);
+        bool anyKeyPressed();
+
+        // Action state and edges of the last update
+        bool isActionDown(int action);
+        bool wasActionPressed(int action);
+        bool wasActionReleased(int action);
+
+        // Mouse position and motion delta coalesced over the last update
+        int getMouseX();
+        int getMouseY();
+        int getMouseDeltaX();
+        int getMouseDeltaY();
+        bool mouseMoved();
+
+        // Mouse button state and edges of the last update
+        bool isButtonDown(Uint8 button);
+        bool wasButtonPressed(Uint8 button);
+        bool wasButtonReleased(Uint8 button);
+
+        // Prints events per frame before and after filtering and coalescing
+        void printStats();
+
+        // Writes every dispatched event with its frame number to path
+        bool startRecording(std::string path);
+        void stopRecording();
+
+        // Pushes the events recorded at path on the frames they were recorded on,
+        // then requests quit after the last one
+        bool startReplay(std::string path);
+        bool isReplaying();
+
+    private:
+        // Counts every pushed event and rejects unsubscribed types
+        static int eventFilter(void* userdata, SDL_Event* e);
+
+        // Event types let through the filter
+        std::bitset<SDL_LASTEVENT + 1> mSubscribed;
+
+        // Key state and per frame edge masks
+        std::bitset<SDL_NUM_SCANCODES> mKeysDown;
+        std::bitset<SDL_NUM_SCANCODES> mKeysPressed;
+        std::bitset<SDL_NUM_SCANCODES> mKeysReleased;
+
+        // Action to scancode table, indexed by action
+        std::vector<SDL_Scancode> mActionBindings;
+
+        // Mouse state
+        int mMouseX;
+        int mMouseY;
+        int mMouseDeltaX;
+        int mMouseDeltaY;
+        bool mMouseMoved;
+        Uint32 mButtonsDown;
+        Uint32 mButtonsPressed;
+        Uint32 mButtonsReleased;
+
+        bool mQuit;
+
+        // Event counters, the filter may run on another thread
+        std::atomic<Uint64> mPushedEvents;
+        std::atomic<Uint64> mAcceptedEvents;
+        Uint64 mDispatchedEvents;
+        Uint64 mFrames;
+
+        // Record of an input event, false for types not recorded
+        static bool writeEvent(SDL_RWops* log, Uint32 frame, const SDL_Event& e);
+
+        // Reads the next record, false at the end of the log
+        static bool readEvent(SDL_RWops* log, Uint32* frame, SDL_Event* e);
+
+        // Open recording, NULL when not recording
+        SDL_RWops* mRecording;
+
+        // Events of the replayed log with their frames and the next one to push
+        std::vector<SDL_Event> mReplayEvents;
+        std::vector<Uint32> mReplayFrames;
+        size_t mReplayNext;
+        bool mReplaying;
+};
+
+// Image known only by path until it is prefetched or first used
+class LLazySurface {
+    public:
+        // Initialize
+        LLazySurface();
+
+        // Deallocate
+        ~LLazySurface();
+
+        // Remembers where the image lives, nothing is read yet
+        void setPath(std::string path);
+
+        // Hints the image will be needed soon, queues it on the loader thread
+        void prefetch();
+
+        // Decoded image, decoding or waiting for the loader on first use, NULL if it failed
+        SDL_Surface* get();
+
+        // Takes the image for decoding, false if another thread already has it
+        bool claim();
+
+        // Loader thread, takes the image only if it is still queued, so one dropped
+        // by free after it was queued is not decoded again
+        bool claimQueued();
+
+        // Reads the image after a successful claim and wakes anyone waiting
+        void decode();
+
+        // Deallocates the image, waiting for a decode in flight
+        void free();
+
+    private:
+        enum State {
+            LAZY_UNLOADED,
+            LAZY_QUEUED,
+            LAZY_DECODING,
+            LAZY_READY,
+            LAZY_FAILED
+        };
+
+        // Blocks until the decode in flight is done
+        void waitForDecode();
+
+        std::string mPath;
+        SDL_Surface* mSurface;
+
+        // Set by the decoding thread with release, surface is valid once READY
+        std::atomic<int> mState;
+
+        // First use already counted
+        bool mUsed;
+
+        std::mutex mMutex;
+        std::condition_variable mDecoded;
+};
+
+// Decodes prefetched images on one worker thread
+class LSurfaceLoader {
+    public:
+        // Initialize
+        LSurfaceLoader();
+
+        // Starts the worker
+        void start();
+
+        // Stops the worker, images still queued are decoded on first use instead
+        void stop();
+
+        // Queues an image, earlier hints are decoded first
+        void enqueue(LLazySurface* image);
+
+        // Records a first use and how long it blocked
+        void recordFirstUse(bool stalled, double milliseconds);
+
+        // Prints first uses, stalls and prefetched decodes
+        void printStats();
+
+    private:
+        // Worker loop
+        void run();
+
+        std::thread mThread;
+        std::mutex mMutex;
+        std::condition_variable mQueued;
+        std::deque<LLazySurface*> mQueue;
+        bool mRunning;
+
+        // Decodes finished on the worker before anyone asked
+        std::atomic<int> mPrefetched;
+
+        // Main thread only
+        int mFirstUses;
+        int mStalls;
+        double mStallMs;
+        double mWorstStallMs;
+};
+
 // Starts up SDL and creates window
 bool init();
 
@@ -36,11 +263,528 @@ SDL_Window* gWindow = NULL;
 // The surface contained by the window
 SDL_Surface* gScreenSurface = NULL;
 
-// The images that corresponds to a keypress
-SDL_Surface* gKeyPressSurfaces[ KEY_PRESS_SURFACE_TOTAL ];
+// Decodes images ahead of their first use
+LSurfaceLoader gSurfaceLoader;
+
+// The images that corresponds to a keypress, read on first use
+LLazySurface gKeyPressSurfaces[ KEY_PRESS_SURFACE_TOTAL ];
 
 // Current display image
-SDL_Surface* gCurrentSurface = NULL;
+int gCurrentSurface = KEY_PRESS_SURFACE_DEFAULT;
+
+// Per frame keyboard state
+LInput gInput;
+
+LInput::LInput() {
+    mMouseX = 0;
+    mMouseY = 0;
+    mMouseDeltaX = 0;
+    mMouseDeltaY = 0;
+    mMouseMoved = false;
+    mButtonsDown = 0;
+    mButtonsPressed = 0;
+    mButtonsReleased = 0;
+
+    mQuit = false;
+
+    mPushedEvents = 0;
+    mAcceptedEvents = 0;
+    mDispatchedEvents = 0;
+    mFrames = 0;
+
+    mRecording = NULL;
+    mReplayNext = 0;
+    mReplaying = false;
+
+    // Quit and window events are always wanted
+    subscribe(SDL_QUIT);
+    subscribe(SDL_WINDOWEVENT);
+}
+
+void LInput::subscribe(Uint32 type) {
+    mSubscribed.set(type);
+}
+
+void LInput::installFilter() {
+    SDL_SetEventFilter(eventFilter, this);
+}
+
+int LInput::eventFilter(void* userdata, SDL_Event* e) {
+    LInput* input = (LInput*)userdata;
+
+    ++input->mPushedEvents;
+    if (!input->mSubscribed.test(e->type)) {
+        return 0;
+    }
+
+    ++input->mAcceptedEvents;
+    return 1;
+}
+
+void LInput::bindAction(int action, SDL_Scancode scancode) {
+    if (action >= (int)mActionBindings.size()) {
+        mActionBindings.resize(action + 1, SDL_SCANCODE_UNKNOWN);
+    }
+
+    mActionBindings[action] = scancode;
+}
+
+void LInput::update() {
+    // Clear edges of the previous frame
+    mKeysPressed.reset();
+    mKeysReleased.reset();
+    mButtonsPressed = 0;
+    mButtonsReleased = 0;
+    mMouseDeltaX = 0;
+    mMouseDeltaY = 0;
+    mMouseMoved = false;
+
+    // Replayed events go through the filter and the queue like live ones
+    if (mReplaying) {
+        while (mReplayNext < mReplayEvents.size() && mReplayFrames[mReplayNext] <= mFrames) {
+            SDL_PushEvent(&mReplayEvents[mReplayNext]);
+            ++mReplayNext;
+        }
+    }
+
+    SDL_Event e;
+    while (SDL_PollEvent(&e) != 0) {
+        if (mRecording != NULL) {
+            writeEvent(mRecording, (Uint32)mFrames, e);
+        }
+
+        switch (e.type) {
+            case SDL_QUIT:
+            mQuit = true;
+            ++mDispatchedEvents;
+            break;
+
+            case SDL_KEYDOWN:
+            if (!e.key.repeat) {
+                mKeysDown.set(e.key.keysym.scancode);
+                mKeysPressed.set(e.key.keysym.scancode);
+            }
+            ++mDispatchedEvents;
+            break;
+
+            case SDL_KEYUP:
+            mKeysDown.reset(e.key.keysym.scancode);
+            mKeysReleased.set(e.key.keysym.scancode);
+            ++mDispatchedEvents;
+            break;
+
+            // Consecutive motion events collapse into one delta
+            case SDL_MOUSEMOTION:
+            mMouseX = e.motion.x;
+            mMouseY = e.motion.y;
+            mMouseDeltaX += e.motion.xrel;
+            mMouseDeltaY += e.motion.yrel;
+            if (!mMouseMoved) {
+                mMouseMoved = true;
+                ++mDispatchedEvents;
+            }
+            break;
+
+            case SDL_MOUSEBUTTONDOWN:
+            mMouseX = e.button.x;
+            mMouseY = e.button.y;
+            mButtonsDown |= SDL_BUTTON(e.button.button);
+            mButtonsPressed |= SDL_BUTTON(e.button.button);
+            ++mDispatchedEvents;
+            break;
+
+            case SDL_MOUSEBUTTONUP:
+            mMouseX = e.button.x;
+            mMouseY = e.button.y;
+            mButtonsDown &= ~SDL_BUTTON(e.button.button);
+            mButtonsReleased |= SDL_BUTTON(e.button.button);
+            ++mDispatchedEvents;
+            break;
+        }
+    }
+
+    if (mReplaying && mReplayNext == mReplayEvents.size()) {
+        mQuit = true;
+    }
+
+    ++mFrames;
+}
+
+bool LInput::quitRequested() {
+    return mQuit;
+}
+
+bool LInput::isKeyDown(SDL_Scancode scancode) {
+    return mKeysDown.test(scancode);
+}
+
+bool LInput::wasKeyPressed(SDL_Scancode scancode) {
+    return mKeysPressed.test(scancode);
+}
+
+bool LInput::wasKeyReleased(SDL_Scancode scancode) {
+    return mKeysReleased.test(scancode);
+}
+
+bool LInput::anyKeyPressed() {
+    return mKeysPressed.any();
+}
+
+bool LInput::isActionDown(int action) {
+    return action < (int)mActionBindings.size() && isKeyDown(mActionBindings[action]);
+}
+
+bool LInput::wasActionPressed(int action) {
+    return action < (int)mActionBindings.size() && wasKeyPressed(mActionBindings[action]);
+}
+
+bool LInput::wasActionReleased(int action) {
+    return action < (int)mActionBindings.size() && wasKeyReleased(mActionBindings[action]);
+}
+
+int LInput::getMouseX() {
+    return mMouseX;
+}
+
+int LInput::getMouseY() {
+    return mMouseY;
+}
+
+int LInput::getMouseDeltaX() {
+    return mMouseDeltaX;
+}
+
+int LInput::getMouseDeltaY() {
+    return mMouseDeltaY;
+}
+
+bool LInput::mouseMoved() {
+    return mMouseMoved;
+}
+
+bool LInput::isButtonDown(Uint8 button) {
+    return (mButtonsDown & SDL_BUTTON(button)) != 0;
+}
+
+bool LInput::wasButtonPressed(Uint8 button) {
+    return (mButtonsPressed & SDL_BUTTON(button)) != 0;
+}
+
+bool LInput::wasButtonReleased(Uint8 button) {
+    return (mButtonsReleased & SDL_BUTTON(button)) != 0;
+}
+
+bool LInput::startRecording(std::string path) {
+    mRecording = SDL_RWFromFile(path.c_str(), "wb");
+    if (mRecording == NULL) {
+        printf("Failed to create input recording %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+        return false;
+    }
+
+    SDL_RWwrite(mRecording, INPUT_LOG_MAGIC, 4, 1);
+    SDL_WriteLE16(mRecording, INPUT_LOG_VERSION);
+
+    return true;
+}
+
+void LInput::stopRecording() {
+    if (mRecording != NULL) {
+        SDL_RWclose(mRecording);
+        mRecording = NULL;
+    }
+}
+
+bool LInput::startReplay(std::string path) {
+    SDL_RWops* log = SDL_RWFromFile(path.c_str(), "rb");
+    if (log == NULL) {
+        printf("Failed to open input recording %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+        return false;
+    }
+
+    char magic[4];
+    bool success = SDL_RWread(log, magic, 4, 1) == 1 && memcmp(magic, INPUT_LOG_MAGIC, 4) == 0 && SDL_ReadLE16(log) == INPUT_LOG_VERSION;
+    if (!success) {
+        printf("%s is not an input recording!\n", path.c_str());
+    } else {
+        mReplayEvents.clear();
+        mReplayFrames.clear();
+
+        Uint32 frame;
+        SDL_Event e;
+        while (readEvent(log, &frame, &e)) {
+            mReplayEvents.push_back(e);
+            mReplayFrames.push_back(frame);
+        }
+
+        mReplayNext = 0;
+        mReplaying = true;
+    }
+
+    SDL_RWclose(log);
+    return success;
+}
+
+bool LInput::isReplaying() {
+    return mReplaying;
+}
+
+bool LInput::writeEvent(SDL_RWops* log, Uint32 frame, const SDL_Event& e) {
+    int kind = 0;
+    while (kind < INPUT_RECORD_TYPE_COUNT && INPUT_RECORD_TYPES[kind] != e.type) {
+        ++kind;
+    }
+    if (kind == INPUT_RECORD_TYPE_COUNT) {
+        return false;
+    }
+
+    // Only the fields LInput reads, a key press takes 14 bytes instead of a whole SDL_Event
+    SDL_WriteU8(log, (Uint8)kind);
+    SDL_WriteLE32(log, frame);
+
+    switch (e.type) {
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+        SDL_WriteLE16(log, (Uint16)e.key.keysym.scancode);
+        SDL_WriteLE32(log, (Uint32)e.key.keysym.sym);
+        SDL_WriteLE16(log, e.key.keysym.mod);
+        SDL_WriteU8(log, e.key.repeat);
+        break;
+
+        case SDL_MOUSEMOTION:
+        SDL_WriteLE32(log, e.motion.state);
+        SDL_WriteLE16(log, (Uint16)e.motion.x);
+        SDL_WriteLE16(log, (Uint16)e.motion.y);
+        SDL_WriteLE16(log, (Uint16)e.motion.xrel);
+        SDL_WriteLE16(log, (Uint16)e.motion.yrel);
+        break;
+
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+        SDL_WriteU8(log, e.button.button);
+        SDL_WriteU8(log, e.button.clicks);
+        SDL_WriteLE16(log, (Uint16)e.button.x);
+        SDL_WriteLE16(log, (Uint16)e.button.y);
+        break;
+    }
+
+    return true;
+}
+
+bool LInput::readEvent(SDL_RWops* log, Uint32* frame, SDL_Event* e) {
+    Uint8 kind;
+    if (SDL_RWread(log, &kind, 1, 1) != 1 || kind >= INPUT_RECORD_TYPE_COUNT) {
+        return false;
+    }
+
+    SDL_zerop(e);
+    e->type = INPUT_RECORD_TYPES[kind];
+    *frame = SDL_ReadLE32(log);
+
+    switch (e->type) {
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+        e->key.state = e->type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+        e->key.keysym.scancode = (SDL_Scancode)SDL_ReadLE16(log);
+        e->key.keysym.sym = (SDL_Keycode)SDL_ReadLE32(log);
+        e->key.keysym.mod = SDL_ReadLE16(log);
+        e->key.repeat = SDL_ReadU8(log);
+        break;
+
+        case SDL_MOUSEMOTION:
+        e->motion.state = SDL_ReadLE32(log);
+        e->motion.x = (Sint16)SDL_ReadLE16(log);
+        e->motion.y = (Sint16)SDL_ReadLE16(log);
+        e->motion.xrel = (Sint16)SDL_ReadLE16(log);
+        e->motion.yrel = (Sint16)SDL_ReadLE16(log);
+        break;
+
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+        e->button.button = SDL_ReadU8(log);
+        e->button.state = e->type == SDL_MOUSEBUTTONDOWN ? SDL_PRESSED : SDL_RELEASED;
+        e->button.clicks = SDL_ReadU8(log);
+        e->button.x = (Sint16)SDL_ReadLE16(log);
+        e->button.y = (Sint16)SDL_ReadLE16(log);
+        break;
+    }
+
+    return true;
+}
+
+void LInput::printStats() {
+    if (mFrames == 0) {
+        return;
+    }
+
+    double frames = (double)mFrames;
+    printf("Input: %llu frames, events per frame: %.2f pushed, %.2f after filter, %.2f after coalescing\n",
+        (unsigned long long)mFrames, mPushedEvents / frames, mAcceptedEvents / frames, mDispatchedEvents / frames);
+}
+
+LLazySurface::LLazySurface() {
+    mSurface = NULL;
+    mState = LAZY_UNLOADED;
+    mUsed = false;
+}
+
+LLazySurface::~LLazySurface() {
+    free();
+}
+
+void LLazySurface::setPath(std::string path) {
+    free();
+    mPath = path;
+}
+
+void LLazySurface::prefetch() {
+    int expected = LAZY_UNLOADED;
+    if (mState.compare_exchange_strong(expected, LAZY_QUEUED)) {
+        gSurfaceLoader.enqueue(this);
+    }
+}
+
+SDL_Surface* LLazySurface::get() {
+    if (mUsed) {
+        return mSurface;
+    }
+
+    // First use blocks only if the loader has not finished, or never got the hint
+    Uint64 start = SDL_GetPerformanceCounter();
+    int state = mState.load(std::memory_order_acquire);
+    bool stalled = state != LAZY_READY && state != LAZY_FAILED;
+    if (stalled) {
+        if (claim()) {
+            decode();
+        } else {
+            waitForDecode();
+        }
+    }
+
+    mUsed = true;
+    gSurfaceLoader.recordFirstUse(stalled, (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency());
+
+    return mSurface;
+}
+
+bool LLazySurface::claim() {
+    int expected = LAZY_QUEUED;
+    if (mState.compare_exchange_strong(expected, LAZY_DECODING)) {
+        return true;
+    }
+
+    expected = LAZY_UNLOADED;
+    return mState.compare_exchange_strong(expected, LAZY_DECODING);
+}
+
+bool LLazySurface::claimQueued() {
+    int expected = LAZY_QUEUED;
+    return mState.compare_exchange_strong(expected, LAZY_DECODING);
+}
+
+void LLazySurface::decode() {
+    SDL_Surface* surface = loadSurface( mPath );
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSurface = surface;
+    mState.store(surface != NULL ? LAZY_READY : LAZY_FAILED, std::memory_order_release);
+    mDecoded.notify_all();
+}
+
+void LLazySurface::waitForDecode() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDecoded.wait(lock, [this] {
+        int state = mState.load(std::memory_order_acquire);
+        return state == LAZY_READY || state == LAZY_FAILED;
+    });
+}
+
+void LLazySurface::free() {
+    // A queued image is dropped, one being decoded has to finish first
+    int expected = LAZY_QUEUED;
+    if (!mState.compare_exchange_strong(expected, LAZY_UNLOADED) && expected == LAZY_DECODING) {
+        waitForDecode();
+    }
+
+    SDL_FreeSurface( mSurface );
+    mSurface = NULL;
+    mState = LAZY_UNLOADED;
+    mUsed = false;
+}
+
+LSurfaceLoader::LSurfaceLoader() {
+    mRunning = false;
+    mPrefetched = 0;
+    mFirstUses = 0;
+    mStalls = 0;
+    mStallMs = 0;
+    mWorstStallMs = 0;
+}
+
+void LSurfaceLoader::start() {
+    if (mRunning) {
+        return;
+    }
+
+    mRunning = true;
+    mThread = std::thread(&LSurfaceLoader::run, this);
+}
+
+void LSurfaceLoader::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRunning = false;
+        mQueue.clear();
+    }
+    mQueued.notify_all();
+
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+}
+
+void LSurfaceLoader::enqueue(LLazySurface* image) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueue.push_back(image);
+    }
+    mQueued.notify_one();
+}
+
+void LSurfaceLoader::run() {
+    while (true) {
+        LLazySurface* image = NULL;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mQueued.wait(lock, [this] { return !mRunning || !mQueue.empty(); });
+            if (!mRunning) {
+                break;
+            }
+
+            image = mQueue.front();
+            mQueue.pop_front();
+        }
+
+        // The main thread may have needed it first or dropped it
+        if (image->claimQueued()) {
+            image->decode();
+            ++mPrefetched;
+        }
+    }
+}
+
+void LSurfaceLoader::recordFirstUse(bool stalled, double milliseconds) {
+    ++mFirstUses;
+    if (stalled) {
+        ++mStalls;
+        mStallMs += milliseconds;
+        mWorstStallMs = SDL_max(mWorstStallMs, milliseconds);
+    }
+}
+
+void LSurfaceLoader::printStats() {
+    printf("Images: %d first uses, %d stalled for %.3f ms total (worst %.3f ms), %d decoded ahead on the loader\n",
+        mFirstUses, mStalls, mStallMs, mWorstStallMs, (int)mPrefetched);
+}
 
 bool init() {
     // Initialization flag
@@ -65,11 +809,16 @@ bool init() {
 }
 
 void close() {
+    gInput.printStats();
+
+    // Nothing may be decoding while surfaces are freed
+    gSurfaceLoader.stop();
+    gSurfaceLoader.printStats();
+
     //Deallocate surfaces
     for( int i = 0; i < KEY_PRESS_SURFACE_TOTAL; ++i )
     {
-        SDL_FreeSurface( gKeyPressSurfaces[ i ] );
-        gKeyPressSurfaces[ i ] = NULL;
+        gKeyPressSurfaces[ i ].free();
     }
 
     SDL_DestroyWindow( gWindow );
@@ -92,38 +841,23 @@ bool loadMedia() {
     // Loading success flag;
     bool success = true;
 
-    // Load default surface
-    gKeyPressSurfaces[ KEY_PRESS_SURFACE_DEFAULT ] = loadSurface( "press.bmp" );
-    if ( gKeyPressSurfaces[ KEY_PRESS_SURFACE_DEFAULT ] == NULL) {
-        printf( "Failed to load default image\n" );
-        success = false;
-    }
-
-    // Load up surface
-    gKeyPressSurfaces[ KEY_PRESS_SURFACE_UP ] = loadSurface( "up.bmp" );
-    if ( gKeyPressSurfaces[ KEY_PRESS_SURFACE_UP ] == NULL) {
-        printf( "Failed to load up image\n" );
-        success = false;
-    }
-
-    // Load down surface
-    gKeyPressSurfaces[ KEY_PRESS_SURFACE_DOWN ] = loadSurface( "down.bmp" );
-    if ( gKeyPressSurfaces[ KEY_PRESS_SURFACE_DOWN ] == NULL) {
-        printf( "Failed to load down image\n" );
-        success = false;
-    }
+    // Paths only, images are read when first shown
+    gKeyPressSurfaces[ KEY_PRESS_SURFACE_DEFAULT ].setPath( "press.bmp" );
+    gKeyPressSurfaces[ KEY_PRESS_SURFACE_UP ].setPath( "up.bmp" );
+    gKeyPressSurfaces[ KEY_PRESS_SURFACE_DOWN ].setPath( "down.bmp" );
+    gKeyPressSurfaces[ KEY_PRESS_SURFACE_LEFT ].setPath( "left.bmp" );
+    gKeyPressSurfaces[ KEY_PRESS_SURFACE_RIGHT ].setPath( "right.bmp" );
 
-    // Load left surface
-    gKeyPressSurfaces[ KEY_PRESS_SURFACE_LEFT ] = loadSurface( "left.bmp" );
-    if ( gKeyPressSurfaces[ KEY_PRESS_SURFACE_LEFT ] == NULL) {
-        printf( "Failed to load left image\n" );
-        success = false;
+    // Every direction is one key press away, decode them while the default image is up
+    gSurfaceLoader.start();
+    for( int i = KEY_PRESS_SURFACE_UP; i < KEY_PRESS_SURFACE_TOTAL; ++i )
+    {
+        gKeyPressSurfaces[ i ].prefetch();
     }
 
-    // Load right surface
-    gKeyPressSurfaces[ KEY_PRESS_SURFACE_RIGHT ] = loadSurface( "right.bmp" );
-    if ( gKeyPressSurfaces[ KEY_PRESS_SURFACE_RIGHT ] == NULL) {
-        printf( "Failed to load right image\n" );
+    // The first frame needs the default image right away
+    if ( gKeyPressSurfaces[ KEY_PRESS_SURFACE_DEFAULT ].get() == NULL) {
+        printf( "Failed to load default image\n" );
         success = false;
     }
 
@@ -131,51 +865,76 @@ bool loadMedia() {
 }
 
 int main (int argc, char *argv[]) {
+    // --record <log> saves the input of the session, --replay <log> plays it back
+    // under the dummy video driver and prints timing and a digest of the shown images
+    std::string mode = argc > 1 ? argv[1] : "";
+    if ((mode == "--record" || mode == "--replay") && argc < 3) {
+        printf("Usage: %s %s <log>\n", argv[0], mode.c_str());
+        return 1;
+    }
+
+    // Nothing but the log can feed input then
+    if (mode == "--replay") {
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    }
+
     if ( !init() ) {
         printf("Failed to initialize\n");
     } else {
         if ( !loadMedia() ) {
             printf("Failed to load media!\n");
         } else {
-            bool quit = false;
-
-            SDL_Event e;
-
-            gCurrentSurface = gKeyPressSurfaces[ KEY_PRESS_SURFACE_DEFAULT ];
-
-            while (!quit) {
-                while (SDL_PollEvent( &e ) != 0) {
-                    if (e.type == SDL_QUIT) {
-                        quit = true;
-                    } else if (e.type == SDL_KEYDOWN) {
-                        switch (e.key.keysym.sym) {
-                            case SDLK_UP:
-                            gCurrentSurface = gKeyPressSurfaces[KEY_PRESS_SURFACE_UP];
-                            break;
-
-                            case SDLK_DOWN:
-                            gCurrentSurface = gKeyPressSurfaces[KEY_PRESS_SURFACE_DOWN];
-                            break;
-
-                            case SDLK_LEFT:
-                            gCurrentSurface = gKeyPressSurfaces[KEY_PRESS_SURFACE_LEFT];
-                            break;
-
-                            case SDLK_RIGHT:
-                            gCurrentSurface = gKeyPressSurfaces[KEY_PRESS_SURFACE_RIGHT];
-                            break;
-
-                            default:
-                            gCurrentSurface = gKeyPressSurfaces[KEY_PRESS_SURFACE_DEFAULT];
-                            break;
-                        }
-                    }
+            gCurrentSurface = KEY_PRESS_SURFACE_DEFAULT;
+
+            gInput.bindAction( INPUT_ACTION_UP, SDL_SCANCODE_UP );
+            gInput.bindAction( INPUT_ACTION_DOWN, SDL_SCANCODE_DOWN );
+            gInput.bindAction( INPUT_ACTION_LEFT, SDL_SCANCODE_LEFT );
+            gInput.bindAction( INPUT_ACTION_RIGHT, SDL_SCANCODE_RIGHT );
+            gInput.subscribe( SDL_KEYDOWN );
+            gInput.subscribe( SDL_KEYUP );
+            gInput.installFilter();
+
+            bool ready = true;
+            if (mode == "--record") {
+                ready = gInput.startRecording(argv[2]);
+            } else if (mode == "--replay") {
+                ready = gInput.startReplay(argv[2]);
+            }
+
+            // FNV-1a over the image shown each frame, equal digests mean identical runs
+            Uint32 digest = 2166136261u;
+            int frames = 0;
+            Uint64 start = SDL_GetPerformanceCounter();
+
+            while (ready && !gInput.quitRequested()) {
+                gInput.update();
+
+                if (gInput.wasActionPressed( INPUT_ACTION_UP )) {
+                    gCurrentSurface = KEY_PRESS_SURFACE_UP;
+                } else if (gInput.wasActionPressed( INPUT_ACTION_DOWN )) {
+                    gCurrentSurface = KEY_PRESS_SURFACE_DOWN;
+                } else if (gInput.wasActionPressed( INPUT_ACTION_LEFT )) {
+                    gCurrentSurface = KEY_PRESS_SURFACE_LEFT;
+                } else if (gInput.wasActionPressed( INPUT_ACTION_RIGHT )) {
+                    gCurrentSurface = KEY_PRESS_SURFACE_RIGHT;
+                } else if (gInput.anyKeyPressed()) {
+                    gCurrentSurface = KEY_PRESS_SURFACE_DEFAULT;
                 }
 
-                SDL_BlitSurface(gCurrentSurface, NULL, gScreenSurface, NULL);
+                SDL_BlitSurface(gKeyPressSurfaces[gCurrentSurface].get(), NULL, gScreenSurface, NULL);
 
                 SDL_UpdateWindowSurface(gWindow);
+
+                digest = (digest ^ (Uint32)gCurrentSurface) * 16777619u;
+                ++frames;
             }
+
+            if (gInput.isReplaying() && frames > 0) {
+                double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+                printf("Replayed %d frames, %.3f ms/frame, image digest %08x\n", frames, ms / frames, digest);
+            }
+
+            gInput.stopRecording();
         }
     }
 
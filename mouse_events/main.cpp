@@ -7,17 +7,37 @@
 #include <SDL2/SDL_pixels.h>
 #include <SDL2/SDL_rect.h>
 #include <SDL2/SDL_render.h>
+#include <SDL2/SDL_rwops.h>
 #include <SDL2/SDL_stdinc.h>
 #include <SDL2/SDL_surface.h>
 #include <SDL2/SDL_video.h>
+#include <atomic>
+#include <bitset>
+#include <cerrno>
+#include <cmath>
 #include <cstddef>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <string>
+#include <vector>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 // Screen size constants
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 480;
 
+// Input recording header and the event types it stores, indexed by each record's type byte
+const char INPUT_LOG_MAGIC[] = "LINP";
+const Uint16 INPUT_LOG_VERSION = 1;
+const Uint32 INPUT_RECORD_TYPES[] = {SDL_QUIT, SDL_KEYDOWN, SDL_KEYUP, SDL_MOUSEMOTION, SDL_MOUSEBUTTONDOWN, SDL_MOUSEBUTTONUP};
+const int INPUT_RECORD_TYPE_COUNT = 6;
+
 // Button constants
 const int BUTTON_WIDTH = 300;
 const int BUTTON_HEIGHT = 200;
@@ -77,6 +97,244 @@ class LTexture
         int mHeight;
 };
 
+// Parsed JSON document, only as much as sprite sheet exports need
+struct LJsonValue
+{
+    enum Type
+    {
+        JSON_NULL,
+        JSON_BOOL,
+        JSON_NUMBER,
+        JSON_STRING,
+        JSON_ARRAY,
+        JSON_OBJECT
+    };
+
+    Type type;
+    bool boolean;
+    double number;
+    std::string string;
+
+    // Array elements, or object values in the order of keys
+    std::vector<LJsonValue> items;
+    std::vector<std::string> keys;
+
+    LJsonValue();
+
+    // Member of an object, NULL when missing
+    const LJsonValue* get(const char* key) const;
+
+    // Number or bool member of an object, fallback when missing
+    double getNumber(const char* key, double fallback) const;
+};
+
+// Frame of a sprite sheet, stored as is in the binary sidecar
+struct LSpriteFrame
+{
+    // Rectangle in the sheet texture, rotated clips are kept as exported
+    SDL_Rect clip;
+    Sint32 rotated;
+
+    // Where the trimmed clip sits in the untrimmed frame, and that frame's size
+    Sint32 offsetX;
+    Sint32 offsetY;
+    Sint32 sourceWidth;
+    Sint32 sourceHeight;
+
+    // Pivot relative to the untrimmed frame, 0 to 1
+    float pivotX;
+    float pivotY;
+
+    // Milliseconds shown when animated
+    Sint32 duration;
+
+    // Start of the name in the name table
+    Uint32 nameOffset;
+};
+
+// Sidecar layout: this header, the frames, then the NUL terminated names
+struct LSpriteSheetHeader
+{
+    char magic[4];
+    Uint32 version;
+    Uint32 frameSize;
+    Uint32 frameCount;
+    Uint32 namesSize;
+    Uint32 padding;
+
+    // JSON the sidecar was built from, a mismatch means rebuild
+    Sint64 jsonSize;
+    Sint64 jsonModified;
+};
+
+// Frames of an Aseprite or TexturePacker JSON export, array or hash layout
+class LSpriteSheet
+{
+    public:
+        // Initialize
+        LSpriteSheet();
+
+        // Deallocate
+        ~LSpriteSheet();
+
+        // Loads the export at path from its binary sidecar when that is current,
+        // otherwise parses the JSON and writes the sidecar for next time
+        bool loadFromFile(std::string path);
+
+        // Deallocate frames
+        void free();
+
+        int getFrameCount();
+
+        // Frame by index in export order
+        const LSpriteFrame& getFrame(int index);
+        SDL_Rect* getClip(int index);
+        const char* getName(int index);
+
+        // Index of the named frame, -1 when missing
+        int findFrame(std::string name);
+
+        // Index of the frame showing at milliseconds into the looped animation
+        int getFrameAt(double milliseconds);
+
+        // Whether the last load came from the sidecar
+        bool isFromSidecar();
+
+    private:
+        // Fills mParsedFrames and mParsedNames from JSON
+        bool parseExport(std::string path);
+
+        // Maps sidecar if it was built from a JSON of this size and time, reads it where mmap is unavailable
+        bool loadSidecar(std::string path, Sint64 jsonSize, Sint64 jsonModified);
+
+        // Releases what loadSidecar mapped or read
+        static void unloadSidecar(void* mapping, size_t size);
+
+        // Writes parsed frames next to the JSON
+        void writeSidecar(std::string path, Sint64 jsonSize, Sint64 jsonModified);
+
+        // Frames and names, pointing into the mapped sidecar or the parsed copies
+        LSpriteFrame* mFrames;
+        const char* mNames;
+        int mFrameCount;
+        double mTotalDuration;
+
+        std::vector<LSpriteFrame> mParsedFrames;
+        std::string mParsedNames;
+
+        // Sidecar mapping or copy, NULL when parsed
+        void* mMapping;
+        size_t mMappingSize;
+};
+
+class LInput
+{
+    public:
+        // Initialize
+        LInput();
+
+        // Lets an event type through the event filter
+        void subscribe(Uint32 type);
+
+        // Installs the event filter, drops every type nobody subscribed to
+        void installFilter();
+
+        // Maps action to scancode
+        void bindAction(int action, SDL_Scancode scancode);
+
+        // Drains the event queue, call once per frame
+        void update();
+
+        // Whether the user requested quit
+        bool quitRequested();
+
+        // Key state and edges of the last update
+        bool isKeyDown(SDL_Scancode scancode);
+        bool wasKeyPressed(SDL_Scancode scancode);
+        bool wasKeyReleased(SDL_Scancode scancode);
+        bool anyKeyPressed();
+
+        // Action state and edges of the last update
+        bool isActionDown(int action);
+        bool wasActionPressed(int action);
+        bool wasActionReleased(int action);
+
+        // Mouse position and motion delta coalesced over the last update
+        int getMouseX();
+        int getMouseY();
+        int getMouseDeltaX();
+        int getMouseDeltaY();
+        bool mouseMoved();
+
+        // Mouse button state and edges of the last update
+        bool isButtonDown(Uint8 button);
+        bool wasButtonPressed(Uint8 button);
+        bool wasButtonReleased(Uint8 button);
+        bool anyButtonDown();
+        bool anyButtonPressed();
+        bool anyButtonReleased();
+
+        // Prints events per frame before and after filtering and coalescing
+        void printStats();
+
+        // Writes every dispatched event with its frame number to path
+        bool startRecording(std::string path);
+        void stopRecording();
+
+        // Pushes the events recorded at path on the frames they were recorded on,
+        // then requests quit after the last one
+        bool startReplay(std::string path);
+        bool isReplaying();
+
+    private:
+        // Counts every pushed event and rejects unsubscribed types
+        static int eventFilter(void* userdata, SDL_Event* e);
+
+        // Event types let through the filter
+        std::bitset<SDL_LASTEVENT + 1> mSubscribed;
+
+        // Key state and per frame edge masks
+        std::bitset<SDL_NUM_SCANCODES> mKeysDown;
+        std::bitset<SDL_NUM_SCANCODES> mKeysPressed;
+        std::bitset<SDL_NUM_SCANCODES> mKeysReleased;
+
+        // Action to scancode table, indexed by action
+        std::vector<SDL_Scancode> mActionBindings;
+
+        // Mouse state
+        int mMouseX;
+        int mMouseY;
+        int mMouseDeltaX;
+        int mMouseDeltaY;
+        bool mMouseMoved;
+        Uint32 mButtonsDown;
+        Uint32 mButtonsPressed;
+        Uint32 mButtonsReleased;
+
+        bool mQuit;
+
+        // Event counters, the filter may run on another thread
+        std::atomic<Uint64> mPushedEvents;
+        std::atomic<Uint64> mAcceptedEvents;
+        Uint64 mDispatchedEvents;
+        Uint64 mFrames;
+
+        // Record of an input event, false for types not recorded
+        static bool writeEvent(SDL_RWops* log, Uint32 frame, const SDL_Event& e);
+
+        // Reads the next record, false at the end of the log
+        static bool readEvent(SDL_RWops* log, Uint32* frame, SDL_Event* e);
+
+        // Open recording, NULL when not recording
+        SDL_RWops* mRecording;
+
+        // Events of the replayed log with their frames and the next one to push
+        std::vector<SDL_Event> mReplayEvents;
+        std::vector<Uint32> mReplayFrames;
+        size_t mReplayNext;
+        bool mReplaying;
+};
+
 class LButton
 {
     public:
@@ -86,11 +344,14 @@ class LButton
         // Sets top left position
         void setPosition(int x, int y);
 
-        // Handles mouse event
-        void handleEvent(SDL_Event* e);
+        // Handles mouse state of the frame
+        void handleInput(LInput* input);
 
         // Shows button sprite
         void render();
+
+        // Gets sprite chosen by the last input
+        LButtonSprite getCurrentSprite();
     private:
         // Top left position
         SDL_Point mPosition;
@@ -99,21 +360,28 @@ class LButton
         LButtonSprite mCurrentSprite;
 };
 
-bool init();
+// Creates window and renderer, replays under the dummy driver need a software renderer
+bool init(Uint32 rendererFlags);
 
 bool loadMedia();
 
 void close();
 
+// Parses JSON text into root, false on malformed input
+bool parseJson(const char* text, LJsonValue* root);
+
 SDL_Window* gWindow = NULL;
 
 SDL_Renderer* gRenderer = NULL;
 
 SDL_Rect gSpriteClips[BUTTON_SPRITE_TOTAL];
+LSpriteSheet gButtonSpriteSheet;
 LTexture gButtonSpriteSheetTexture;
 
 LButton gButtons[TOTAL_BUTTONS];
 
+LInput gInput;
+
 LTexture::LTexture()
 {
     mTexture = NULL;
@@ -138,6 +406,9 @@ LTexture::~LTexture()
 
 bool LTexture::loadFromFile(std::string path)
 {
+    // Get rid of preexisting texture
+    free();
+
     SDL_Texture* newTexture = NULL;
 
     SDL_Surface* loadedSurface = IMG_Load(path.c_str());
@@ -198,6 +469,396 @@ int LTexture::getHeight()
     return mHeight;
 }
 
+LInput::LInput()
+{
+    mMouseX = 0;
+    mMouseY = 0;
+    mMouseDeltaX = 0;
+    mMouseDeltaY = 0;
+    mMouseMoved = false;
+    mButtonsDown = 0;
+    mButtonsPressed = 0;
+    mButtonsReleased = 0;
+
+    mQuit = false;
+
+    mPushedEvents = 0;
+    mAcceptedEvents = 0;
+    mDispatchedEvents = 0;
+    mFrames = 0;
+
+    mRecording = NULL;
+    mReplayNext = 0;
+    mReplaying = false;
+
+    // Quit is always wanted and window events feed the renderer's own event watch
+    subscribe(SDL_QUIT);
+    subscribe(SDL_WINDOWEVENT);
+}
+
+void LInput::subscribe(Uint32 type)
+{
+    mSubscribed.set(type);
+}
+
+void LInput::installFilter()
+{
+    SDL_SetEventFilter(eventFilter, this);
+}
+
+int LInput::eventFilter(void* userdata, SDL_Event* e)
+{
+    LInput* input = (LInput*)userdata;
+
+    ++input->mPushedEvents;
+    if (!input->mSubscribed.test(e->type)) {
+        return 0;
+    }
+
+    ++input->mAcceptedEvents;
+    return 1;
+}
+
+void LInput::bindAction(int action, SDL_Scancode scancode)
+{
+    if (action >= (int)mActionBindings.size()) {
+        mActionBindings.resize(action + 1, SDL_SCANCODE_UNKNOWN);
+    }
+
+    mActionBindings[action] = scancode;
+}
+
+void LInput::update()
+{
+    // Clear edges of the previous frame
+    mKeysPressed.reset();
+    mKeysReleased.reset();
+    mButtonsPressed = 0;
+    mButtonsReleased = 0;
+    mMouseDeltaX = 0;
+    mMouseDeltaY = 0;
+    mMouseMoved = false;
+
+    // Replayed events go through the filter and the queue like live ones
+    if (mReplaying) {
+        while (mReplayNext < mReplayEvents.size() && mReplayFrames[mReplayNext] <= mFrames) {
+            SDL_PushEvent(&mReplayEvents[mReplayNext]);
+            ++mReplayNext;
+        }
+    }
+
+    SDL_Event e;
+    while (SDL_PollEvent(&e) != 0) {
+        if (mRecording != NULL) {
+            writeEvent(mRecording, (Uint32)mFrames, e);
+        }
+
+        switch (e.type) {
+            case SDL_QUIT:
+            mQuit = true;
+            ++mDispatchedEvents;
+            break;
+
+            case SDL_KEYDOWN:
+            if (!e.key.repeat) {
+                mKeysDown.set(e.key.keysym.scancode);
+                mKeysPressed.set(e.key.keysym.scancode);
+            }
+            ++mDispatchedEvents;
+            break;
+
+            case SDL_KEYUP:
+            mKeysDown.reset(e.key.keysym.scancode);
+            mKeysReleased.set(e.key.keysym.scancode);
+            ++mDispatchedEvents;
+            break;
+
+            // Consecutive motion events collapse into one delta
+            case SDL_MOUSEMOTION:
+            mMouseX = e.motion.x;
+            mMouseY = e.motion.y;
+            mMouseDeltaX += e.motion.xrel;
+            mMouseDeltaY += e.motion.yrel;
+            if (!mMouseMoved) {
+                mMouseMoved = true;
+                ++mDispatchedEvents;
+            }
+            break;
+
+            case SDL_MOUSEBUTTONDOWN:
+            mMouseX = e.button.x;
+            mMouseY = e.button.y;
+            mButtonsDown |= SDL_BUTTON(e.button.button);
+            mButtonsPressed |= SDL_BUTTON(e.button.button);
+            ++mDispatchedEvents;
+            break;
+
+            case SDL_MOUSEBUTTONUP:
+            mMouseX = e.button.x;
+            mMouseY = e.button.y;
+            mButtonsDown &= ~SDL_BUTTON(e.button.button);
+            mButtonsReleased |= SDL_BUTTON(e.button.button);
+            ++mDispatchedEvents;
+            break;
+        }
+    }
+
+    if (mReplaying && mReplayNext == mReplayEvents.size()) {
+        mQuit = true;
+    }
+
+    ++mFrames;
+}
+
+bool LInput::quitRequested()
+{
+    return mQuit;
+}
+
+bool LInput::isKeyDown(SDL_Scancode scancode)
+{
+    return mKeysDown.test(scancode);
+}
+
+bool LInput::wasKeyPressed(SDL_Scancode scancode)
+{
+    return mKeysPressed.test(scancode);
+}
+
+bool LInput::wasKeyReleased(SDL_Scancode scancode)
+{
+    return mKeysReleased.test(scancode);
+}
+
+bool LInput::anyKeyPressed()
+{
+    return mKeysPressed.any();
+}
+
+bool LInput::isActionDown(int action)
+{
+    return action < (int)mActionBindings.size() && isKeyDown(mActionBindings[action]);
+}
+
+bool LInput::wasActionPressed(int action)
+{
+    return action < (int)mActionBindings.size() && wasKeyPressed(mActionBindings[action]);
+}
+
+bool LInput::wasActionReleased(int action)
+{
+    return action < (int)mActionBindings.size() && wasKeyReleased(mActionBindings[action]);
+}
+
+int LInput::getMouseX()
+{
+    return mMouseX;
+}
+
+int LInput::getMouseY()
+{
+    return mMouseY;
+}
+
+int LInput::getMouseDeltaX()
+{
+    return mMouseDeltaX;
+}
+
+int LInput::getMouseDeltaY()
+{
+    return mMouseDeltaY;
+}
+
+bool LInput::mouseMoved()
+{
+    return mMouseMoved;
+}
+
+bool LInput::isButtonDown(Uint8 button)
+{
+    return (mButtonsDown & SDL_BUTTON(button)) != 0;
+}
+
+bool LInput::wasButtonPressed(Uint8 button)
+{
+    return (mButtonsPressed & SDL_BUTTON(button)) != 0;
+}
+
+bool LInput::wasButtonReleased(Uint8 button)
+{
+    return (mButtonsReleased & SDL_BUTTON(button)) != 0;
+}
+
+bool LInput::anyButtonDown()
+{
+    return mButtonsDown != 0;
+}
+
+bool LInput::anyButtonPressed()
+{
+    return mButtonsPressed != 0;
+}
+
+bool LInput::anyButtonReleased()
+{
+    return mButtonsReleased != 0;
+}
+
+bool LInput::startRecording(std::string path)
+{
+    mRecording = SDL_RWFromFile(path.c_str(), "wb");
+    if (mRecording == NULL) {
+        printf("Failed to create input recording %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+        return false;
+    }
+
+    SDL_RWwrite(mRecording, INPUT_LOG_MAGIC, 4, 1);
+    SDL_WriteLE16(mRecording, INPUT_LOG_VERSION);
+
+    return true;
+}
+
+void LInput::stopRecording()
+{
+    if (mRecording != NULL) {
+        SDL_RWclose(mRecording);
+        mRecording = NULL;
+    }
+}
+
+bool LInput::startReplay(std::string path)
+{
+    SDL_RWops* log = SDL_RWFromFile(path.c_str(), "rb");
+    if (log == NULL) {
+        printf("Failed to open input recording %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+        return false;
+    }
+
+    char magic[4];
+    bool success = SDL_RWread(log, magic, 4, 1) == 1 && memcmp(magic, INPUT_LOG_MAGIC, 4) == 0 && SDL_ReadLE16(log) == INPUT_LOG_VERSION;
+    if (!success) {
+        printf("%s is not an input recording!\n", path.c_str());
+    } else {
+        mReplayEvents.clear();
+        mReplayFrames.clear();
+
+        Uint32 frame;
+        SDL_Event e;
+        while (readEvent(log, &frame, &e)) {
+            mReplayEvents.push_back(e);
+            mReplayFrames.push_back(frame);
+        }
+
+        mReplayNext = 0;
+        mReplaying = true;
+    }
+
+    SDL_RWclose(log);
+    return success;
+}
+
+bool LInput::isReplaying()
+{
+    return mReplaying;
+}
+
+bool LInput::writeEvent(SDL_RWops* log, Uint32 frame, const SDL_Event& e)
+{
+    int kind = 0;
+    while (kind < INPUT_RECORD_TYPE_COUNT && INPUT_RECORD_TYPES[kind] != e.type) {
+        ++kind;
+    }
+    if (kind == INPUT_RECORD_TYPE_COUNT) {
+        return false;
+    }
+
+    // Only the fields LInput reads, a key press takes 14 bytes instead of a whole SDL_Event
+    SDL_WriteU8(log, (Uint8)kind);
+    SDL_WriteLE32(log, frame);
+
+    switch (e.type) {
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+        SDL_WriteLE16(log, (Uint16)e.key.keysym.scancode);
+        SDL_WriteLE32(log, (Uint32)e.key.keysym.sym);
+        SDL_WriteLE16(log, e.key.keysym.mod);
+        SDL_WriteU8(log, e.key.repeat);
+        break;
+
+        case SDL_MOUSEMOTION:
+        SDL_WriteLE32(log, e.motion.state);
+        SDL_WriteLE16(log, (Uint16)e.motion.x);
+        SDL_WriteLE16(log, (Uint16)e.motion.y);
+        SDL_WriteLE16(log, (Uint16)e.motion.xrel);
+        SDL_WriteLE16(log, (Uint16)e.motion.yrel);
+        break;
+
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+        SDL_WriteU8(log, e.button.button);
+        SDL_WriteU8(log, e.button.clicks);
+        SDL_WriteLE16(log, (Uint16)e.button.x);
+        SDL_WriteLE16(log, (Uint16)e.button.y);
+        break;
+    }
+
+    return true;
+}
+
+bool LInput::readEvent(SDL_RWops* log, Uint32* frame, SDL_Event* e)
+{
+    Uint8 kind;
+    if (SDL_RWread(log, &kind, 1, 1) != 1 || kind >= INPUT_RECORD_TYPE_COUNT) {
+        return false;
+    }
+
+    SDL_zerop(e);
+    e->type = INPUT_RECORD_TYPES[kind];
+    *frame = SDL_ReadLE32(log);
+
+    switch (e->type) {
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+        e->key.state = e->type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+        e->key.keysym.scancode = (SDL_Scancode)SDL_ReadLE16(log);
+        e->key.keysym.sym = (SDL_Keycode)SDL_ReadLE32(log);
+        e->key.keysym.mod = SDL_ReadLE16(log);
+        e->key.repeat = SDL_ReadU8(log);
+        break;
+
+        case SDL_MOUSEMOTION:
+        e->motion.state = SDL_ReadLE32(log);
+        e->motion.x = (Sint16)SDL_ReadLE16(log);
+        e->motion.y = (Sint16)SDL_ReadLE16(log);
+        e->motion.xrel = (Sint16)SDL_ReadLE16(log);
+        e->motion.yrel = (Sint16)SDL_ReadLE16(log);
+        break;
+
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+        e->button.button = SDL_ReadU8(log);
+        e->button.state = e->type == SDL_MOUSEBUTTONDOWN ? SDL_PRESSED : SDL_RELEASED;
+        e->button.clicks = SDL_ReadU8(log);
+        e->button.x = (Sint16)SDL_ReadLE16(log);
+        e->button.y = (Sint16)SDL_ReadLE16(log);
+        break;
+    }
+
+    return true;
+}
+
+void LInput::printStats()
+{
+    if (mFrames == 0) {
+        return;
+    }
+
+    double frames = (double)mFrames;
+    printf("Input: %llu frames, events per frame: %.2f pushed, %.2f after filter, %.2f after coalescing\n",
+        (unsigned long long)mFrames, mPushedEvents / frames, mAcceptedEvents / frames, mDispatchedEvents / frames);
+}
+
 LButton::LButton()
 {
     mPosition.x = 0;
@@ -212,13 +873,13 @@ void LButton::setPosition(int x, int y)
     mPosition.y = y;
 }
 
-void LButton::handleEvent(SDL_Event* e)
+void LButton::handleInput(LInput* input)
 {
-    // If mouse event happened
-    if (e->type == SDL_MOUSEMOTION || e->type == SDL_MOUSEBUTTONDOWN || e->type == SDL_MOUSEBUTTONUP) {
+    // If mouse changed this frame
+    if (input->mouseMoved() || input->anyButtonPressed() || input->anyButtonReleased()) {
         // Get mouse position
-        int x, y;
-        SDL_GetMouseState(&x, &y);
+        int x = input->getMouseX();
+        int y = input->getMouseY();
 
         // Check if mouse is in button
         bool inside = true;
@@ -244,22 +905,13 @@ void LButton::handleEvent(SDL_Event* e)
         if (!inside) {
             mCurrentSprite = BUTTON_SPRITE_MOUSE_OUT;
         }
-        // Mouse is inside button
-        else {
-            // Set mouse over sprite
-            switch(e->type) {
-                case SDL_MOUSEMOTION:
-                mCurrentSprite = BUTTON_SPRITE_MOUSE_OVER_MOTION;
-                break;
-
-                case SDL_MOUSEBUTTONDOWN:
-                mCurrentSprite = BUTTON_SPRITE_MOUSE_DOWN;
-                break;
-
-                case SDL_MOUSEBUTTONUP:
-                mCurrentSprite = BUTTON_SPRITE_MOUSE_UP;
-                break;
-            }
+        // Mouse is inside button, a button held at the end of the frame wins over one released during it
+        else if (input->anyButtonDown()) {
+            mCurrentSprite = BUTTON_SPRITE_MOUSE_DOWN;
+        } else if (input->anyButtonReleased()) {
+            mCurrentSprite = BUTTON_SPRITE_MOUSE_UP;
+        } else {
+            mCurrentSprite = BUTTON_SPRITE_MOUSE_OVER_MOTION;
         }
     }
 }
@@ -270,7 +922,12 @@ void LButton::render()
     gButtonSpriteSheetTexture.render(mPosition.x, mPosition.y, &gSpriteClips[mCurrentSprite]);
 }
 
-bool init()
+LButtonSprite LButton::getCurrentSprite()
+{
+    return mCurrentSprite;
+}
+
+bool init(Uint32 rendererFlags)
 {
     bool success = true;
 
@@ -283,7 +940,7 @@ bool init()
             printf("Failed to create window! SDL Error: %s\n", SDL_GetError());
             success = false;
         } else {
-            gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+            gRenderer = SDL_CreateRenderer(gWindow, -1, rendererFlags);
             if (gRenderer == NULL) {
                 printf("Failed to create renderer! SDL Error: %s\n", SDL_GetError());
                 success = false;
@@ -302,6 +959,511 @@ bool init()
     return success;
 }
 
+LJsonValue::LJsonValue()
+{
+    type = JSON_NULL;
+    boolean = false;
+    number = 0;
+}
+
+const LJsonValue* LJsonValue::get(const char* key) const
+{
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (keys[i] == key) {
+            return &items[i];
+        }
+    }
+
+    return NULL;
+}
+
+double LJsonValue::getNumber(const char* key, double fallback) const
+{
+    const LJsonValue* value = get(key);
+    if (value == NULL) {
+        return fallback;
+    }
+
+    if (value->type == JSON_BOOL) {
+        return value->boolean ? 1 : 0;
+    }
+
+    return value->type == JSON_NUMBER ? value->number : fallback;
+}
+
+static void skipWhitespace(const char** text)
+{
+    while (**text == ' ' || **text == '\t' || **text == '\n' || **text == '\r') {
+        ++*text;
+    }
+}
+
+static bool parseJsonString(const char** text, std::string* out)
+{
+    const char* p = *text + 1;
+    out->clear();
+
+    while (*p != '"') {
+        if (*p == '\0') {
+            return false;
+        }
+
+        if (*p != '\\') {
+            out->push_back(*p++);
+            continue;
+        }
+
+        ++p;
+        switch (*p) {
+            case 'b':
+            out->push_back('\b');
+            break;
+
+            case 'f':
+            out->push_back('\f');
+            break;
+
+            case 'n':
+            out->push_back('\n');
+            break;
+
+            case 'r':
+            out->push_back('\r');
+            break;
+
+            case 't':
+            out->push_back('\t');
+            break;
+
+            // Basic multilingual plane only, encoded as UTF-8
+            case 'u':
+            {
+                unsigned code = 0;
+                for (int i = 1; i <= 4; ++i) {
+                    char c = p[i];
+                    code <<= 4;
+                    if (c >= '0' && c <= '9') {
+                        code |= c - '0';
+                    } else if (c >= 'a' && c <= 'f') {
+                        code |= c - 'a' + 10;
+                    } else if (c >= 'A' && c <= 'F') {
+                        code |= c - 'A' + 10;
+                    } else {
+                        return false;
+                    }
+                }
+                p += 4;
+
+                if (code < 0x80) {
+                    out->push_back((char)code);
+                } else if (code < 0x800) {
+                    out->push_back((char)(0xC0 | code >> 6));
+                    out->push_back((char)(0x80 | (code & 0x3F)));
+                } else {
+                    out->push_back((char)(0xE0 | code >> 12));
+                    out->push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+                    out->push_back((char)(0x80 | (code & 0x3F)));
+                }
+                break;
+            }
+
+            case '\0':
+            return false;
+
+            default:
+            out->push_back(*p);
+            break;
+        }
+        ++p;
+    }
+
+    *text = p + 1;
+    return true;
+}
+
+static bool parseJsonValue(const char** text, LJsonValue* value, int depth)
+{
+    // Sprite sheet exports nest a few levels, anything deeper is not one
+    if (depth > 32) {
+        return false;
+    }
+
+    skipWhitespace(text);
+    const char* p = *text;
+
+    if (*p == '{' || *p == '[') {
+        bool object = *p == '{';
+        value->type = object ? LJsonValue::JSON_OBJECT : LJsonValue::JSON_ARRAY;
+        char close = object ? '}' : ']';
+
+        ++*text;
+        skipWhitespace(text);
+        if (**text == close) {
+            ++*text;
+            return true;
+        }
+
+        while (true) {
+            if (object) {
+                skipWhitespace(text);
+                std::string key;
+                if (**text != '"' || !parseJsonString(text, &key)) {
+                    return false;
+                }
+                skipWhitespace(text);
+                if (**text != ':') {
+                    return false;
+                }
+                ++*text;
+                value->keys.push_back(key);
+            }
+
+            value->items.push_back(LJsonValue());
+            if (!parseJsonValue(text, &value->items.back(), depth + 1)) {
+                return false;
+            }
+
+            skipWhitespace(text);
+            if (**text == ',') {
+                ++*text;
+            } else if (**text == close) {
+                ++*text;
+                return true;
+            } else {
+                return false;
+            }
+        }
+    }
+
+    if (*p == '"') {
+        value->type = LJsonValue::JSON_STRING;
+        return parseJsonString(text, &value->string);
+    }
+
+    if (strncmp(p, "true", 4) == 0 || strncmp(p, "false", 5) == 0) {
+        value->type = LJsonValue::JSON_BOOL;
+        value->boolean = *p == 't';
+        *text += value->boolean ? 4 : 5;
+        return true;
+    }
+
+    if (strncmp(p, "null", 4) == 0) {
+        value->type = LJsonValue::JSON_NULL;
+        *text += 4;
+        return true;
+    }
+
+    char* end = NULL;
+    value->type = LJsonValue::JSON_NUMBER;
+    value->number = strtod(p, &end);
+    if (end == p) {
+        return false;
+    }
+
+    *text = end;
+    return true;
+}
+
+bool parseJson(const char* text, LJsonValue* root)
+{
+    if (!parseJsonValue(&text, root, 0)) {
+        return false;
+    }
+
+    skipWhitespace(&text);
+    return *text == '\0';
+}
+
+LSpriteSheet::LSpriteSheet()
+{
+    mFrames = NULL;
+    mNames = NULL;
+    mFrameCount = 0;
+    mTotalDuration = 0;
+    mMapping = NULL;
+    mMappingSize = 0;
+}
+
+LSpriteSheet::~LSpriteSheet()
+{
+    free();
+}
+
+void LSpriteSheet::free()
+{
+    if (mMapping != NULL) {
+        unloadSidecar(mMapping, mMappingSize);
+        mMapping = NULL;
+        mMappingSize = 0;
+    }
+
+    mParsedFrames.clear();
+    mParsedNames.clear();
+    mFrames = NULL;
+    mNames = NULL;
+    mFrameCount = 0;
+    mTotalDuration = 0;
+}
+
+bool LSpriteSheet::loadFromFile(std::string path)
+{
+    free();
+
+    struct stat json;
+    if (stat(path.c_str(), &json) != 0) {
+        printf("Unable to find sprite sheet %s! %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    if (!loadSidecar(path + ".bin", json.st_size, json.st_mtime)) {
+        if (!parseExport(path)) {
+            return false;
+        }
+
+        writeSidecar(path + ".bin", json.st_size, json.st_mtime);
+
+        mFrames = mParsedFrames.empty() ? NULL : &mParsedFrames[0];
+        mNames = mParsedNames.c_str();
+        mFrameCount = (int)mParsedFrames.size();
+    }
+
+    for (int i = 0; i < mFrameCount; ++i) {
+        mTotalDuration += mFrames[i].duration;
+    }
+
+    return mFrameCount > 0;
+}
+
+bool LSpriteSheet::parseExport(std::string path)
+{
+    size_t size = 0;
+    char* text = (char*)SDL_LoadFile(path.c_str(), &size);
+    if (text == NULL) {
+        printf("Unable to read sprite sheet %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+        return false;
+    }
+
+    LJsonValue root;
+    bool parsed = parseJson(text, &root);
+    SDL_free(text);
+
+    const LJsonValue* frames = parsed ? root.get("frames") : NULL;
+    if (frames == NULL || (frames->type != LJsonValue::JSON_ARRAY && frames->type != LJsonValue::JSON_OBJECT)) {
+        printf("Sprite sheet %s has no frames!\n", path.c_str());
+        return false;
+    }
+
+    // Hash exports key frames by name, array exports carry a filename
+    for (size_t i = 0; i < frames->items.size(); ++i) {
+        const LJsonValue& entry = frames->items[i];
+        const LJsonValue* filename = entry.get("filename");
+        std::string name = frames->type == LJsonValue::JSON_OBJECT ? frames->keys[i] : (filename != NULL ? filename->string : "");
+
+        const LJsonValue* rect = entry.get("frame");
+        if (rect == NULL) {
+            printf("Frame %s of %s has no rectangle!\n", name.c_str(), path.c_str());
+            return false;
+        }
+
+        LSpriteFrame frame;
+        frame.clip.x = (int)rect->getNumber("x", 0);
+        frame.clip.y = (int)rect->getNumber("y", 0);
+        frame.clip.w = (int)rect->getNumber("w", 0);
+        frame.clip.h = (int)rect->getNumber("h", 0);
+        frame.rotated = (Sint32)entry.getNumber("rotated", 0);
+
+        // Untrimmed frames are their own source
+        const LJsonValue* spriteSource = entry.get("spriteSourceSize");
+        const LJsonValue* sourceSize = entry.get("sourceSize");
+        frame.offsetX = spriteSource != NULL ? (Sint32)spriteSource->getNumber("x", 0) : 0;
+        frame.offsetY = spriteSource != NULL ? (Sint32)spriteSource->getNumber("y", 0) : 0;
+        frame.sourceWidth = sourceSize != NULL ? (Sint32)sourceSize->getNumber("w", frame.clip.w) : frame.clip.w;
+        frame.sourceHeight = sourceSize != NULL ? (Sint32)sourceSize->getNumber("h", frame.clip.h) : frame.clip.h;
+
+        const LJsonValue* pivot = entry.get("pivot");
+        frame.pivotX = pivot != NULL ? (float)pivot->getNumber("x", 0.5) : 0.5f;
+        frame.pivotY = pivot != NULL ? (float)pivot->getNumber("y", 0.5) : 0.5f;
+
+        frame.duration = (Sint32)entry.getNumber("duration", 100);
+
+        frame.nameOffset = (Uint32)mParsedNames.size();
+        mParsedNames.append(name);
+        mParsedNames.push_back('\0');
+
+        mParsedFrames.push_back(frame);
+    }
+
+    return true;
+}
+
+bool LSpriteSheet::loadSidecar(std::string path, Sint64 jsonSize, Sint64 jsonModified)
+{
+    void* mapping = NULL;
+    size_t size = 0;
+
+#if defined(__linux__)
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+
+    struct stat sidecar;
+    if (fstat(file, &sidecar) == 0 && (size_t)sidecar.st_size >= sizeof(LSpriteSheetHeader)) {
+        // Private and writable so clips can be handed out as SDL_Rect*, nothing goes back to the file
+        size = sidecar.st_size;
+        mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+        if (mapping == MAP_FAILED) {
+            mapping = NULL;
+        }
+    }
+    close(file);
+#else
+    mapping = SDL_LoadFile(path.c_str(), &size);
+#endif
+
+    if (mapping == NULL) {
+        return false;
+    }
+
+    const LSpriteSheetHeader* header = (const LSpriteSheetHeader*)mapping;
+    bool current = size >= sizeof(LSpriteSheetHeader) && memcmp(header->magic, "LSPR", 4) == 0 && header->version == 1
+        && header->frameSize == sizeof(LSpriteFrame) && header->jsonSize == jsonSize && header->jsonModified == jsonModified
+        && sizeof(LSpriteSheetHeader) + (size_t)header->frameCount * sizeof(LSpriteFrame) + header->namesSize == size
+        && header->namesSize > 0;
+
+    const LSpriteFrame* frames = (const LSpriteFrame*)((Uint8*)mapping + sizeof(LSpriteSheetHeader));
+    const char* names = (const char*)(frames + (current ? header->frameCount : 0));
+    if (current && names[header->namesSize - 1] != '\0') {
+        current = false;
+    }
+
+    // A damaged sidecar with a current time must not send names past the table
+    for (Uint32 i = 0; current && i < header->frameCount; ++i) {
+        if (frames[i].nameOffset >= header->namesSize) {
+            current = false;
+        }
+    }
+
+    if (!current) {
+        unloadSidecar(mapping, size);
+        return false;
+    }
+
+    mMapping = mapping;
+    mMappingSize = size;
+    mFrames = (LSpriteFrame*)frames;
+    mNames = names;
+    mFrameCount = (int)header->frameCount;
+
+    return true;
+}
+
+void LSpriteSheet::unloadSidecar(void* mapping, size_t size)
+{
+#if defined(__linux__)
+    munmap(mapping, size);
+#else
+    // Read by SDL_LoadFile, only munmap needs the size
+    (void)size;
+    SDL_free(mapping);
+#endif
+}
+
+void LSpriteSheet::writeSidecar(std::string path, Sint64 jsonSize, Sint64 jsonModified)
+{
+    if (mParsedFrames.empty()) {
+        return;
+    }
+
+    LSpriteSheetHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "LSPR", 4);
+    header.version = 1;
+    header.frameSize = sizeof(LSpriteFrame);
+    header.frameCount = (Uint32)mParsedFrames.size();
+    header.namesSize = (Uint32)mParsedNames.size();
+    header.jsonSize = jsonSize;
+    header.jsonModified = jsonModified;
+
+    // Written aside and renamed so a reader never maps half a file
+    std::string temporary = path + ".tmp";
+    SDL_RWops* file = SDL_RWFromFile(temporary.c_str(), "wb");
+    if (file == NULL) {
+        printf("Unable to write sprite sheet cache %s! SDL Error: %s\n", temporary.c_str(), SDL_GetError());
+        return;
+    }
+
+    bool written = SDL_RWwrite(file, &header, sizeof(header), 1) == 1
+        && SDL_RWwrite(file, &mParsedFrames[0], sizeof(LSpriteFrame), mParsedFrames.size()) == mParsedFrames.size()
+        && SDL_RWwrite(file, mParsedNames.data(), mParsedNames.size(), 1) == 1;
+    SDL_RWclose(file);
+
+#if !defined(__linux__)
+    // rename does not replace an existing file everywhere, and nothing has the old one mapped here
+    if (written) {
+        remove(path.c_str());
+    }
+#endif
+
+    if (!written || rename(temporary.c_str(), path.c_str()) != 0) {
+        printf("Unable to write sprite sheet cache %s!\n", path.c_str());
+        remove(temporary.c_str());
+    }
+}
+
+int LSpriteSheet::getFrameCount()
+{
+    return mFrameCount;
+}
+
+const LSpriteFrame& LSpriteSheet::getFrame(int index)
+{
+    return mFrames[index];
+}
+
+SDL_Rect* LSpriteSheet::getClip(int index)
+{
+    return &mFrames[index].clip;
+}
+
+const char* LSpriteSheet::getName(int index)
+{
+    return mNames + mFrames[index].nameOffset;
+}
+
+int LSpriteSheet::findFrame(std::string name)
+{
+    for (int i = 0; i < mFrameCount; ++i) {
+        if (name == getName(i)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+int LSpriteSheet::getFrameAt(double milliseconds)
+{
+    if (mTotalDuration <= 0) {
+        return 0;
+    }
+
+    double time = fmod(milliseconds, mTotalDuration);
+    for (int i = 0; i < mFrameCount; ++i) {
+        time -= mFrames[i].duration;
+        if (time < 0) {
+            return i;
+        }
+    }
+
+    return mFrameCount - 1;
+}
+
+bool LSpriteSheet::isFromSidecar()
+{
+    return mMapping != NULL;
+}
+
 bool loadMedia()
 {
     bool success = true;
@@ -310,11 +1472,22 @@ bool loadMedia()
         printf("Failed to load button texture!\n");
         success = false;
     } else {
-        for (int i = 0; i < BUTTON_SPRITE_TOTAL; ++i) {
-            gSpriteClips[i].x = 0;
-            gSpriteClips[i].y = i * 200;
-            gSpriteClips[i].w = BUTTON_WIDTH;
-            gSpriteClips[i].h = BUTTON_HEIGHT;
+        // One named frame per button state, in LButtonSprite order
+        const char* clipNames[BUTTON_SPRITE_TOTAL] = { "mouse_out", "mouse_over_motion", "mouse_down", "mouse_up" };
+
+        if (!gButtonSpriteSheet.loadFromFile("button.json")) {
+            printf("Failed to load button sprite sheet frames!\n");
+            success = false;
+        } else {
+            for (int i = 0; i < BUTTON_SPRITE_TOTAL; ++i) {
+                int frame = gButtonSpriteSheet.findFrame(clipNames[i]);
+                if (frame < 0) {
+                    printf("Button sprite sheet has no frame %s!\n", clipNames[i]);
+                    success = false;
+                } else {
+                    gSpriteClips[i] = *gButtonSpriteSheet.getClip(frame);
+                }
+            }
         }
 
         gButtons[0].setPosition(0, 0);
@@ -328,6 +1501,9 @@ bool loadMedia()
 
 void close()
 {
+    gInput.printStats();
+
+    gButtonSpriteSheet.free();
     gButtonSpriteSheetTexture.free();
 
     SDL_DestroyRenderer(gRenderer);
@@ -341,26 +1517,52 @@ void close()
 
 int main (int argc, char *argv[])
 {
-    if (!init()) {
+    // --record <log> saves the input of the session, --replay <log> plays it back
+    // under the dummy video driver and prints timing and a digest of the button states
+    std::string mode = argc > 1 ? argv[1] : "";
+    if ((mode == "--record" || mode == "--replay") && argc < 3) {
+        printf("Usage: %s %s <log>\n", argv[0], mode.c_str());
+        return 1;
+    }
+
+    // Nothing but the log can feed input then
+    if (mode == "--replay") {
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    }
+
+    // The dummy driver has no accelerated renderer and no display to sync to
+    Uint32 rendererFlags = mode == "--replay" ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC;
+
+    if (!init(rendererFlags)) {
         printf("Failed to initialize!\n");
     } else {
         if (!loadMedia()) {
             printf("Failed to load media!\n");
         } else {
-            bool quit = false;
+            // Keyboard events are dropped before they reach the queue
+            gInput.subscribe(SDL_MOUSEMOTION);
+            gInput.subscribe(SDL_MOUSEBUTTONDOWN);
+            gInput.subscribe(SDL_MOUSEBUTTONUP);
+            gInput.installFilter();
+
+            bool ready = true;
+            if (mode == "--record") {
+                ready = gInput.startRecording(argv[2]);
+            } else if (mode == "--replay") {
+                ready = gInput.startReplay(argv[2]);
+            }
 
-            SDL_Event e;
+            // FNV-1a over the button sprites of every frame, equal digests mean identical runs
+            Uint32 digest = 2166136261u;
+            int frames = 0;
+            Uint64 start = SDL_GetPerformanceCounter();
 
-            while (!quit) {
-                while (SDL_PollEvent(&e) != 0) {
-                    // User requests quit
-                    if (e.type == SDL_QUIT) {
-                        quit = true;
-                    }
+            while (ready && !gInput.quitRequested()) {
+                gInput.update();
 
-                    for (int i = 0; i < TOTAL_BUTTONS; ++i) {
-                        gButtons[i].handleEvent(&e);
-                    }
+                for (int i = 0; i < TOTAL_BUTTONS; ++i) {
+                    gButtons[i].handleInput(&gInput);
+                    digest = (digest ^ (Uint32)gButtons[i].getCurrentSprite()) * 16777619u;
                 }
 
                 SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
@@ -371,7 +1573,15 @@ int main (int argc, char *argv[])
                 }
 
                 SDL_RenderPresent(gRenderer);
+                ++frames;
             }
+
+            if (gInput.isReplaying() && frames > 0) {
+                double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+                printf("Replayed %d frames, %.3f ms/frame, button digest %08x\n", frames, ms / frames, digest);
+            }
+
+            gInput.stopRecording();
         }
     }
 
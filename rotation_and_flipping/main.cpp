@@ -2,16 +2,64 @@
 #include <SDL2/SDL_error.h>
 #include <SDL2/SDL_events.h>
 #include <SDL2/SDL_image.h>
+#include <SDL2/SDL_mouse.h>
 #include <SDL2/SDL_rect.h>
 #include <SDL2/SDL_render.h>
+#include <SDL2/SDL_rwops.h>
+#include <SDL2/SDL_scancode.h>
 #include <SDL2/SDL_surface.h>
 #include <SDL2/SDL_video.h>
+#include <atomic>
+#include <bitset>
+#include <cerrno>
+#include <cmath>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 480;
 
+// Input recording header and the event types it stores, indexed by each record's type byte
+const char INPUT_LOG_MAGIC[] = "LINP";
+const Uint16 INPUT_LOG_VERSION = 1;
+const Uint32 INPUT_RECORD_TYPES[] = {SDL_QUIT, SDL_KEYDOWN, SDL_KEYUP, SDL_MOUSEMOTION, SDL_MOUSEBUTTONDOWN, SDL_MOUSEBUTTONUP};
+const int INPUT_RECORD_TYPE_COUNT = 6;
+
+// Rotation cache angles per full turn and variants kept
+const int ROTATION_CACHE_STEPS = 72;
+const int ROTATION_CACHE_CAPACITY = 32;
+
+// Largest difference in degrees still drawn from the rotation cache
+const double ROTATION_SNAP_EPSILON = 0.001;
+
+// Actions the arrow responds to
+enum InputAction
+{
+    INPUT_ACTION_ROTATE_LEFT,
+    INPUT_ACTION_ROTATE_RIGHT,
+    INPUT_ACTION_FLIP_HORIZONTAL,
+    INPUT_ACTION_FLIP_NONE,
+    INPUT_ACTION_FLIP_VERTICAL,
+    INPUT_ACTION_TOTAL
+};
+
 class LTexture
 {
     public:
@@ -24,6 +72,9 @@ class LTexture
         // Load image at specified path
         bool loadFromFile(std::string path);
 
+        // Replaces pixels with surface, in place when dimensions match
+        bool updateFromSurface(SDL_Surface* surface);
+
         // Deallocates texture
         void free();
 
@@ -43,35 +94,292 @@ class LTexture
         int getWidth();
         int getHeight();
 
+        // Pre-renders rotated and flipped variants at steps angles per turn,
+        // keeping the capacity most recently drawn, 0 steps or capacity turns it off
+        void enableRotationCache(int steps, int capacity);
+
+        // Prints rotation cache hits, misses and evictions
+        void printRotationCacheStats();
+
     private:
+        // Texture rotated by a whole number of steps, drawn with a plain copy
+        struct RotatedVariant
+        {
+            int step;
+            SDL_RendererFlip flip;
+            SDL_Rect clip;
+            SDL_Point center;
+
+            SDL_Texture* texture;
+
+            // Position relative to the unrotated quad and size
+            int offsetX;
+            int offsetY;
+            int width;
+            int height;
+        };
+
+        // Finds or renders variant, NULL when it can not be rendered
+        RotatedVariant* getRotatedVariant(int step, SDL_Rect* clip, SDL_Point* center, SDL_RendererFlip flip);
+
+        // Destroys every cached variant
+        void clearRotationCache();
+
         // The actual hardware texture
         SDL_Texture* mTexture;
 
+        // ARGB8888 copy of the pixels, kept for blits to a software target
+        SDL_Surface* mPixels;
+
         int mWidth;
         int mHeight;
+
+        // Variants by recent use, most recent first
+        int mRotationSteps;
+        size_t mRotationCapacity;
+        std::list<RotatedVariant> mRotationCache;
+        Uint64 mRotationHits;
+        Uint64 mRotationMisses;
+        Uint64 mRotationEvictions;
+};
+
+class LInput
+{
+    public:
+        // Initialize
+        LInput();
+
+        // Lets an event type through the event filter
+        void subscribe(Uint32 type);
+
+        // Installs the event filter, drops every type nobody subscribed to
+        void installFilter();
+
+        // Maps action to the key producing keycode on the current layout,
+        // a repeating action is also pressed on every key repeat
+        void bindAction(int action, SDL_Keycode keycode, bool repeats = false);
+
+        // Drains the event queue, call once per frame
+        void update();
+
+        // Whether the user requested quit
+        bool quitRequested();
+
+        // Key state and edges of the last update
+        bool isKeyDown(SDL_Scancode scancode);
+        bool wasKeyPressed(SDL_Scancode scancode);
+        bool wasKeyReleased(SDL_Scancode scancode);
+        bool anyKeyPressed();
+
+        // Action state and edges of the last update
+        bool isActionDown(int action);
+        bool wasActionPressed(int action);
+        bool wasActionReleased(int action);
+
+        // Mouse position and motion delta coalesced over the last update
+        int getMouseX();
+        int getMouseY();
+        int getMouseDeltaX();
+        int getMouseDeltaY();
+        bool mouseMoved();
+
+        // Mouse button state and edges of the last update
+        bool isButtonDown(Uint8 button);
+        bool wasButtonPressed(Uint8 button);
+        bool wasButtonReleased(Uint8 button);
+
+        // Prints events per frame before and after filtering and coalescing
+        void printStats();
+
+        // Writes every dispatched event with its frame number to path
+        bool startRecording(std::string path);
+        void stopRecording();
+
+        // Pushes the events recorded at path on the frames they were recorded on,
+        // then requests quit after the last one
+        bool startReplay(std::string path);
+        bool isReplaying();
+
+    private:
+        // Counts every pushed event and rejects unsubscribed types
+        static int eventFilter(void* userdata, SDL_Event* e);
+
+        // Scancode of the key bound to action, SDL_SCANCODE_UNKNOWN if unbound
+        SDL_Scancode getActionScancode(int action);
+
+        // Event types let through the filter
+        std::bitset<SDL_LASTEVENT + 1> mSubscribed;
+
+        // Key state and per frame edge masks
+        std::bitset<SDL_NUM_SCANCODES> mKeysDown;
+        std::bitset<SDL_NUM_SCANCODES> mKeysPressed;
+        std::bitset<SDL_NUM_SCANCODES> mKeysReleased;
+        std::bitset<SDL_NUM_SCANCODES> mKeysRepeated;
+
+        // Action to keycode table and repeat flags, indexed by action
+        std::vector<SDL_Keycode> mActionBindings;
+        std::vector<bool> mActionRepeats;
+
+        // Mouse state
+        int mMouseX;
+        int mMouseY;
+        int mMouseDeltaX;
+        int mMouseDeltaY;
+        bool mMouseMoved;
+        Uint32 mButtonsDown;
+        Uint32 mButtonsPressed;
+        Uint32 mButtonsReleased;
+
+        bool mQuit;
+
+        // Event counters, the filter may run on another thread
+        std::atomic<Uint64> mPushedEvents;
+        std::atomic<Uint64> mAcceptedEvents;
+        Uint64 mDispatchedEvents;
+        Uint64 mFrames;
+
+        // Record of an input event, false for types not recorded
+        static bool writeEvent(SDL_RWops* log, Uint32 frame, const SDL_Event& e);
+
+        // Reads the next record, false at the end of the log
+        static bool readEvent(SDL_RWops* log, Uint32* frame, SDL_Event* e);
+
+        // Open recording, NULL when not recording
+        SDL_RWops* mRecording;
+
+        // Events of the replayed log with their frames and the next one to push
+        std::vector<SDL_Event> mReplayEvents;
+        std::vector<Uint32> mReplayFrames;
+        size_t mReplayNext;
+        bool mReplaying;
+};
+
+class LAssetWatcher
+{
+    public:
+        // Initialize
+        LAssetWatcher();
+
+        // Stops watching
+        ~LAssetWatcher();
+
+        // Reloads texture whenever the file at path changes, call before start
+        void watch(LTexture* texture, std::string path);
+
+        // Starts watching directory on a background thread
+        bool start(std::string directory);
+
+        // Stops the background thread
+        void stop();
+
+        // Uploads finished reloads, call once per frame on the render thread
+        void applyReloads();
+
+    private:
+        // Background thread waiting on inotify and decoding changed files
+        void run();
+
+        // Decodes file into a surface matching the texture format
+        SDL_Surface* decode(std::string path);
+
+        // inotify instance
+        int mInotify;
+
+        // Directory being watched
+        std::string mDirectory;
+
+        // Textures per watched file name, read only once started
+        std::map<std::string, std::vector<LTexture*> > mWatched;
+
+        // Decoded surfaces waiting for upload
+        std::mutex mMutex;
+        std::map<std::string, SDL_Surface*> mDecoded;
+
+        std::thread mThread;
+        std::atomic<bool> mRunning;
 };
 
-bool init();
+// Creates window and renderer, replays under the dummy driver need a software renderer
+bool init(Uint32 rendererFlags);
 
 bool loadMedia();
 
 void close();
 
+// Draws the arrow with given rotation and flip
+void renderFrame(double degrees, SDL_RendererFlip flipType);
+
+// Largest per channel difference still treated as equal
+const Uint8 GOLDEN_TOLERANCE = 2;
+
+// Frames from this many pixels up are diffed on several threads
+const int GOLDEN_PARALLEL_PIXELS = 1 << 20;
+
+// Creates a software renderer on an offscreen surface, no display needed
+bool initHeadless();
+
+// Reads back the rendered frame as ARGB8888
+SDL_Surface* captureFrame();
+
+// Counts pixels with any channel differing by more than tolerance
+int diffPixels(const Uint32* a, const Uint32* b, int count, Uint8 tolerance);
+
+// Counts mismatching pixels of two equally sized ARGB8888 surfaces
+int diffSurfaces(SDL_Surface* a, SDL_Surface* b, Uint8 tolerance);
+
+// Writes heatmap of per pixel differences to path
+bool saveDiffHeatmap(SDL_Surface* frame, SDL_Surface* golden, std::string path);
+
+// Captures frame into path, or compares it against path when compare is set
+bool runGolden(std::string path, bool compare);
+
+// Times diffing two 4K frames
+void runDiffBenchmark();
+
+// Draws srcrect of src into dstrect of dst rotated by angle degrees around center
+// with bilinear filtering, false when the formats or blend mode are unsupported
+bool rotozoomBlit(SDL_Surface* src, const SDL_Rect* srcrect, SDL_Surface* dst, const SDL_Rect* dstrect, double angle, const SDL_Point* center, SDL_RendererFlip flip, SDL_Color mod, SDL_BlendMode blendMode);
+
+// Times rotated draws on the software renderer through SDL, rotozoomBlit and the rotation cache
+void runRotateBenchmark();
+
 SDL_Window* gWindow = NULL;
 
 SDL_Renderer* gRenderer = NULL;
 
+// Offscreen target of the headless renderer
+SDL_Surface* gCaptureSurface = NULL;
+
+// Surface rotated draws are blitted to directly, NULL to leave them to SDL
+SDL_Surface* gSoftwareTarget = NULL;
+
 LTexture gArrowTexture;
 
+LInput gInput;
+
+LAssetWatcher gAssetWatcher;
+
 LTexture::LTexture()
 {
     mTexture = NULL;
+    mPixels = NULL;
     mWidth = 0;
     mHeight = 0;
+
+    mRotationSteps = 0;
+    mRotationCapacity = 0;
+    mRotationHits = 0;
+    mRotationMisses = 0;
+    mRotationEvictions = 0;
 }
 
 void LTexture::free()
 {
+    clearRotationCache();
+
+    SDL_FreeSurface(mPixels);
+    mPixels = NULL;
+
     if (mTexture != NULL) {
         SDL_DestroyTexture(mTexture);
         mTexture = NULL;
@@ -87,6 +395,9 @@ LTexture::~LTexture()
 
 bool LTexture::loadFromFile(std::string path)
 {
+    // Get rid of preexisting texture
+    free();
+
     SDL_Texture* newTexture = NULL;
 
     SDL_Surface* loadedSurface = IMG_Load(path.c_str());
@@ -101,6 +412,10 @@ bool LTexture::loadFromFile(std::string path)
 
             mWidth = loadedSurface->w;
             mHeight = loadedSurface->h;
+
+            if (gSoftwareTarget != NULL) {
+                mPixels = SDL_ConvertSurfaceFormat(loadedSurface, SDL_PIXELFORMAT_ARGB8888, 0);
+            }
         }
 
         SDL_FreeSurface(loadedSurface);
@@ -110,6 +425,59 @@ bool LTexture::loadFromFile(std::string path)
     return mTexture != NULL;
 }
 
+bool LTexture::updateFromSurface(SDL_Surface* surface)
+{
+    // Same dimensions, overwrite the pixels of the existing texture
+    if (gSoftwareTarget != NULL) {
+        SDL_FreeSurface(mPixels);
+        mPixels = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    }
+
+    if (mTexture != NULL && surface->w == mWidth && surface->h == mHeight) {
+        clearRotationCache();
+
+        Uint32 format;
+        SDL_QueryTexture(mTexture, &format, NULL, NULL, NULL);
+
+        SDL_Surface* converted = surface;
+        if (surface->format->format != format) {
+            converted = SDL_ConvertSurfaceFormat(surface, format, 0);
+            if (converted == NULL) {
+                printf("Unable to convert surface to %s! SDL Error: %s\n", SDL_GetPixelFormatName(format), SDL_GetError());
+                return false;
+            }
+        }
+
+        bool success = true;
+        if (SDL_UpdateTexture(mTexture, NULL, converted->pixels, converted->pitch) < 0) {
+            printf("Unable to update texture! SDL Error: %s\n", SDL_GetError());
+            success = false;
+        }
+
+        if (converted != surface) {
+            SDL_FreeSurface(converted);
+        }
+
+        return success;
+    }
+
+    // Dimensions changed, texture has to be recreated
+    SDL_Surface* pixels = mPixels;
+    mPixels = NULL;
+    free();
+    mPixels = pixels;
+
+    mTexture = SDL_CreateTextureFromSurface(gRenderer, surface);
+    if (mTexture == NULL) {
+        printf("Unable to create texture from surface! SDL Error: %s\n", SDL_GetError());
+    } else {
+        mWidth = surface->w;
+        mHeight = surface->h;
+    }
+
+    return mTexture != NULL;
+}
+
 void LTexture::setColor(Uint8 red, Uint8 green, Uint8 blue)
 {
     SDL_SetTextureColorMod(mTexture, red, green, blue);
@@ -134,9 +502,192 @@ void LTexture::render(int x, int y, SDL_Rect* clip, double angle, SDL_Point* cen
         renderQuad.h = clip->h;
     }
 
+    // Snapped angles draw a pre-rendered variant with a plain copy
+    if (mRotationSteps > 0 && (angle != 0 || flip != SDL_FLIP_NONE)) {
+        double stepAngle = 360.0 / mRotationSteps;
+        double nearest = floor(angle / stepAngle + 0.5);
+
+        if (fabs(angle - nearest * stepAngle) < ROTATION_SNAP_EPSILON) {
+            int step = ((int)fmod(nearest, mRotationSteps) + mRotationSteps) % mRotationSteps;
+
+            RotatedVariant* variant = getRotatedVariant(step, clip, center, flip);
+            if (variant != NULL) {
+                SDL_Rect variantQuad = {x + variant->offsetX, y + variant->offsetY, variant->width, variant->height};
+                SDL_RenderCopy(gRenderer, variant->texture, NULL, &variantQuad);
+                return;
+            }
+        }
+    }
+
+    // Rotate straight into the software target instead of SDL's rotozoom
+    if (gSoftwareTarget != NULL && mPixels != NULL && (angle != 0 || flip != SDL_FLIP_NONE) && SDL_GetRenderTarget(gRenderer) == NULL) {
+        SDL_Rect source = {0, 0, mWidth, mHeight};
+        if (clip != NULL) {
+            source = *clip;
+        }
+
+        SDL_Point pivot = {renderQuad.w / 2, renderQuad.h / 2};
+        if (center != NULL) {
+            pivot = *center;
+        }
+
+        SDL_Color mod;
+        SDL_BlendMode blendMode;
+        SDL_GetTextureColorMod(mTexture, &mod.r, &mod.g, &mod.b);
+        SDL_GetTextureAlphaMod(mTexture, &mod.a);
+        SDL_GetTextureBlendMode(mTexture, &blendMode);
+
+        // Draws queued so far have to reach the surface first
+        SDL_RenderFlush(gRenderer);
+
+        if (rotozoomBlit(mPixels, &source, gSoftwareTarget, &renderQuad, angle, &pivot, flip, mod, blendMode)) {
+            return;
+        }
+    }
+
     SDL_RenderCopyEx(gRenderer, mTexture, clip, &renderQuad, angle, center, flip);
 }
 
+void LTexture::enableRotationCache(int steps, int capacity)
+{
+    clearRotationCache();
+
+    // Nothing could be kept, every lookup would evict the variant it just made
+    mRotationSteps = capacity > 0 ? steps : 0;
+    mRotationCapacity = capacity;
+}
+
+LTexture::RotatedVariant* LTexture::getRotatedVariant(int step, SDL_Rect* clip, SDL_Point* center, SDL_RendererFlip flip)
+{
+    SDL_Rect source = {0, 0, mWidth, mHeight};
+    if (clip != NULL) {
+        source = *clip;
+    }
+
+    SDL_Point pivot = {source.w / 2, source.h / 2};
+    if (center != NULL) {
+        pivot = *center;
+    }
+
+    // Modulation and blending are applied when the variant is drawn
+    Uint8 r, g, b, a;
+    SDL_BlendMode blendMode;
+    SDL_GetTextureColorMod(mTexture, &r, &g, &b);
+    SDL_GetTextureAlphaMod(mTexture, &a);
+    SDL_GetTextureBlendMode(mTexture, &blendMode);
+
+    for (std::list<RotatedVariant>::iterator it = mRotationCache.begin(); it != mRotationCache.end(); ++it) {
+        if (it->step == step && it->flip == flip && SDL_RectEquals(&it->clip, &source) && it->center.x == pivot.x && it->center.y == pivot.y) {
+            mRotationCache.splice(mRotationCache.begin(), mRotationCache, it);
+            ++mRotationHits;
+
+            RotatedVariant* variant = &mRotationCache.front();
+            SDL_SetTextureColorMod(variant->texture, r, g, b);
+            SDL_SetTextureAlphaMod(variant->texture, a);
+            SDL_SetTextureBlendMode(variant->texture, blendMode);
+            return variant;
+        }
+    }
+
+    ++mRotationMisses;
+
+    // Bounds of the quad corners rotated around the pivot
+    double degrees = step * 360.0 / mRotationSteps;
+    double radians = degrees * M_PI / 180.0;
+    double cosine = cos(radians);
+    double sine = sin(radians);
+
+    double minX = 0, minY = 0, maxX = 0, maxY = 0;
+    for (int corner = 0; corner < 4; ++corner) {
+        double cornerX = (corner & 1 ? source.w : 0) - pivot.x;
+        double cornerY = (corner & 2 ? source.h : 0) - pivot.y;
+        double rotatedX = cornerX * cosine - cornerY * sine;
+        double rotatedY = cornerX * sine + cornerY * cosine;
+
+        minX = corner == 0 ? rotatedX : SDL_min(minX, rotatedX);
+        minY = corner == 0 ? rotatedY : SDL_min(minY, rotatedY);
+        maxX = corner == 0 ? rotatedX : SDL_max(maxX, rotatedX);
+        maxY = corner == 0 ? rotatedY : SDL_max(maxY, rotatedY);
+    }
+
+    int left = (int)floor(minX);
+    int top = (int)floor(minY);
+    int width = (int)ceil(maxX) - left;
+    int height = (int)ceil(maxY) - top;
+
+    SDL_Texture* texture = SDL_CreateTexture(gRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+    if (texture == NULL) {
+        printf("Unable to create rotation cache texture, disabling cache! SDL Error: %s\n", SDL_GetError());
+        enableRotationCache(0, 0);
+        return NULL;
+    }
+
+    // Rotate once into the variant, copying pixels as they are
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(gRenderer);
+    Uint8 drawR, drawG, drawB, drawA;
+    SDL_GetRenderDrawColor(gRenderer, &drawR, &drawG, &drawB, &drawA);
+
+    SDL_SetTextureColorMod(mTexture, 0xFF, 0xFF, 0xFF);
+    SDL_SetTextureAlphaMod(mTexture, 0xFF);
+    SDL_SetTextureBlendMode(mTexture, SDL_BLENDMODE_NONE);
+
+    SDL_SetRenderTarget(gRenderer, texture);
+    SDL_SetRenderDrawColor(gRenderer, 0, 0, 0, 0);
+    SDL_RenderClear(gRenderer);
+
+    SDL_Rect rotateQuad = {-left - pivot.x, -top - pivot.y, source.w, source.h};
+    SDL_RenderCopyEx(gRenderer, mTexture, &source, &rotateQuad, degrees, &pivot, flip);
+
+    SDL_SetRenderTarget(gRenderer, previousTarget);
+    SDL_SetRenderDrawColor(gRenderer, drawR, drawG, drawB, drawA);
+
+    SDL_SetTextureColorMod(mTexture, r, g, b);
+    SDL_SetTextureAlphaMod(mTexture, a);
+    SDL_SetTextureBlendMode(mTexture, blendMode);
+
+    SDL_SetTextureColorMod(texture, r, g, b);
+    SDL_SetTextureAlphaMod(texture, a);
+    SDL_SetTextureBlendMode(texture, blendMode);
+
+    RotatedVariant variant;
+    variant.step = step;
+    variant.flip = flip;
+    variant.clip = source;
+    variant.center = pivot;
+    variant.texture = texture;
+    variant.offsetX = pivot.x + left;
+    variant.offsetY = pivot.y + top;
+    variant.width = width;
+    variant.height = height;
+    mRotationCache.push_front(variant);
+
+    // Drop the least recently drawn variant
+    if (mRotationCache.size() > mRotationCapacity) {
+        SDL_DestroyTexture(mRotationCache.back().texture);
+        mRotationCache.pop_back();
+        ++mRotationEvictions;
+    }
+
+    return &mRotationCache.front();
+}
+
+void LTexture::clearRotationCache()
+{
+    for (std::list<RotatedVariant>::iterator it = mRotationCache.begin(); it != mRotationCache.end(); ++it) {
+        SDL_DestroyTexture(it->texture);
+    }
+
+    mRotationCache.clear();
+}
+
+void LTexture::printRotationCacheStats()
+{
+    if (mRotationSteps > 0) {
+        printf("Rotation cache: %llu hits, %llu misses, %llu evictions, %d variants\n",
+            (unsigned long long)mRotationHits, (unsigned long long)mRotationMisses, (unsigned long long)mRotationEvictions, (int)mRotationCache.size());
+    }
+}
+
 int LTexture::getWidth()
 {
     return mWidth;
@@ -147,120 +698,1373 @@ int LTexture::getHeight()
     return mHeight;
 }
 
-bool init()
+LInput::LInput()
 {
-    bool success = true;
+    mMouseX = 0;
+    mMouseY = 0;
+    mMouseDeltaX = 0;
+    mMouseDeltaY = 0;
+    mMouseMoved = false;
+    mButtonsDown = 0;
+    mButtonsPressed = 0;
+    mButtonsReleased = 0;
 
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        printf("SDL failed to initialize!\n");
-        success = false;
-    } else {
-        gWindow = SDL_CreateWindow("SDL Tutorial", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
-        if (gWindow == NULL) {
-            printf("Failed to create window! SDL Error: %s\n", SDL_GetError());
-            success = false;
-        } else {
-            gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-            if (gRenderer == NULL) {
-                printf("Failed to create renderer! SDL Error: %s\n", SDL_GetError());
-                success = false;
-            } else {
-                SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+    mQuit = false;
 
-                int imgFlag = IMG_INIT_PNG;
-                if (!(IMG_Init(imgFlag) & imgFlag)) {
-                    printf("SDL Image failed to initialize! SDL_Image Error: %s\n", IMG_GetError());
-                    success = false;
-                }
-            }
-        }
-    }
+    mPushedEvents = 0;
+    mAcceptedEvents = 0;
+    mDispatchedEvents = 0;
+    mFrames = 0;
 
-    return true;
+    mRecording = NULL;
+    mReplayNext = 0;
+    mReplaying = false;
+
+    // Quit is always wanted and window events feed the renderer's own event watch
+    subscribe(SDL_QUIT);
+    subscribe(SDL_WINDOWEVENT);
 }
 
-bool loadMedia()
+void LInput::subscribe(Uint32 type)
 {
-    bool success = true;
-
-    if (!gArrowTexture.loadFromFile("arrow.png")) {
-        printf("Failed to arrow texture!\n");
-        success = false;
-    }
+    mSubscribed.set(type);
+}
 
-    return success;
+void LInput::installFilter()
+{
+    SDL_SetEventFilter(eventFilter, this);
 }
 
-void close()
+int LInput::eventFilter(void* userdata, SDL_Event* e)
 {
-    gArrowTexture.free();
+    LInput* input = (LInput*)userdata;
 
-    SDL_DestroyRenderer(gRenderer);
-    SDL_DestroyWindow(gWindow);
-    gWindow = NULL;
-    gRenderer = NULL;
+    ++input->mPushedEvents;
+    if (!input->mSubscribed.test(e->type)) {
+        return 0;
+    }
 
-    IMG_Quit();
-    SDL_Quit();
+    ++input->mAcceptedEvents;
+    return 1;
 }
 
-int main (int argc, char *argv[])
+void LInput::bindAction(int action, SDL_Keycode keycode, bool repeats)
 {
-    if (!init()) {
-        printf("Failed to initialize!\n");
-    } else {
-        if (!loadMedia()) {
-            printf("Failed to load media!\n");
-        } else {
-            bool quit = false;
+    if (action >= (int)mActionBindings.size()) {
+        mActionBindings.resize(action + 1, SDLK_UNKNOWN);
+        mActionRepeats.resize(action + 1, false);
+    }
 
-            SDL_Event e;
+    mActionBindings[action] = keycode;
+    mActionRepeats[action] = repeats;
+}
 
-            double degrees = 0;
+void LInput::update()
+{
+    // Clear edges of the previous frame
+    mKeysPressed.reset();
+    mKeysReleased.reset();
+    mKeysRepeated.reset();
+    mButtonsPressed = 0;
+    mButtonsReleased = 0;
+    mMouseDeltaX = 0;
+    mMouseDeltaY = 0;
+    mMouseMoved = false;
 
-            SDL_RendererFlip flipType = SDL_FLIP_NONE;
+    // Replayed events go through the filter and the queue like live ones
+    if (mReplaying) {
+        while (mReplayNext < mReplayEvents.size() && mReplayFrames[mReplayNext] <= mFrames) {
+            SDL_PushEvent(&mReplayEvents[mReplayNext]);
+            ++mReplayNext;
+        }
+    }
 
-            while(!quit) {
-                while (SDL_PollEvent(&e) != 0) {
-                    if (e.type == SDL_QUIT) {
-                        quit = true;
-                    } else if (e.type == SDL_KEYDOWN) {
-                        switch(e.key.keysym.sym) {
-                            case SDLK_a:
-                            degrees -= 60;
-                            break;
-
-                            case SDLK_d:
-                            degrees += 60;
-                            break;
-
-                            case SDLK_q:
-                            flipType = SDL_FLIP_HORIZONTAL;
-                            break;
-
-                            case SDLK_w:
-                            flipType = SDL_FLIP_NONE;
-                            break;
-
-                            case SDLK_e:
-                            flipType = SDL_FLIP_VERTICAL;
-                            break;
-                        }
-                    }
-                }
+    SDL_Event e;
+    while (SDL_PollEvent(&e) != 0) {
+        if (mRecording != NULL) {
+            writeEvent(mRecording, (Uint32)mFrames, e);
+        }
 
-                SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
-                SDL_RenderClear(gRenderer);
+        switch (e.type) {
+            case SDL_QUIT:
+            mQuit = true;
+            ++mDispatchedEvents;
+            break;
 
-                gArrowTexture.render((SCREEN_WIDTH - gArrowTexture.getWidth()) / 2, (SCREEN_HEIGHT - gArrowTexture.getHeight()) / 2, NULL, degrees, NULL, flipType);
+            case SDL_KEYDOWN:
+            if (!e.key.repeat) {
+                mKeysDown.set(e.key.keysym.scancode);
+                mKeysPressed.set(e.key.keysym.scancode);
+            } else {
+                mKeysRepeated.set(e.key.keysym.scancode);
+            }
+            ++mDispatchedEvents;
+            break;
 
-                SDL_RenderPresent(gRenderer);
+            case SDL_KEYUP:
+            mKeysDown.reset(e.key.keysym.scancode);
+            mKeysReleased.set(e.key.keysym.scancode);
+            ++mDispatchedEvents;
+            break;
+
+            // Consecutive motion events collapse into one delta
+            case SDL_MOUSEMOTION:
+            mMouseX = e.motion.x;
+            mMouseY = e.motion.y;
+            mMouseDeltaX += e.motion.xrel;
+            mMouseDeltaY += e.motion.yrel;
+            if (!mMouseMoved) {
+                mMouseMoved = true;
+                ++mDispatchedEvents;
             }
+            break;
+
+            case SDL_MOUSEBUTTONDOWN:
+            mMouseX = e.button.x;
+            mMouseY = e.button.y;
+            mButtonsDown |= SDL_BUTTON(e.button.button);
+            mButtonsPressed |= SDL_BUTTON(e.button.button);
+            ++mDispatchedEvents;
+            break;
+
+            case SDL_MOUSEBUTTONUP:
+            mMouseX = e.button.x;
+            mMouseY = e.button.y;
+            mButtonsDown &= ~SDL_BUTTON(e.button.button);
+            mButtonsReleased |= SDL_BUTTON(e.button.button);
+            ++mDispatchedEvents;
+            break;
+        }
+    }
+
+    if (mReplaying && mReplayNext == mReplayEvents.size()) {
+        mQuit = true;
+    }
+
+    ++mFrames;
+}
+
+bool LInput::quitRequested()
+{
+    return mQuit;
+}
+
+bool LInput::isKeyDown(SDL_Scancode scancode)
+{
+    return mKeysDown.test(scancode);
+}
+
+bool LInput::wasKeyPressed(SDL_Scancode scancode)
+{
+    return mKeysPressed.test(scancode);
+}
+
+bool LInput::wasKeyReleased(SDL_Scancode scancode)
+{
+    return mKeysReleased.test(scancode);
+}
+
+bool LInput::anyKeyPressed()
+{
+    return mKeysPressed.any();
+}
+
+SDL_Scancode LInput::getActionScancode(int action)
+{
+    // Looked up on every query so a layout switch applies right away
+    if (action < 0 || action >= (int)mActionBindings.size()) {
+        return SDL_SCANCODE_UNKNOWN;
+    }
+
+    return SDL_GetScancodeFromKey(mActionBindings[action]);
+}
+
+bool LInput::isActionDown(int action)
+{
+    return isKeyDown(getActionScancode(action));
+}
+
+bool LInput::wasActionPressed(int action)
+{
+    SDL_Scancode scancode = getActionScancode(action);
+    if (scancode == SDL_SCANCODE_UNKNOWN) {
+        return false;
+    }
+
+    return wasKeyPressed(scancode) || (mActionRepeats[action] && mKeysRepeated.test(scancode));
+}
+
+bool LInput::wasActionReleased(int action)
+{
+    return wasKeyReleased(getActionScancode(action));
+}
+
+int LInput::getMouseX()
+{
+    return mMouseX;
+}
+
+int LInput::getMouseY()
+{
+    return mMouseY;
+}
+
+int LInput::getMouseDeltaX()
+{
+    return mMouseDeltaX;
+}
+
+int LInput::getMouseDeltaY()
+{
+    return mMouseDeltaY;
+}
+
+bool LInput::mouseMoved()
+{
+    return mMouseMoved;
+}
+
+bool LInput::isButtonDown(Uint8 button)
+{
+    return (mButtonsDown & SDL_BUTTON(button)) != 0;
+}
+
+bool LInput::wasButtonPressed(Uint8 button)
+{
+    return (mButtonsPressed & SDL_BUTTON(button)) != 0;
+}
+
+bool LInput::wasButtonReleased(Uint8 button)
+{
+    return (mButtonsReleased & SDL_BUTTON(button)) != 0;
+}
+
+bool LInput::startRecording(std::string path)
+{
+    mRecording = SDL_RWFromFile(path.c_str(), "wb");
+    if (mRecording == NULL) {
+        printf("Failed to create input recording %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+        return false;
+    }
+
+    SDL_RWwrite(mRecording, INPUT_LOG_MAGIC, 4, 1);
+    SDL_WriteLE16(mRecording, INPUT_LOG_VERSION);
+
+    return true;
+}
+
+void LInput::stopRecording()
+{
+    if (mRecording != NULL) {
+        SDL_RWclose(mRecording);
+        mRecording = NULL;
+    }
+}
+
+bool LInput::startReplay(std::string path)
+{
+    SDL_RWops* log = SDL_RWFromFile(path.c_str(), "rb");
+    if (log == NULL) {
+        printf("Failed to open input recording %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+        return false;
+    }
+
+    char magic[4];
+    bool success = SDL_RWread(log, magic, 4, 1) == 1 && memcmp(magic, INPUT_LOG_MAGIC, 4) == 0 && SDL_ReadLE16(log) == INPUT_LOG_VERSION;
+    if (!success) {
+        printf("%s is not an input recording!\n", path.c_str());
+    } else {
+        mReplayEvents.clear();
+        mReplayFrames.clear();
+
+        Uint32 frame;
+        SDL_Event e;
+        while (readEvent(log, &frame, &e)) {
+            mReplayEvents.push_back(e);
+            mReplayFrames.push_back(frame);
+        }
+
+        mReplayNext = 0;
+        mReplaying = true;
+    }
+
+    SDL_RWclose(log);
+    return success;
+}
+
+bool LInput::isReplaying()
+{
+    return mReplaying;
+}
+
+bool LInput::writeEvent(SDL_RWops* log, Uint32 frame, const SDL_Event& e)
+{
+    int kind = 0;
+    while (kind < INPUT_RECORD_TYPE_COUNT && INPUT_RECORD_TYPES[kind] != e.type) {
+        ++kind;
+    }
+    if (kind == INPUT_RECORD_TYPE_COUNT) {
+        return false;
+    }
+
+    // Only the fields LInput reads, a key press takes 14 bytes instead of a whole SDL_Event
+    SDL_WriteU8(log, (Uint8)kind);
+    SDL_WriteLE32(log, frame);
+
+    switch (e.type) {
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+        SDL_WriteLE16(log, (Uint16)e.key.keysym.scancode);
+        SDL_WriteLE32(log, (Uint32)e.key.keysym.sym);
+        SDL_WriteLE16(log, e.key.keysym.mod);
+        SDL_WriteU8(log, e.key.repeat);
+        break;
+
+        case SDL_MOUSEMOTION:
+        SDL_WriteLE32(log, e.motion.state);
+        SDL_WriteLE16(log, (Uint16)e.motion.x);
+        SDL_WriteLE16(log, (Uint16)e.motion.y);
+        SDL_WriteLE16(log, (Uint16)e.motion.xrel);
+        SDL_WriteLE16(log, (Uint16)e.motion.yrel);
+        break;
+
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+        SDL_WriteU8(log, e.button.button);
+        SDL_WriteU8(log, e.button.clicks);
+        SDL_WriteLE16(log, (Uint16)e.button.x);
+        SDL_WriteLE16(log, (Uint16)e.button.y);
+        break;
+    }
+
+    return true;
+}
+
+bool LInput::readEvent(SDL_RWops* log, Uint32* frame, SDL_Event* e)
+{
+    Uint8 kind;
+    if (SDL_RWread(log, &kind, 1, 1) != 1 || kind >= INPUT_RECORD_TYPE_COUNT) {
+        return false;
+    }
+
+    SDL_zerop(e);
+    e->type = INPUT_RECORD_TYPES[kind];
+    *frame = SDL_ReadLE32(log);
+
+    switch (e->type) {
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+        e->key.state = e->type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+        e->key.keysym.scancode = (SDL_Scancode)SDL_ReadLE16(log);
+        e->key.keysym.sym = (SDL_Keycode)SDL_ReadLE32(log);
+        e->key.keysym.mod = SDL_ReadLE16(log);
+        e->key.repeat = SDL_ReadU8(log);
+        break;
+
+        case SDL_MOUSEMOTION:
+        e->motion.state = SDL_ReadLE32(log);
+        e->motion.x = (Sint16)SDL_ReadLE16(log);
+        e->motion.y = (Sint16)SDL_ReadLE16(log);
+        e->motion.xrel = (Sint16)SDL_ReadLE16(log);
+        e->motion.yrel = (Sint16)SDL_ReadLE16(log);
+        break;
+
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+        e->button.button = SDL_ReadU8(log);
+        e->button.state = e->type == SDL_MOUSEBUTTONDOWN ? SDL_PRESSED : SDL_RELEASED;
+        e->button.clicks = SDL_ReadU8(log);
+        e->button.x = (Sint16)SDL_ReadLE16(log);
+        e->button.y = (Sint16)SDL_ReadLE16(log);
+        break;
+    }
+
+    return true;
+}
+
+void LInput::printStats()
+{
+    if (mFrames == 0) {
+        return;
+    }
+
+    double frames = (double)mFrames;
+    printf("Input: %llu frames, events per frame: %.2f pushed, %.2f after filter, %.2f after coalescing\n",
+        (unsigned long long)mFrames, mPushedEvents / frames, mAcceptedEvents / frames, mDispatchedEvents / frames);
+}
+
+LAssetWatcher::LAssetWatcher()
+{
+    mInotify = -1;
+    mRunning = false;
+}
+
+LAssetWatcher::~LAssetWatcher()
+{
+    stop();
+}
+
+void LAssetWatcher::watch(LTexture* texture, std::string path)
+{
+    mWatched[path].push_back(texture);
+}
+
+bool LAssetWatcher::start(std::string directory)
+{
+#if defined(__linux__)
+    mInotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (mInotify < 0) {
+        printf("Unable to start asset watcher! inotify Error: %s\n", strerror(errno));
+        return false;
+    }
+
+    // Editors either rewrite the file or rename a temporary over it
+    if (inotify_add_watch(mInotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        printf("Unable to watch %s! inotify Error: %s\n", directory.c_str(), strerror(errno));
+        close(mInotify);
+        mInotify = -1;
+        return false;
+    }
+
+    mDirectory = directory;
+    mRunning = true;
+    mThread = std::thread(&LAssetWatcher::run, this);
+    return true;
+#else
+    printf("Asset watcher is only supported on Linux!\n");
+    return false;
+#endif
+}
+
+void LAssetWatcher::stop()
+{
+    if (mRunning) {
+        mRunning = false;
+        mThread.join();
+    }
+
+#if defined(__linux__)
+    if (mInotify >= 0) {
+        close(mInotify);
+        mInotify = -1;
+    }
+#endif
+
+    std::map<std::string, SDL_Surface*>::iterator it;
+    for (it = mDecoded.begin(); it != mDecoded.end(); ++it) {
+        SDL_FreeSurface(it->second);
+    }
+    mDecoded.clear();
+}
+
+void LAssetWatcher::run()
+{
+#if defined(__linux__)
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    while (mRunning) {
+        // Wake up regularly to notice stop()
+        pollfd fd = {mInotify, POLLIN, 0};
+        if (poll(&fd, 1, 100) <= 0) {
+            continue;
+        }
+
+        ssize_t length = read(mInotify, buffer, sizeof(buffer));
+        for (char* ptr = buffer; length > 0 && ptr < buffer + length; ) {
+            const struct inotify_event* event = (const struct inotify_event*)ptr;
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->len == 0 || mWatched.find(event->name) == mWatched.end()) {
+                continue;
+            }
+
+            std::string name = event->name;
+            SDL_Surface* surface = decode(mDirectory + "/" + name);
+            if (surface == NULL) {
+                continue;
+            }
+
+            // A newer decode of the same file replaces one not yet uploaded
+            std::lock_guard<std::mutex> lock(mMutex);
+            std::map<std::string, SDL_Surface*>::iterator pending = mDecoded.find(name);
+            if (pending != mDecoded.end()) {
+                SDL_FreeSurface(pending->second);
+                pending->second = surface;
+            } else {
+                mDecoded[name] = surface;
+            }
+        }
+    }
+#endif
+}
+
+SDL_Surface* LAssetWatcher::decode(std::string path)
+{
+    SDL_Surface* loadedSurface = IMG_Load(path.c_str());
+    if (loadedSurface == NULL) {
+        printf("Failed to reload image %s! SDL_Image Error: %s\n", path.c_str(), IMG_GetError());
+        return NULL;
+    }
+
+    // Decode straight into the format textures are created with
+    SDL_Surface* formattedSurface = SDL_ConvertSurfaceFormat(loadedSurface, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (formattedSurface == NULL) {
+        printf("Failed to convert image %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+    }
+
+    SDL_FreeSurface(loadedSurface);
+    return formattedSurface;
+}
+
+void LAssetWatcher::applyReloads()
+{
+    std::map<std::string, SDL_Surface*> decoded;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        decoded.swap(mDecoded);
+    }
+
+    std::map<std::string, SDL_Surface*>::iterator it;
+    for (it = decoded.begin(); it != decoded.end(); ++it) {
+        // Lookup only, the watcher thread reads the map concurrently
+        std::vector<LTexture*>& textures = mWatched.find(it->first)->second;
+        for (size_t i = 0; i < textures.size(); ++i) {
+            if (!textures[i]->updateFromSurface(it->second)) {
+                printf("Failed to reload %s!\n", it->first.c_str());
+            }
+        }
+
+        printf("Reloaded %s\n", it->first.c_str());
+        SDL_FreeSurface(it->second);
+    }
+}
+
+bool init(Uint32 rendererFlags)
+{
+    bool success = true;
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        printf("SDL failed to initialize!\n");
+        success = false;
+    } else {
+        gWindow = SDL_CreateWindow("SDL Tutorial", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
+        if (gWindow == NULL) {
+            printf("Failed to create window! SDL Error: %s\n", SDL_GetError());
+            success = false;
+        } else {
+            gRenderer = SDL_CreateRenderer(gWindow, -1, rendererFlags);
+            if (gRenderer == NULL) {
+                printf("Failed to create renderer! SDL Error: %s\n", SDL_GetError());
+                success = false;
+            } else {
+                SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+
+                int imgFlag = IMG_INIT_PNG;
+                if (!(IMG_Init(imgFlag) & imgFlag)) {
+                    printf("SDL Image failed to initialize! SDL_Image Error: %s\n", IMG_GetError());
+                    success = false;
+                }
+            }
+        }
+    }
+
+    return success;
+}
+
+bool initHeadless()
+{
+    bool success = true;
+
+    gCaptureSurface = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (gCaptureSurface == NULL) {
+        printf("Failed to create capture surface! SDL Error: %s\n", SDL_GetError());
+        success = false;
+    } else {
+        gRenderer = SDL_CreateSoftwareRenderer(gCaptureSurface);
+        if (gRenderer == NULL) {
+            printf("Failed to create software renderer! SDL Error: %s\n", SDL_GetError());
+            success = false;
+        } else {
+            gSoftwareTarget = gCaptureSurface;
+
+            SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+
+            int imgFlag = IMG_INIT_PNG;
+            if (!(IMG_Init(imgFlag) & imgFlag)) {
+                printf("SDL_Image failed to initialize! SDL_Image Error: %s\n", IMG_GetError());
+                success = false;
+            }
+        }
+    }
+
+    return success;
+}
+
+SDL_Surface* captureFrame()
+{
+    SDL_Surface* frame = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (frame == NULL) {
+        printf("Failed to create frame surface! SDL Error: %s\n", SDL_GetError());
+        return NULL;
+    }
+
+    if (SDL_RenderReadPixels(gRenderer, NULL, SDL_PIXELFORMAT_ARGB8888, frame->pixels, frame->pitch) < 0) {
+        printf("Failed to read back frame! SDL Error: %s\n", SDL_GetError());
+        SDL_FreeSurface(frame);
+        return NULL;
+    }
+
+    return frame;
+}
+
+int diffPixels(const Uint32* a, const Uint32* b, int count, Uint8 tolerance)
+{
+    int matches = 0;
+    int i = 0;
+
+    // |a - b| per byte from two saturating subtractions, then anything
+    // left after subtracting tolerance is a mismatching channel
+#if defined(__AVX2__)
+    const __m256i tol = _mm256_set1_epi8((char)tolerance);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i matched = _mm256_setzero_si256();
+    for (; i + 8 <= count; i += 8) {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i diff = _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va));
+        __m256i over = _mm256_subs_epu8(diff, tol);
+        matched = _mm256_sub_epi32(matched, _mm256_cmpeq_epi32(over, zero));
+    }
+
+    Uint32 lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, matched);
+    for (int lane = 0; lane < 8; ++lane) {
+        matches += lanes[lane];
+    }
+#elif defined(__SSE2__)
+    const __m128i tol = _mm_set1_epi8((char)tolerance);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i matched = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i diff = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+        __m128i over = _mm_subs_epu8(diff, tol);
+        matched = _mm_sub_epi32(matched, _mm_cmpeq_epi32(over, zero));
+    }
+
+    Uint32 lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, matched);
+    for (int lane = 0; lane < 4; ++lane) {
+        matches += lanes[lane];
+    }
+#endif
+
+    for (; i < count; ++i) {
+        bool match = true;
+        for (int shift = 0; shift < 32; shift += 8) {
+            int ca = (a[i] >> shift) & 0xFF;
+            int cb = (b[i] >> shift) & 0xFF;
+            if (ca - cb > tolerance || cb - ca > tolerance) {
+                match = false;
+            }
+        }
+
+        if (match) {
+            ++matches;
+        }
+    }
+
+    return count - matches;
+}
+
+int diffSurfaces(SDL_Surface* a, SDL_Surface* b, Uint8 tolerance)
+{
+    int threadCount = 1;
+    if (a->w * a->h >= GOLDEN_PARALLEL_PIXELS) {
+        threadCount = SDL_max(1, SDL_GetCPUCount());
+    }
+
+    // Each thread diffs a band of rows
+    std::vector<int> mismatches(threadCount, 0);
+    std::vector<std::thread> threads;
+    int rowsPerThread = (a->h + threadCount - 1) / threadCount;
+
+    for (int t = 0; t < threadCount; ++t) {
+        int first = t * rowsPerThread;
+        int last = SDL_min(a->h, first + rowsPerThread);
+
+        auto band = [=, &mismatches]() {
+            for (int y = first; y < last; ++y) {
+                const Uint32* rowA = (const Uint32*)((const Uint8*)a->pixels + y * a->pitch);
+                const Uint32* rowB = (const Uint32*)((const Uint8*)b->pixels + y * b->pitch);
+                mismatches[t] += diffPixels(rowA, rowB, a->w, tolerance);
+            }
+        };
+
+        if (t == threadCount - 1) {
+            band();
+        } else {
+            threads.push_back(std::thread(band));
+        }
+    }
+
+    int total = 0;
+    for (size_t t = 0; t < threads.size(); ++t) {
+        threads[t].join();
+    }
+    for (int t = 0; t < threadCount; ++t) {
+        total += mismatches[t];
+    }
+
+    return total;
+}
+
+bool saveDiffHeatmap(SDL_Surface* frame, SDL_Surface* golden, std::string path)
+{
+    SDL_Surface* heatmap = SDL_CreateRGBSurfaceWithFormat(0, frame->w, frame->h, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (heatmap == NULL) {
+        printf("Failed to create heatmap surface! SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+
+    // Matching pixels show as a faint copy of the golden, mismatches in red by severity
+    for (int y = 0; y < frame->h; ++y) {
+        const Uint32* rowFrame = (const Uint32*)((const Uint8*)frame->pixels + y * frame->pitch);
+        const Uint32* rowGolden = (const Uint32*)((const Uint8*)golden->pixels + y * golden->pitch);
+        Uint32* rowHeat = (Uint32*)((Uint8*)heatmap->pixels + y * heatmap->pitch);
+
+        for (int x = 0; x < frame->w; ++x) {
+            int maxDiff = 0;
+            int luma = 0;
+            for (int shift = 0; shift < 32; shift += 8) {
+                int ca = (rowFrame[x] >> shift) & 0xFF;
+                int cb = (rowGolden[x] >> shift) & 0xFF;
+                maxDiff = SDL_max(maxDiff, ca > cb ? ca - cb : cb - ca);
+                luma += cb;
+            }
+
+            if (maxDiff > GOLDEN_TOLERANCE) {
+                Uint32 red = 0x80 + maxDiff / 2;
+                rowHeat[x] = 0xFF000000 | (red << 16);
+            } else {
+                Uint32 gray = luma / 16;
+                rowHeat[x] = 0xFF000000 | (gray << 16) | (gray << 8) | gray;
+            }
+        }
+    }
+
+    bool success = true;
+    if (IMG_SavePNG(heatmap, path.c_str()) < 0) {
+        printf("Failed to save heatmap %s! SDL_Image Error: %s\n", path.c_str(), IMG_GetError());
+        success = false;
+    }
+
+    SDL_FreeSurface(heatmap);
+    return success;
+}
+
+bool runGolden(std::string path, bool compare)
+{
+    SDL_Surface* frame = captureFrame();
+    if (frame == NULL) {
+        return false;
+    }
+
+    bool success = true;
+
+    if (!compare) {
+        if (IMG_SavePNG(frame, path.c_str()) < 0) {
+            printf("Failed to save golden image %s! SDL_Image Error: %s\n", path.c_str(), IMG_GetError());
+            success = false;
+        } else {
+            printf("Captured %s\n", path.c_str());
+        }
+    } else {
+        SDL_Surface* loadedSurface = IMG_Load(path.c_str());
+        SDL_Surface* golden = NULL;
+        if (loadedSurface == NULL) {
+            printf("Failed to load golden image %s! SDL_Image Error: %s\n", path.c_str(), IMG_GetError());
+        } else {
+            golden = SDL_ConvertSurfaceFormat(loadedSurface, SDL_PIXELFORMAT_ARGB8888, 0);
+            SDL_FreeSurface(loadedSurface);
+        }
+
+        if (golden == NULL) {
+            success = false;
+        } else if (golden->w != frame->w || golden->h != frame->h) {
+            printf("Golden image %s is %dx%d, frame is %dx%d!\n", path.c_str(), golden->w, golden->h, frame->w, frame->h);
+            success = false;
+        } else {
+            Uint64 start = SDL_GetPerformanceCounter();
+            int mismatches = diffSurfaces(frame, golden, GOLDEN_TOLERANCE);
+            double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+            printf("Compared against %s in %.3f ms, %d pixels over tolerance\n", path.c_str(), ms, mismatches);
+            if (mismatches > 0) {
+                saveDiffHeatmap(frame, golden, path + ".diff.png");
+                success = false;
+            }
+        }
+
+        SDL_FreeSurface(golden);
+    }
+
+    SDL_FreeSurface(frame);
+    return success;
+}
+
+void runDiffBenchmark()
+{
+    const int width = 3840;
+    const int height = 2160;
+    const int runs = 20;
+
+    SDL_Surface* a = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Surface* b = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (a == NULL || b == NULL) {
+        printf("Failed to create benchmark surfaces! SDL Error: %s\n", SDL_GetError());
+    } else {
+        SDL_FillRect(a, NULL, 0xFF808080);
+        SDL_FillRect(b, NULL, 0xFF818081);
+
+        // Warm up caches and thread startup once
+        diffSurfaces(a, b, GOLDEN_TOLERANCE);
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        int mismatches = 0;
+        for (int i = 0; i < runs; ++i) {
+            mismatches = diffSurfaces(a, b, GOLDEN_TOLERANCE);
+        }
+        double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency() / runs;
+
+        printf("Diffed %dx%d frames in %.3f ms, %d pixels over tolerance\n", width, height, ms, mismatches);
+    }
+
+    SDL_FreeSurface(a);
+    SDL_FreeSurface(b);
+}
+
+// Integer division rounding toward negative infinity
+static inline Sint64 floorDiv(Sint64 a, Sint64 b)
+{
+    Sint64 q = a / b;
+    if (a % b != 0 && (a < 0) != (b < 0)) {
+        --q;
+    }
+    return q;
+}
+
+// Narrows [first, last) to the steps t where lo <= u + du * t < hi
+static void clipSpan(Sint64 u, Sint64 du, Sint64 lo, Sint64 hi, int* first, int* last)
+{
+    Sint64 from, to;
+    if (du == 0) {
+        from = u >= lo && u < hi ? *first : *last;
+        to = *last;
+    } else if (du > 0) {
+        from = -floorDiv(u - lo, du);
+        to = -floorDiv(u - hi, du);
+    } else {
+        from = floorDiv(hi - u, du) + 1;
+        to = floorDiv(lo - u, du) + 1;
+    }
+
+    *first = (int)SDL_max((Sint64)*first, SDL_min(from, (Sint64)*last));
+    *last = (int)SDL_max((Sint64)*first, SDL_min(to, (Sint64)*last));
+}
+
+// x / 255 rounded, exact for x up to 255 * 255
+static inline int div255(int x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+// Bilinear sample at 16.16 source position, taps outside rect are transparent when checked
+static inline Uint32 sampleBilinear(const Uint8* pixels, int pitch, const SDL_Rect* rect, Sint32 u, Sint32 v, bool checked)
+{
+    int x = u >> 16;
+    int y = v >> 16;
+    int fx = (u >> 8) & 0xFF;
+    int fy = (v >> 8) & 0xFF;
+
+    Uint32 taps[4];
+    for (int tap = 0; tap < 4; ++tap) {
+        int tx = x + (tap & 1);
+        int ty = y + (tap >> 1);
+        if (checked && (tx < rect->x || ty < rect->y || tx >= rect->x + rect->w || ty >= rect->y + rect->h)) {
+            taps[tap] = 0;
+        } else {
+            taps[tap] = *(const Uint32*)(pixels + ty * pitch + tx * 4);
+        }
+    }
+
+    Uint32 texel = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        int left = (((taps[0] >> shift) & 0xFF) * (256 - fy) + ((taps[2] >> shift) & 0xFF) * fy) >> 8;
+        int right = (((taps[1] >> shift) & 0xFF) * (256 - fy) + ((taps[3] >> shift) & 0xFF) * fy) >> 8;
+        texel |= (Uint32)((left * (256 - fx) + right * fx) >> 8) << shift;
+    }
+
+    return texel;
+}
+
+// Modulates texel and writes or blends it over target
+static inline void shadePixel(Uint32 texel, Uint32* target, const int mod[4], bool blend)
+{
+    int channels[4];
+    for (int c = 0; c < 4; ++c) {
+        channels[c] = div255(((texel >> (c * 8)) & 0xFF) * mod[c]);
+    }
+
+    if (blend) {
+        int alpha = channels[3];
+        if (alpha == 0) {
+            return;
+        }
+
+        Uint32 destination = *target;
+        for (int c = 0; c < 4; ++c) {
+            int factor = c == 3 ? 255 : alpha;
+            channels[c] = div255(channels[c] * factor + ((destination >> (c * 8)) & 0xFF) * (255 - alpha));
+        }
+    }
+
+    *target = (Uint32)channels[0] | (Uint32)channels[1] << 8 | (Uint32)channels[2] << 16 | (Uint32)channels[3] << 24;
+}
+
+#if defined(__AVX2__)
+// Two bilinear samples fully inside the source, one pixel per 128 bit lane
+// in the low four 16 bit channels, then modulated and blended like shadePixel
+static inline void shadePixelPairAVX2(const Uint8* pixels, int pitch, Sint32 u0, Sint32 v0, Sint32 u1, Sint32 v1, Uint32* target, __m256i mod, bool blend)
+{
+    const Uint8* row0 = pixels + (v0 >> 16) * pitch + (u0 >> 16) * 4;
+    const Uint8* row1 = pixels + (v1 >> 16) * pitch + (u1 >> 16) * 4;
+
+    // Left and right taps of both pixels, no gathers needed since they are adjacent
+    __m256i top = _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)row0), _mm_loadl_epi64((const __m128i*)row1)));
+    __m256i bottom = _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(row0 + pitch)), _mm_loadl_epi64((const __m128i*)(row1 + pitch))));
+
+    short fx0 = (short)((u0 >> 8) & 0xFF), fy0 = (short)((v0 >> 8) & 0xFF);
+    short fx1 = (short)((u1 >> 8) & 0xFF), fy1 = (short)((v1 >> 8) & 0xFF);
+
+    __m256i wy = _mm256_setr_epi16(fy0, fy0, fy0, fy0, fy0, fy0, fy0, fy0, fy1, fy1, fy1, fy1, fy1, fy1, fy1, fy1);
+    __m256i column = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(top, _mm256_sub_epi16(_mm256_set1_epi16(256), wy)), _mm256_mullo_epi16(bottom, wy)), 8);
+
+    short ix0 = 256 - fx0, ix1 = 256 - fx1;
+    __m256i wx = _mm256_setr_epi16(ix0, ix0, ix0, ix0, fx0, fx0, fx0, fx0, ix1, ix1, ix1, ix1, fx1, fx1, fx1, fx1);
+    __m256i weighted = _mm256_mullo_epi16(column, wx);
+    __m256i texel = _mm256_srli_epi16(_mm256_add_epi16(weighted, _mm256_srli_si256(weighted, 8)), 8);
+
+    // div255 of texel * mod
+    const __m256i half = _mm256_set1_epi16(128);
+    __m256i x = _mm256_add_epi16(_mm256_mullo_epi16(texel, mod), half);
+    texel = _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+
+    if (blend) {
+        __m256i destination = _mm256_cvtepu8_epi16(_mm_set_epi32(0, (int)target[1], 0, (int)target[0]));
+
+        // Alpha of each pixel in every channel, alpha channel itself keeps 255
+        __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(texel, 0xFF), 0xFF);
+        const __m256i alphaLane = _mm256_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1);
+        __m256i factor = _mm256_or_si256(_mm256_andnot_si256(alphaLane, alpha), _mm256_and_si256(alphaLane, _mm256_set1_epi16(255)));
+        __m256i inverse = _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+
+        x = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(texel, factor), _mm256_mullo_epi16(destination, inverse)), half);
+        texel = _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+    }
+
+    __m256i packed = _mm256_packus_epi16(texel, texel);
+    target[0] = (Uint32)_mm_cvtsi128_si32(_mm256_castsi256_si128(packed));
+    target[1] = (Uint32)_mm_cvtsi128_si32(_mm256_extracti128_si256(packed, 1));
+}
+#elif defined(__SSE2__)
+// One bilinear sample fully inside the source in the low four 16 bit
+// channels, then modulated and blended like shadePixel
+static inline void shadePixelSSE2(const Uint8* pixels, int pitch, Sint32 u, Sint32 v, Uint32* target, __m128i mod, bool blend)
+{
+    const Uint8* row = pixels + (v >> 16) * pitch + (u >> 16) * 4;
+    const __m128i zero = _mm_setzero_si128();
+
+    __m128i top = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)row), zero);
+    __m128i bottom = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row + pitch)), zero);
+
+    short fx = (short)((u >> 8) & 0xFF);
+    short fy = (short)((v >> 8) & 0xFF);
+
+    __m128i column = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(top, _mm_set1_epi16(256 - fy)), _mm_mullo_epi16(bottom, _mm_set1_epi16(fy))), 8);
+
+    short ix = 256 - fx;
+    __m128i weighted = _mm_mullo_epi16(column, _mm_setr_epi16(ix, ix, ix, ix, fx, fx, fx, fx));
+    __m128i texel = _mm_srli_epi16(_mm_add_epi16(weighted, _mm_srli_si128(weighted, 8)), 8);
+
+    const __m128i half = _mm_set1_epi16(128);
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(texel, mod), half);
+    texel = _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+
+    if (blend) {
+        __m128i destination = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)*target), zero);
+
+        __m128i alpha = _mm_shufflelo_epi16(texel, 0xFF);
+        const __m128i alphaLane = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, 0);
+        __m128i factor = _mm_or_si128(_mm_andnot_si128(alphaLane, alpha), _mm_and_si128(alphaLane, _mm_set1_epi16(255)));
+        __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+
+        x = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(texel, factor), _mm_mullo_epi16(destination, inverse)), half);
+        texel = _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+    }
+
+    *target = (Uint32)_mm_cvtsi128_si32(_mm_packus_epi16(texel, texel));
+}
+#endif
+
+bool rotozoomBlit(SDL_Surface* src, const SDL_Rect* srcrect, SDL_Surface* dst, const SDL_Rect* dstrect, double angle, const SDL_Point* center, SDL_RendererFlip flip, SDL_Color mod, SDL_BlendMode blendMode)
+{
+    if (src->format->format != SDL_PIXELFORMAT_ARGB8888 || dst->format->format != SDL_PIXELFORMAT_ARGB8888) {
+        return false;
+    }
+    if (blendMode != SDL_BLENDMODE_NONE && blendMode != SDL_BLENDMODE_BLEND) {
+        return false;
+    }
+    if (srcrect->w <= 0 || srcrect->h <= 0 || dstrect->w <= 0 || dstrect->h <= 0) {
+        return true;
+    }
+
+    bool blend = blendMode == SDL_BLENDMODE_BLEND;
+    int mods[4] = {mod.b, mod.g, mod.r, mod.a};
+
+    double pivotX = dstrect->x + center->x;
+    double pivotY = dstrect->y + center->y;
+
+    double radians = angle * M_PI / 180.0;
+    double cosine = cos(radians);
+    double sine = sin(radians);
+
+    // Destination bounds of the rotated quad, clipped to the surface
+    double minX = 0, minY = 0, maxX = 0, maxY = 0;
+    for (int corner = 0; corner < 4; ++corner) {
+        double cornerX = (corner & 1 ? dstrect->w : 0) - center->x;
+        double cornerY = (corner & 2 ? dstrect->h : 0) - center->y;
+        double rotatedX = cornerX * cosine - cornerY * sine;
+        double rotatedY = cornerX * sine + cornerY * cosine;
+
+        minX = corner == 0 ? rotatedX : SDL_min(minX, rotatedX);
+        minY = corner == 0 ? rotatedY : SDL_min(minY, rotatedY);
+        maxX = corner == 0 ? rotatedX : SDL_max(maxX, rotatedX);
+        maxY = corner == 0 ? rotatedY : SDL_max(maxY, rotatedY);
+    }
+
+    const SDL_Rect* clip = &dst->clip_rect;
+    int left = SDL_max(clip->x, (int)floor(pivotX + minX));
+    int top = SDL_max(clip->y, (int)floor(pivotY + minY));
+    int right = SDL_min(clip->x + clip->w, (int)ceil(pivotX + maxX));
+    int bottom = SDL_min(clip->y + clip->h, (int)ceil(pivotY + maxY));
+    if (left >= right || top >= bottom) {
+        return true;
+    }
+
+    // Source position of a destination pixel center is linear in x and y:
+    // rotate back around the pivot, flip and scale into the source rect
+    double scaleX = (double)srcrect->w / dstrect->w;
+    double scaleY = (double)srcrect->h / dstrect->h;
+    double flipX = flip & SDL_FLIP_HORIZONTAL ? -1 : 1;
+    double flipY = flip & SDL_FLIP_VERTICAL ? -1 : 1;
+
+    double uPerX = cosine * flipX * scaleX;
+    double vPerX = -sine * flipY * scaleY;
+
+    Sint32 du = (Sint32)floor(uPerX * 65536.0 + 0.5);
+    Sint32 dv = (Sint32)floor(vPerX * 65536.0 + 0.5);
+
+    // Spans where some tap or every tap lies inside the source rect
+    const Sint64 one = 65536;
+    Sint64 outerU0 = (srcrect->x - 1) * one, outerU1 = (Sint64)(srcrect->x + srcrect->w) * one;
+    Sint64 outerV0 = (srcrect->y - 1) * one, outerV1 = (Sint64)(srcrect->y + srcrect->h) * one;
+    Sint64 innerU0 = srcrect->x * one, innerU1 = (Sint64)(srcrect->x + srcrect->w - 1) * one;
+    Sint64 innerV0 = srcrect->y * one, innerV1 = (Sint64)(srcrect->y + srcrect->h - 1) * one;
+
+    const Uint8* pixels = (const Uint8*)src->pixels;
+    int count = right - left;
+
+#if defined(__AVX2__)
+    const __m256i modVector = _mm256_setr_epi16(mods[0], mods[1], mods[2], mods[3], 0, 0, 0, 0, mods[0], mods[1], mods[2], mods[3], 0, 0, 0, 0);
+#elif defined(__SSE2__)
+    const __m128i modVector = _mm_setr_epi16(mods[0], mods[1], mods[2], mods[3], 0, 0, 0, 0);
+#endif
+
+    for (int y = top; y < bottom; ++y) {
+        double relX = left + 0.5 - pivotX;
+        double relY = y + 0.5 - pivotY;
+
+        double localX = relX * cosine + relY * sine + center->x;
+        double localY = -relX * sine + relY * cosine + center->y;
+        if (flip & SDL_FLIP_HORIZONTAL) {
+            localX = dstrect->w - localX;
+        }
+        if (flip & SDL_FLIP_VERTICAL) {
+            localY = dstrect->h - localY;
+        }
+
+        Sint32 u = (Sint32)floor((localX * scaleX + srcrect->x - 0.5) * 65536.0 + 0.5);
+        Sint32 v = (Sint32)floor((localY * scaleY + srcrect->y - 0.5) * 65536.0 + 0.5);
+
+        int outerFirst = 0, outerLast = count;
+        clipSpan(u, du, outerU0, outerU1, &outerFirst, &outerLast);
+        clipSpan(v, dv, outerV0, outerV1, &outerFirst, &outerLast);
+
+        int innerFirst = outerFirst, innerLast = outerLast;
+        clipSpan(u, du, innerU0, innerU1, &innerFirst, &innerLast);
+        clipSpan(v, dv, innerV0, innerV1, &innerFirst, &innerLast);
+        if (innerFirst >= innerLast) {
+            innerFirst = outerLast;
+            innerLast = outerLast;
+        }
+
+        Uint32* row = (Uint32*)((Uint8*)dst->pixels + y * dst->pitch) + left;
+
+        // Edges sample partly outside the source and fade out
+        for (int i = outerFirst; i < innerFirst; ++i) {
+            shadePixel(sampleBilinear(pixels, src->pitch, srcrect, u + du * i, v + dv * i, true), row + i, mods, blend);
+        }
+
+        int i = innerFirst;
+#if defined(__AVX2__)
+        for (; i + 2 <= innerLast; i += 2) {
+            shadePixelPairAVX2(pixels, src->pitch, u + du * i, v + dv * i, u + du * (i + 1), v + dv * (i + 1), row + i, modVector, blend);
+        }
+#elif defined(__SSE2__)
+        for (; i < innerLast; ++i) {
+            shadePixelSSE2(pixels, src->pitch, u + du * i, v + dv * i, row + i, modVector, blend);
+        }
+#endif
+        for (; i < innerLast; ++i) {
+            shadePixel(sampleBilinear(pixels, src->pitch, srcrect, u + du * i, v + dv * i, false), row + i, mods, blend);
+        }
+
+        for (i = innerLast; i < outerLast; ++i) {
+            shadePixel(sampleBilinear(pixels, src->pitch, srcrect, u + du * i, v + dv * i, true), row + i, mods, blend);
+        }
+    }
+
+    return true;
+}
+
+void runRotateBenchmark()
+{
+    const int draws = 200;
+    const double angles[] = {5, 30, 45, 90, 135, 180, 270, 300};
+    const int angleCount = sizeof(angles) / sizeof(angles[0]);
+    const char* names[] = {"RenderCopyEx", "rotozoomBlit", "Cached"};
+
+    int x = (SCREEN_WIDTH - gArrowTexture.getWidth()) / 2;
+    int y = (SCREEN_HEIGHT - gArrowTexture.getHeight()) / 2;
+
+    SDL_Surface* softwareTarget = gSoftwareTarget;
+
+    for (int path = 0; path < 3; ++path) {
+        gSoftwareTarget = path == 1 ? softwareTarget : NULL;
+        gArrowTexture.enableRotationCache(path == 2 ? ROTATION_CACHE_STEPS : 0, ROTATION_CACHE_CAPACITY);
+
+        for (int a = 0; a < angleCount; ++a) {
+            // First draw fills the cache
+            gArrowTexture.render(x, y, NULL, angles[a], NULL, SDL_FLIP_NONE);
+            SDL_RenderFlush(gRenderer);
+
+            Uint64 start = SDL_GetPerformanceCounter();
+            for (int i = 0; i < draws; ++i) {
+                gArrowTexture.render(x, y, NULL, angles[a], NULL, SDL_FLIP_NONE);
+            }
+            SDL_RenderFlush(gRenderer);
+            double us = (SDL_GetPerformanceCounter() - start) * 1000000.0 / SDL_GetPerformanceFrequency() / draws;
+
+            printf("%-12s %6.1f degrees: %8.2f us per draw\n", names[path], angles[a], us);
+        }
+    }
+
+    gArrowTexture.printRotationCacheStats();
+    gArrowTexture.enableRotationCache(0, 0);
+    gSoftwareTarget = softwareTarget;
+}
+
+bool loadMedia()
+{
+    bool success = true;
+
+    if (!gArrowTexture.loadFromFile("arrow.png")) {
+        printf("Failed to arrow texture!\n");
+        success = false;
+    } else {
+        gAssetWatcher.watch(&gArrowTexture, "arrow.png");
+    }
+
+    return success;
+}
+
+void close()
+{
+    gInput.printStats();
+
+    gArrowTexture.printRotationCacheStats();
+
+    gAssetWatcher.stop();
+
+    gArrowTexture.free();
+
+    SDL_DestroyRenderer(gRenderer);
+    SDL_DestroyWindow(gWindow);
+    SDL_FreeSurface(gCaptureSurface);
+    gWindow = NULL;
+    gRenderer = NULL;
+    gCaptureSurface = NULL;
+    gSoftwareTarget = NULL;
+
+    IMG_Quit();
+    SDL_Quit();
+}
+
+void renderFrame(double degrees, SDL_RendererFlip flipType)
+{
+    SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+    SDL_RenderClear(gRenderer);
+
+    gArrowTexture.render((SCREEN_WIDTH - gArrowTexture.getWidth()) / 2, (SCREEN_HEIGHT - gArrowTexture.getHeight()) / 2, NULL, degrees, NULL, flipType);
+}
+
+int main (int argc, char *argv[])
+{
+    // --capture <png> [degrees [flip]] or --compare <png> [degrees [flip]]
+    // render one frame offscreen with rotated draws going through rotozoomBlit, so those
+    // goldens cover the blitter, --capture-sdl and --compare-sdl leave them to
+    // SDL_RenderCopyEx like the interactive lesson does, --bench-diff times the image differ,
+    // --bench-rotate times rotated draws on the software renderer,
+    // --record <log> saves the input of the session, --replay <log> plays it back
+    // under the dummy video driver and prints timing and a digest of angle and flip
+    std::string mode = argc > 1 ? argv[1] : "";
+    bool compare = mode == "--compare" || mode == "--compare-sdl";
+    bool sdlRotate = mode == "--capture-sdl" || mode == "--compare-sdl";
+    bool golden = compare || sdlRotate || mode == "--capture";
+    bool headless = golden || mode == "--bench-rotate";
+    bool passed = true;
+
+    if (mode == "--bench-diff") {
+        runDiffBenchmark();
+        return 0;
+    }
+
+    if (golden && argc < 3) {
+        printf("Usage: %s %s <png> [degrees [flip]]\n", argv[0], mode.c_str());
+        return 1;
+    }
+
+    if ((mode == "--record" || mode == "--replay") && argc < 3) {
+        printf("Usage: %s %s <log>\n", argv[0], mode.c_str());
+        return 1;
+    }
+
+    // Nothing but the log can feed input then
+    if (mode == "--replay") {
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    }
+
+    // The dummy driver has no accelerated renderer and no display to sync to
+    Uint32 rendererFlags = mode == "--replay" ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC;
+
+    if (!(headless ? initHeadless() : init(rendererFlags))) {
+        printf("Failed to initialize!\n");
+        passed = false;
+    } else {
+        if (!loadMedia()) {
+            printf("Failed to load media!\n");
+            passed = false;
+        } else if (mode == "--bench-rotate") {
+            runRotateBenchmark();
+        } else if (headless) {
+            double degrees = argc > 3 ? atof(argv[3]) : 0;
+            SDL_RendererFlip flipType = argc > 4 ? (SDL_RendererFlip)atoi(argv[4]) : SDL_FLIP_NONE;
+
+            if (sdlRotate) {
+                gSoftwareTarget = NULL;
+            }
+
+            renderFrame(degrees, flipType);
+            passed = runGolden(argv[2], compare);
+        } else {
+            double degrees = 0;
+
+            SDL_RendererFlip flipType = SDL_FLIP_NONE;
+
+            // Holding a rotate key keeps turning on key repeat
+            gInput.bindAction(INPUT_ACTION_ROTATE_LEFT, SDLK_a, true);
+            gInput.bindAction(INPUT_ACTION_ROTATE_RIGHT, SDLK_d, true);
+            gInput.bindAction(INPUT_ACTION_FLIP_HORIZONTAL, SDLK_q);
+            gInput.bindAction(INPUT_ACTION_FLIP_NONE, SDLK_w);
+            gInput.bindAction(INPUT_ACTION_FLIP_VERTICAL, SDLK_e);
+            gInput.subscribe(SDL_KEYDOWN);
+            gInput.subscribe(SDL_KEYUP);
+            gInput.installFilter();
+
+            gAssetWatcher.start(".");
+
+            // Rotating on the CPU costs a rotozoom per draw, pre-render instead
+            SDL_RendererInfo info;
+            if (SDL_GetRendererInfo(gRenderer, &info) == 0 && (info.flags & SDL_RENDERER_SOFTWARE)) {
+                gArrowTexture.enableRotationCache(ROTATION_CACHE_STEPS, ROTATION_CACHE_CAPACITY);
+            }
+
+            bool ready = true;
+            if (mode == "--record") {
+                ready = gInput.startRecording(argv[2]);
+            } else if (mode == "--replay") {
+                ready = gInput.startReplay(argv[2]);
+            }
+
+            // FNV-1a over angle and flip of every frame, equal digests mean identical runs
+            Uint32 digest = 2166136261u;
+            int frames = 0;
+            Uint64 start = SDL_GetPerformanceCounter();
+
+            while (ready && !gInput.quitRequested()) {
+                gInput.update();
+
+                gAssetWatcher.applyReloads();
+
+                if (gInput.wasActionPressed(INPUT_ACTION_ROTATE_LEFT)) {
+                    degrees -= 60;
+                }
+                if (gInput.wasActionPressed(INPUT_ACTION_ROTATE_RIGHT)) {
+                    degrees += 60;
+                }
+                if (gInput.wasActionPressed(INPUT_ACTION_FLIP_HORIZONTAL)) {
+                    flipType = SDL_FLIP_HORIZONTAL;
+                }
+                if (gInput.wasActionPressed(INPUT_ACTION_FLIP_NONE)) {
+                    flipType = SDL_FLIP_NONE;
+                }
+                if (gInput.wasActionPressed(INPUT_ACTION_FLIP_VERTICAL)) {
+                    flipType = SDL_FLIP_VERTICAL;
+                }
+
+                renderFrame(degrees, flipType);
+
+                SDL_RenderPresent(gRenderer);
+
+                digest = (digest ^ (Uint32)(Sint32)degrees) * 16777619u;
+                digest = (digest ^ (Uint32)flipType) * 16777619u;
+                ++frames;
+            }
+
+            if (gInput.isReplaying() && frames > 0) {
+                double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+                printf("Replayed %d frames, %.3f ms/frame, rotation digest %08x\n", frames, ms / frames, digest);
+            }
+
+            gInput.stopRecording();
         }
     }
 
     close();
 
-    return 0;
+    return passed ? 0 : 1;
 }
 
@@ -0,0 +1,670 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_error.h>
+#include <SDL2/SDL_events.h>
+#include <SDL2/SDL_pixels.h>
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_surface.h>
+#include <SDL2/SDL_timer.h>
+#include <SDL2/SDL_ttf.h>
+#include <SDL2/SDL_video.h>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int SCREEN_WIDTH = 640;
+const int SCREEN_HEIGHT = 480;
+
+// Point size glyphs are rasterized at before the distance transform
+const int SDF_BASE_SIZE = 64;
+
+// Distance in base pixels covered by the field on each side of an edge
+const int SDF_SPREAD = 8;
+
+// Width of the atlas, height grows to fit
+const int SDF_ATLAS_WIDTH = 1024;
+
+// Tallest atlas a cache file is trusted to describe
+const int SDF_MAX_ATLAS_HEIGHT = 8192;
+
+// Printable ASCII
+const Uint16 FIRST_GLYPH = 32;
+const Uint16 LAST_GLYPH = 126;
+
+// Atlas baked by --bake and picked up on later starts
+const char* SDF_CACHE_PATH = "lazy.sdf";
+
+// Sizes a multi-size TTF setup would open for comparison
+const int COMPARE_MIN_SIZE = 8;
+const int COMPARE_MAX_SIZE = 72;
+const int COMPARE_SIZE_STEP = 4;
+
+struct SDFGlyph
+{
+    // Padded glyph cell in the atlas
+    int x;
+    int y;
+    int w;
+    int h;
+
+    // Pen advance at base size
+    int advance;
+};
+
+class LSDFFont
+{
+    public:
+        // Initialize
+        LSDFFont();
+
+        // Rasterizes glyphs once at base size, distance fields are computed on worker threads
+        bool generate(std::string path);
+
+        // Atlas file written by saveToFile
+        bool loadFromFile(std::string path);
+        bool saveToFile(std::string path);
+
+        // Deallocate atlas
+        void free();
+
+        // Draws text with top left at x, y into an ARGB8888 surface
+        void drawText(SDL_Surface* target, int x, int y, std::string text, float scale, SDL_Color color);
+
+        // Width of text at scale
+        int measureText(std::string text, float scale);
+
+        // Line height at scale
+        int getLineHeight(float scale);
+
+        // Atlas memory in bytes
+        size_t getAtlasBytes();
+
+    private:
+        // Writes signed distance of coverage into field, 128 on the edge
+        static void computeField(const std::vector<Uint8>& coverage, int w, int h, Uint8* field, int fieldPitch);
+
+        // Glyphs from FIRST_GLYPH to LAST_GLYPH
+        std::vector<SDFGlyph> mGlyphs;
+
+        // Single channel distance field
+        std::vector<Uint8> mAtlas;
+        int mAtlasWidth;
+        int mAtlasHeight;
+
+        // Line height at base size
+        int mLineHeight;
+};
+
+bool init();
+
+bool loadMedia();
+
+void close();
+
+// Times and sizes a multi-size TTF glyph set against the SDF atlas
+void runComparison();
+
+SDL_Window* gWindow = NULL;
+
+SDL_Renderer* gRenderer = NULL;
+
+// CPU side frame the text is drawn into
+SDL_Surface* gFrameSurface = NULL;
+
+// Streaming texture the frame is uploaded to
+SDL_Texture* gFrameTexture = NULL;
+
+LSDFFont gSDFFont;
+
+LSDFFont::LSDFFont()
+{
+    mAtlasWidth = 0;
+    mAtlasHeight = 0;
+    mLineHeight = 0;
+}
+
+void LSDFFont::free()
+{
+    mGlyphs.clear();
+    mAtlas.clear();
+    mAtlasWidth = 0;
+    mAtlasHeight = 0;
+    mLineHeight = 0;
+}
+
+void LSDFFont::computeField(const std::vector<Uint8>& coverage, int w, int h, Uint8* field, int fieldPitch)
+{
+    // 8SSEDT: every cell tracks the offset to its nearest seed,
+    // once seeded with inside pixels and once with outside pixels
+    const int FAR = 1 << 12;
+    std::vector<int> offsets[2];
+
+    for (int pass = 0; pass < 2; ++pass) {
+        std::vector<int>& grid = offsets[pass];
+        grid.assign(w * h * 2, FAR);
+
+        for (int i = 0; i < w * h; ++i) {
+            bool inside = coverage[i] >= 128;
+            if (inside == (pass == 0)) {
+                grid[i * 2] = 0;
+                grid[i * 2 + 1] = 0;
+            }
+        }
+
+        // Pulls the neighbour's offset in if it leads somewhere closer
+        auto compare = [&](int x, int y, int ox, int oy) {
+            int nx = x + ox;
+            int ny = y + oy;
+            if (nx < 0 || ny < 0 || nx >= w || ny >= h) {
+                return;
+            }
+
+            int* cell = &grid[(y * w + x) * 2];
+            const int* other = &grid[(ny * w + nx) * 2];
+            int dx = other[0] + ox;
+            int dy = other[1] + oy;
+            if (dx * dx + dy * dy < cell[0] * cell[0] + cell[1] * cell[1]) {
+                cell[0] = dx;
+                cell[1] = dy;
+            }
+        };
+
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                compare(x, y, -1, 0);
+                compare(x, y, 0, -1);
+                compare(x, y, -1, -1);
+                compare(x, y, 1, -1);
+            }
+            for (int x = w - 1; x >= 0; --x) {
+                compare(x, y, 1, 0);
+            }
+        }
+
+        for (int y = h - 1; y >= 0; --y) {
+            for (int x = w - 1; x >= 0; --x) {
+                compare(x, y, 1, 0);
+                compare(x, y, 0, 1);
+                compare(x, y, -1, 1);
+                compare(x, y, 1, 1);
+            }
+            for (int x = 0; x < w; ++x) {
+                compare(x, y, -1, 0);
+            }
+        }
+    }
+
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            const int* toInside = &offsets[0][(y * w + x) * 2];
+            const int* toOutside = &offsets[1][(y * w + x) * 2];
+            float distance = sqrtf((float)(toInside[0] * toInside[0] + toInside[1] * toInside[1]))
+                - sqrtf((float)(toOutside[0] * toOutside[0] + toOutside[1] * toOutside[1]));
+
+            // Inside is above 128, outside below, SDF_SPREAD pixels reach the ends
+            float value = 128.0f - distance * 127.0f / SDF_SPREAD;
+            field[y * fieldPitch + x] = (Uint8)SDL_max(0.0f, SDL_min(255.0f, value));
+        }
+    }
+}
+
+bool LSDFFont::generate(std::string path)
+{
+    free();
+
+    TTF_Font* font = TTF_OpenFont(path.c_str(), SDF_BASE_SIZE);
+    if (font == NULL) {
+        printf("Failed to load %s! SDL_ttf Error: %s\n", path.c_str(), TTF_GetError());
+        return false;
+    }
+
+    mLineHeight = TTF_FontLineSkip(font);
+
+    // Rasterize each glyph once, SDL_ttf is not shared across threads
+    int glyphCount = LAST_GLYPH - FIRST_GLYPH + 1;
+    std::vector<std::vector<Uint8> > coverage(glyphCount);
+    mGlyphs.resize(glyphCount);
+
+    SDL_Color white = {0xFF, 0xFF, 0xFF, 0xFF};
+    for (int i = 0; i < glyphCount; ++i) {
+        Uint16 codepoint = FIRST_GLYPH + i;
+        SDFGlyph& glyph = mGlyphs[i];
+
+        int minx, maxx, miny, maxy;
+        if (TTF_GlyphMetrics(font, codepoint, &minx, &maxx, &miny, &maxy, &glyph.advance) < 0) {
+            glyph.advance = 0;
+        }
+
+        SDL_Surface* glyphSurface = TTF_RenderGlyph_Blended(font, codepoint, white);
+        if (glyphSurface == NULL) {
+            glyph.w = 0;
+            glyph.h = 0;
+            continue;
+        }
+
+        // Pad so the field has room to fall off around the glyph
+        glyph.w = glyphSurface->w + SDF_SPREAD * 2;
+        glyph.h = glyphSurface->h + SDF_SPREAD * 2;
+        coverage[i].assign(glyph.w * glyph.h, 0);
+
+        SDL_LockSurface(glyphSurface);
+        for (int y = 0; y < glyphSurface->h; ++y) {
+            const Uint32* row = (const Uint32*)((const Uint8*)glyphSurface->pixels + y * glyphSurface->pitch);
+            for (int x = 0; x < glyphSurface->w; ++x) {
+                coverage[i][(y + SDF_SPREAD) * glyph.w + x + SDF_SPREAD] = row[x] >> 24;
+            }
+        }
+        SDL_UnlockSurface(glyphSurface);
+
+        SDL_FreeSurface(glyphSurface);
+    }
+
+    TTF_CloseFont(font);
+
+    // Shelf pack the padded cells
+    int penX = 0;
+    int penY = 0;
+    int shelfHeight = 0;
+    for (int i = 0; i < glyphCount; ++i) {
+        SDFGlyph& glyph = mGlyphs[i];
+        if (penX + glyph.w > SDF_ATLAS_WIDTH) {
+            penX = 0;
+            penY += shelfHeight;
+            shelfHeight = 0;
+        }
+
+        glyph.x = penX;
+        glyph.y = penY;
+        penX += glyph.w;
+        shelfHeight = SDL_max(shelfHeight, glyph.h);
+    }
+
+    mAtlasWidth = SDF_ATLAS_WIDTH;
+    mAtlasHeight = penY + shelfHeight;
+    mAtlas.assign(mAtlasWidth * mAtlasHeight, 0);
+
+    // Cells are disjoint, so workers write the atlas without locking
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (int i = next++; i < glyphCount; i = next++) {
+            SDFGlyph& glyph = mGlyphs[i];
+            if (glyph.w > 0) {
+                computeField(coverage[i], glyph.w, glyph.h, &mAtlas[glyph.y * mAtlasWidth + glyph.x], mAtlasWidth);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < SDL_GetCPUCount(); ++i) {
+        workers.push_back(std::thread(worker));
+    }
+    worker();
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+
+    return true;
+}
+
+bool LSDFFont::saveToFile(std::string path)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == NULL) {
+        printf("Unable to write %s!\n", path.c_str());
+        return false;
+    }
+
+    int header[5] = {SDF_SPREAD, (int)mGlyphs.size(), mAtlasWidth, mAtlasHeight, mLineHeight};
+    bool success = fwrite("SDF1", 4, 1, file) == 1
+        && fwrite(header, sizeof(header), 1, file) == 1
+        && fwrite(&mGlyphs[0], sizeof(SDFGlyph), mGlyphs.size(), file) == mGlyphs.size()
+        && fwrite(&mAtlas[0], 1, mAtlas.size(), file) == mAtlas.size();
+
+    if (!success) {
+        printf("Unable to write %s!\n", path.c_str());
+    }
+
+    fclose(file);
+    return success;
+}
+
+bool LSDFFont::loadFromFile(std::string path)
+{
+    free();
+
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char magic[4];
+    int header[5];
+    bool success = fread(magic, 4, 1, file) == 1 && memcmp(magic, "SDF1", 4) == 0
+        && fread(header, sizeof(header), 1, file) == 1
+        && header[0] == SDF_SPREAD && header[1] == LAST_GLYPH - FIRST_GLYPH + 1
+        && header[2] == SDF_ATLAS_WIDTH && header[3] > 0 && header[3] <= SDF_MAX_ATLAS_HEIGHT && header[4] > 0;
+
+    // Nothing is allocated until the header accounts for every byte of the file
+    if (success) {
+        long expected = 4 + (long)sizeof(header) + header[1] * (long)sizeof(SDFGlyph) + (long)header[2] * header[3];
+        success = fileSize == expected;
+    }
+
+    if (success) {
+        mGlyphs.resize(header[1]);
+        mAtlasWidth = header[2];
+        mAtlasHeight = header[3];
+        mLineHeight = header[4];
+        mAtlas.resize(mAtlasWidth * mAtlasHeight);
+
+        success = fread(&mGlyphs[0], sizeof(SDFGlyph), mGlyphs.size(), file) == mGlyphs.size()
+            && fread(&mAtlas[0], 1, mAtlas.size(), file) == mAtlas.size();
+    }
+
+    // drawText samples a 2x2 neighbourhood, so drawn cells need at least that and must lie in the atlas
+    for (size_t i = 0; success && i < mGlyphs.size(); ++i) {
+        const SDFGlyph& glyph = mGlyphs[i];
+        bool empty = glyph.w == 0 && glyph.h == 0;
+        bool inside = glyph.w >= 2 && glyph.h >= 2 && glyph.x >= 0 && glyph.y >= 0
+            && glyph.x <= mAtlasWidth - glyph.w && glyph.y <= mAtlasHeight - glyph.h;
+        success = empty || inside;
+    }
+
+    fclose(file);
+
+    if (!success) {
+        printf("Ignoring stale or damaged %s\n", path.c_str());
+        free();
+    }
+
+    return success;
+}
+
+void LSDFFont::drawText(SDL_Surface* target, int x, int y, std::string text, float scale, SDL_Color color)
+{
+    // Edge softness of one destination pixel in field units
+    float smoothing = 0.5f * 127.0f / (SDF_SPREAD * scale) / 255.0f;
+    Uint32 rgb = (color.r << 16) | (color.g << 8) | color.b;
+
+    float penX = (float)x;
+    for (size_t c = 0; c < text.size(); ++c) {
+        Uint8 codepoint = (Uint8)text[c];
+        if (codepoint < FIRST_GLYPH || codepoint > LAST_GLYPH) {
+            continue;
+        }
+
+        const SDFGlyph& glyph = mGlyphs[codepoint - FIRST_GLYPH];
+
+        // Destination cell, the padding hangs off the pen position
+        int left = (int)floorf(penX - SDF_SPREAD * scale);
+        int top = (int)floorf(y - SDF_SPREAD * scale);
+        int width = (int)ceilf(glyph.w * scale);
+        int height = (int)ceilf(glyph.h * scale);
+
+        int x0 = SDL_max(0, left);
+        int y0 = SDL_max(0, top);
+        int x1 = SDL_min(target->w, left + width);
+        int y1 = SDL_min(target->h, top + height);
+
+        for (int dy = y0; dy < y1; ++dy) {
+            Uint32* row = (Uint32*)((Uint8*)target->pixels + dy * target->pitch);
+
+            // Bilinear sample position in the glyph cell
+            float sy = SDL_max(0.0f, SDL_min(glyph.h - 1.001f, (dy - top + 0.5f) / scale - 0.5f));
+            int iy = (int)sy;
+            float fy = sy - iy;
+            const Uint8* src0 = &mAtlas[(glyph.y + iy) * mAtlasWidth + glyph.x];
+            const Uint8* src1 = src0 + mAtlasWidth;
+
+            for (int dx = x0; dx < x1; ++dx) {
+                float sx = SDL_max(0.0f, SDL_min(glyph.w - 1.001f, (dx - left + 0.5f) / scale - 0.5f));
+                int ix = (int)sx;
+                float fx = sx - ix;
+
+                float top0 = src0[ix] + (src0[ix + 1] - src0[ix]) * fx;
+                float bottom0 = src1[ix] + (src1[ix + 1] - src1[ix]) * fx;
+                float distance = (top0 + (bottom0 - top0) * fy) / 255.0f;
+
+                // Smoothstep across the 0.5 iso line
+                float t = (distance - (0.5f - smoothing)) / (2.0f * smoothing);
+                if (t <= 0.0f) {
+                    continue;
+                }
+                t = SDL_min(1.0f, t);
+                float coverage = t * t * (3.0f - 2.0f * t);
+
+                Uint32 dst = row[dx];
+                Uint32 blended = 0xFF000000;
+                for (int shift = 0; shift < 24; shift += 8) {
+                    float d = (float)((dst >> shift) & 0xFF);
+                    float s = (float)((rgb >> shift) & 0xFF);
+                    blended |= (Uint32)(d + (s - d) * coverage) << shift;
+                }
+                row[dx] = blended;
+            }
+        }
+
+        penX += glyph.advance * scale;
+    }
+}
+
+int LSDFFont::measureText(std::string text, float scale)
+{
+    int advance = 0;
+    for (size_t c = 0; c < text.size(); ++c) {
+        Uint8 codepoint = (Uint8)text[c];
+        if (codepoint >= FIRST_GLYPH && codepoint <= LAST_GLYPH) {
+            advance += mGlyphs[codepoint - FIRST_GLYPH].advance;
+        }
+    }
+
+    return (int)(advance * scale);
+}
+
+int LSDFFont::getLineHeight(float scale)
+{
+    return (int)(mLineHeight * scale);
+}
+
+size_t LSDFFont::getAtlasBytes()
+{
+    return mAtlas.size() + mGlyphs.size() * sizeof(SDFGlyph);
+}
+
+void runComparison()
+{
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    SDL_Color white = {0xFF, 0xFF, 0xFF, 0xFF};
+
+    // One TTF_Font and a rasterized glyph set per size
+    Uint64 start = SDL_GetPerformanceCounter();
+    size_t ttfBytes = 0;
+    int sizes = 0;
+    for (int size = COMPARE_MIN_SIZE; size <= COMPARE_MAX_SIZE; size += COMPARE_SIZE_STEP) {
+        TTF_Font* font = TTF_OpenFont("lazy.ttf", size);
+        if (font == NULL) {
+            printf("Failed to load lazy font! SDL_ttf Error: %s\n", TTF_GetError());
+            return;
+        }
+
+        for (Uint16 codepoint = FIRST_GLYPH; codepoint <= LAST_GLYPH; ++codepoint) {
+            SDL_Surface* glyphSurface = TTF_RenderGlyph_Blended(font, codepoint, white);
+            if (glyphSurface != NULL) {
+                ttfBytes += glyphSurface->pitch * glyphSurface->h;
+                SDL_FreeSurface(glyphSurface);
+            }
+        }
+
+        TTF_CloseFont(font);
+        ++sizes;
+    }
+    double ttfMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+
+    LSDFFont font;
+    start = SDL_GetPerformanceCounter();
+    font.generate("lazy.ttf");
+    double generateMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+
+    font.saveToFile(SDF_CACHE_PATH);
+    start = SDL_GetPerformanceCounter();
+    font.loadFromFile(SDF_CACHE_PATH);
+    double loadMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+
+    printf("TTF, %d sizes:        %8.2f ms, %8zu bytes of glyph surfaces\n", sizes, ttfMs, ttfBytes);
+    printf("SDF, generated:      %8.2f ms, %8zu bytes of atlas\n", generateMs, font.getAtlasBytes());
+    printf("SDF, loaded baked:   %8.2f ms\n", loadMs);
+}
+
+bool init()
+{
+    bool success = true;
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        printf("SDL failed to initialize!\n");
+        success = false;
+    } else {
+        gWindow = SDL_CreateWindow("SDL Tutorial", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
+        if (gWindow == NULL) {
+            printf("Failed to create window! SDL Error: %s\n", SDL_GetError());
+            success = false;
+        } else {
+            gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+            if (gRenderer == NULL) {
+                printf("Failed to create renderer! SDL Error: %s\n", SDL_GetError());
+                success = false;
+            } else {
+                SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+
+                if (TTF_Init() == -1) {
+                    printf("SDL_ttf failed to initialize! SDL_ttf Error: %s\n", TTF_GetError());
+                    success = false;
+                }
+            }
+        }
+    }
+
+    return success;
+}
+
+bool loadMedia()
+{
+    bool success = true;
+
+    // Prefer the baked atlas, fall back to generating at load
+    if (!gSDFFont.loadFromFile(SDF_CACHE_PATH) && !gSDFFont.generate("lazy.ttf")) {
+        printf("Failed to build distance field font!\n");
+        success = false;
+    }
+
+    gFrameSurface = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (gFrameSurface == NULL) {
+        printf("Failed to create frame surface! SDL Error: %s\n", SDL_GetError());
+        success = false;
+    }
+
+    gFrameTexture = SDL_CreateTexture(gRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (gFrameTexture == NULL) {
+        printf("Failed to create frame texture! SDL Error: %s\n", SDL_GetError());
+        success = false;
+    }
+
+    return success;
+}
+
+void close()
+{
+    gSDFFont.free();
+
+    SDL_DestroyTexture(gFrameTexture);
+    gFrameTexture = NULL;
+    SDL_FreeSurface(gFrameSurface);
+    gFrameSurface = NULL;
+
+    SDL_DestroyRenderer(gRenderer);
+    SDL_DestroyWindow(gWindow);
+    gWindow = NULL;
+    gRenderer = NULL;
+
+    TTF_Quit();
+    SDL_Quit();
+}
+
+int main (int argc, char *argv[])
+{
+    // --bake writes the atlas for later starts, --compare measures it against multi-size TTF
+    std::string mode = argc > 1 ? argv[1] : "";
+
+    if (mode == "--bake" || mode == "--compare") {
+        if (TTF_Init() == -1) {
+            printf("SDL_ttf failed to initialize! SDL_ttf Error: %s\n", TTF_GetError());
+            return 1;
+        }
+
+        if (mode == "--bake") {
+            LSDFFont font;
+            if (!font.generate("lazy.ttf") || !font.saveToFile(SDF_CACHE_PATH)) {
+                TTF_Quit();
+                return 1;
+            }
+            printf("Baked %s, %zu bytes\n", SDF_CACHE_PATH, font.getAtlasBytes());
+        } else {
+            runComparison();
+        }
+
+        TTF_Quit();
+        return 0;
+    }
+
+    if (!init()) {
+        printf("Failed to initialize!\n");
+    } else {
+        if (!loadMedia()) {
+            printf("Failed to load media!\n");
+        } else {
+            bool quit = false;
+
+            SDL_Event e;
+
+            SDL_Color textColor = {0, 0, 0, 0xFF};
+
+            std::string text = "The quick brown fox jumps over the lazy dog";
+
+            while (!quit) {
+                while (SDL_PollEvent(&e) != 0) {
+                    if (e.type == SDL_QUIT) {
+                        quit = true;
+                    }
+                }
+
+                // Same atlas at a fixed ladder of sizes plus one zooming line
+                SDL_FillRect(gFrameSurface, NULL, 0xFFFFFFFF);
+
+                int y = 10;
+                for (float scale = 0.25f; scale <= 0.75f; scale += 0.125f) {
+                    gSDFFont.drawText(gFrameSurface, 10, y, text, scale, textColor);
+                    y += gSDFFont.getLineHeight(scale);
+                }
+
+                float zoom = 0.5f + 1.5f * (0.5f + 0.5f * sinf(SDL_GetTicks() / 1000.0f));
+                gSDFFont.drawText(gFrameSurface, (SCREEN_WIDTH - gSDFFont.measureText("Zoom", zoom)) / 2, y + 20, "Zoom", zoom, textColor);
+
+                SDL_UpdateTexture(gFrameTexture, NULL, gFrameSurface->pixels, gFrameSurface->pitch);
+
+                SDL_RenderClear(gRenderer);
+                SDL_RenderCopy(gRenderer, gFrameTexture, NULL, NULL);
+                SDL_RenderPresent(gRenderer);
+            }
+        }
+    }
+
+    close();
+
+    return 0;
+}
@@ -0,0 +1,661 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_blendmode.h>
+#include <SDL2/SDL_error.h>
+#include <SDL2/SDL_events.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_pixels.h>
+#include <SDL2/SDL_rect.h>
+#include <SDL2/SDL_surface.h>
+#include <SDL2/SDL_video.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+const int SCREEN_WIDTH = 640;
+const int SCREEN_HEIGHT = 480;
+
+// Formats, blend modes and modulation switches blitters are instantiated for
+const int BLIT_FORMATS = 4;
+const Uint32 BLIT_FORMAT_LIST[BLIT_FORMATS] = {SDL_PIXELFORMAT_ARGB8888, SDL_PIXELFORMAT_ABGR8888, SDL_PIXELFORMAT_RGB888, SDL_PIXELFORMAT_RGB565};
+const int BLIT_BLEND_MODES = 4;
+const SDL_BlendMode BLIT_BLEND_LIST[BLIT_BLEND_MODES] = {SDL_BLENDMODE_NONE, SDL_BLENDMODE_BLEND, SDL_BLENDMODE_ADD, SDL_BLENDMODE_MOD};
+
+// Surface size and blits per combination in the benchmark
+const int BENCHMARK_SIZE = 256;
+const int BENCHMARK_RUNS = 20;
+
+// Rows of pixels and modulation for one blit, clipped already
+struct LBlitParams
+{
+    const Uint8* source;
+    int sourcePitch;
+    Uint8* target;
+    int targetPitch;
+    int width;
+    int height;
+
+    Uint32 modRed;
+    Uint32 modGreen;
+    Uint32 modBlue;
+    Uint32 modAlpha;
+};
+
+typedef void (*LBlitFunction)(const LBlitParams& params);
+
+// Pixel layouts, unpack to and pack from 8 bit channels
+struct LFormatARGB8888
+{
+    static const Uint32 FORMAT = SDL_PIXELFORMAT_ARGB8888;
+    static const int BYTES = 4;
+    static const bool HAS_ALPHA = true;
+
+    static inline void unpack(const Uint8* pixel, Uint32& r, Uint32& g, Uint32& b, Uint32& a)
+    {
+        Uint32 p = *(const Uint32*)pixel;
+        a = p >> 24;
+        r = (p >> 16) & 0xFF;
+        g = (p >> 8) & 0xFF;
+        b = p & 0xFF;
+    }
+
+    static inline void pack(Uint8* pixel, Uint32 r, Uint32 g, Uint32 b, Uint32 a)
+    {
+        *(Uint32*)pixel = a << 24 | r << 16 | g << 8 | b;
+    }
+};
+
+struct LFormatABGR8888
+{
+    static const Uint32 FORMAT = SDL_PIXELFORMAT_ABGR8888;
+    static const int BYTES = 4;
+    static const bool HAS_ALPHA = true;
+
+    static inline void unpack(const Uint8* pixel, Uint32& r, Uint32& g, Uint32& b, Uint32& a)
+    {
+        Uint32 p = *(const Uint32*)pixel;
+        a = p >> 24;
+        b = (p >> 16) & 0xFF;
+        g = (p >> 8) & 0xFF;
+        r = p & 0xFF;
+    }
+
+    static inline void pack(Uint8* pixel, Uint32 r, Uint32 g, Uint32 b, Uint32 a)
+    {
+        *(Uint32*)pixel = a << 24 | b << 16 | g << 8 | r;
+    }
+};
+
+struct LFormatRGB888
+{
+    static const Uint32 FORMAT = SDL_PIXELFORMAT_RGB888;
+    static const int BYTES = 4;
+    static const bool HAS_ALPHA = false;
+
+    static inline void unpack(const Uint8* pixel, Uint32& r, Uint32& g, Uint32& b, Uint32& a)
+    {
+        Uint32 p = *(const Uint32*)pixel;
+        a = 0xFF;
+        r = (p >> 16) & 0xFF;
+        g = (p >> 8) & 0xFF;
+        b = p & 0xFF;
+    }
+
+    static inline void pack(Uint8* pixel, Uint32 r, Uint32 g, Uint32 b, Uint32)
+    {
+        *(Uint32*)pixel = r << 16 | g << 8 | b;
+    }
+};
+
+struct LFormatRGB565
+{
+    static const Uint32 FORMAT = SDL_PIXELFORMAT_RGB565;
+    static const int BYTES = 2;
+    static const bool HAS_ALPHA = false;
+
+    // Widened by replicating the top bits, like SDL does
+    static inline void unpack(const Uint8* pixel, Uint32& r, Uint32& g, Uint32& b, Uint32& a)
+    {
+        Uint32 p = *(const Uint16*)pixel;
+        a = 0xFF;
+        r = (p >> 11) & 0x1F;
+        g = (p >> 5) & 0x3F;
+        b = p & 0x1F;
+        r = r << 3 | r >> 2;
+        g = g << 2 | g >> 4;
+        b = b << 3 | b >> 2;
+    }
+
+    static inline void pack(Uint8* pixel, Uint32 r, Uint32 g, Uint32 b, Uint32)
+    {
+        *(Uint16*)pixel = (Uint16)((r >> 3) << 11 | (g >> 2) << 5 | b >> 3);
+    }
+};
+
+bool init();
+
+bool loadMedia();
+
+void close();
+
+// Fills the dispatch table with every instantiation
+void registerBlitters();
+
+// Blitter for the combination, NULL when none was instantiated
+LBlitFunction findBlitter(Uint32 sourceFormat, Uint32 targetFormat, SDL_BlendMode blending, bool colorMod, bool alphaMod);
+
+// Drop-in for SDL_BlitSurface using the blend mode and modulation set on source,
+// falls back to SDL for color keys and formats without a specialization
+int specializedBlit(SDL_Surface* source, const SDL_Rect* sourceRect, SDL_Surface* target, SDL_Rect* targetRect);
+
+// Times SDL_BlitSurface against the specialized blitters for every combination
+void runBlitBenchmark();
+
+SDL_Window* gWindow = NULL;
+
+SDL_Surface* gScreenSurface = NULL;
+
+SDL_Surface* gImgSurface = NULL;
+
+// Indexed by source format, target format, blend mode, color mod, alpha mod
+LBlitFunction gBlitters[BLIT_FORMATS][BLIT_FORMATS][BLIT_BLEND_MODES][2][2];
+
+static inline Uint32 div255(Uint32 x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+// Every branch on blend mode and modulation is resolved at compile time,
+// so the inner loop is only the arithmetic this combination needs
+template <typename Source, typename Target, SDL_BlendMode Blend, bool ColorMod, bool AlphaMod>
+static void blitSpecialized(const LBlitParams& params)
+{
+    const Uint8* sourceRow = params.source;
+    Uint8* targetRow = params.target;
+
+    for (int y = 0; y < params.height; ++y) {
+        // Same layout and nothing to blend or modulate is a row copy
+        if constexpr (std::is_same<Source, Target>::value && Blend == SDL_BLENDMODE_NONE && !ColorMod && !AlphaMod) {
+            memcpy(targetRow, sourceRow, params.width * Source::BYTES);
+        } else {
+            const Uint8* source = sourceRow;
+            Uint8* target = targetRow;
+
+            for (int x = 0; x < params.width; ++x) {
+                Uint32 sr, sg, sb, sa;
+                Source::unpack(source, sr, sg, sb, sa);
+
+                if constexpr (ColorMod) {
+                    sr = div255(sr * params.modRed);
+                    sg = div255(sg * params.modGreen);
+                    sb = div255(sb * params.modBlue);
+                }
+                if constexpr (AlphaMod) {
+                    sa = div255(sa * params.modAlpha);
+                }
+
+                if constexpr (Blend == SDL_BLENDMODE_NONE) {
+                    Target::pack(target, sr, sg, sb, sa);
+                } else {
+                    Uint32 dr, dg, db, da;
+                    Target::unpack(target, dr, dg, db, da);
+
+                    if constexpr (Blend == SDL_BLENDMODE_BLEND) {
+                        // Opaque sources skip the blend unless alpha can vary
+                        if constexpr (!Source::HAS_ALPHA && !AlphaMod) {
+                            dr = sr;
+                            dg = sg;
+                            db = sb;
+                            da = 0xFF;
+                        } else {
+                            Uint32 inverse = 255 - sa;
+                            dr = div255(sr * sa + dr * inverse);
+                            dg = div255(sg * sa + dg * inverse);
+                            db = div255(sb * sa + db * inverse);
+                            da = sa + div255(da * inverse);
+                        }
+                    } else if constexpr (Blend == SDL_BLENDMODE_ADD) {
+                        dr = SDL_min(255u, div255(sr * sa) + dr);
+                        dg = SDL_min(255u, div255(sg * sa) + dg);
+                        db = SDL_min(255u, div255(sb * sa) + db);
+                    } else if constexpr (Blend == SDL_BLENDMODE_MOD) {
+                        dr = div255(sr * dr);
+                        dg = div255(sg * dg);
+                        db = div255(sb * db);
+                    }
+
+                    Target::pack(target, dr, dg, db, da);
+                }
+
+                source += Source::BYTES;
+                target += Target::BYTES;
+            }
+        }
+
+        sourceRow += params.sourcePitch;
+        targetRow += params.targetPitch;
+    }
+}
+
+template <typename Source, typename Target, int SourceIndex, int TargetIndex, int BlendIndex, SDL_BlendMode Blend>
+static void registerModulations()
+{
+    gBlitters[SourceIndex][TargetIndex][BlendIndex][0][0] = blitSpecialized<Source, Target, Blend, false, false>;
+    gBlitters[SourceIndex][TargetIndex][BlendIndex][0][1] = blitSpecialized<Source, Target, Blend, false, true>;
+    gBlitters[SourceIndex][TargetIndex][BlendIndex][1][0] = blitSpecialized<Source, Target, Blend, true, false>;
+    gBlitters[SourceIndex][TargetIndex][BlendIndex][1][1] = blitSpecialized<Source, Target, Blend, true, true>;
+}
+
+template <typename Source, typename Target, int SourceIndex, int TargetIndex>
+static void registerBlendModes()
+{
+    // Order matches BLIT_BLEND_LIST
+    registerModulations<Source, Target, SourceIndex, TargetIndex, 0, SDL_BLENDMODE_NONE>();
+    registerModulations<Source, Target, SourceIndex, TargetIndex, 1, SDL_BLENDMODE_BLEND>();
+    registerModulations<Source, Target, SourceIndex, TargetIndex, 2, SDL_BLENDMODE_ADD>();
+    registerModulations<Source, Target, SourceIndex, TargetIndex, 3, SDL_BLENDMODE_MOD>();
+}
+
+template <typename Source, int SourceIndex>
+static void registerTargets()
+{
+    registerBlendModes<Source, LFormatARGB8888, SourceIndex, 0>();
+    registerBlendModes<Source, LFormatABGR8888, SourceIndex, 1>();
+    registerBlendModes<Source, LFormatRGB888, SourceIndex, 2>();
+    registerBlendModes<Source, LFormatRGB565, SourceIndex, 3>();
+}
+
+void registerBlitters()
+{
+    // Order matches BLIT_FORMAT_LIST
+    registerTargets<LFormatARGB8888, 0>();
+    registerTargets<LFormatABGR8888, 1>();
+    registerTargets<LFormatRGB888, 2>();
+    registerTargets<LFormatRGB565, 3>();
+}
+
+static int formatIndex(Uint32 format)
+{
+    for (int i = 0; i < BLIT_FORMATS; ++i) {
+        if (BLIT_FORMAT_LIST[i] == format) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static int blendIndex(SDL_BlendMode blending)
+{
+    for (int i = 0; i < BLIT_BLEND_MODES; ++i) {
+        if (BLIT_BLEND_LIST[i] == blending) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+LBlitFunction findBlitter(Uint32 sourceFormat, Uint32 targetFormat, SDL_BlendMode blending, bool colorMod, bool alphaMod)
+{
+    int source = formatIndex(sourceFormat);
+    int target = formatIndex(targetFormat);
+    int blend = blendIndex(blending);
+    if (source < 0 || target < 0 || blend < 0) {
+        return NULL;
+    }
+
+    return gBlitters[source][target][blend][colorMod][alphaMod];
+}
+
+int specializedBlit(SDL_Surface* source, const SDL_Rect* sourceRect, SDL_Surface* target, SDL_Rect* targetRect)
+{
+    SDL_BlendMode blending;
+    Uint8 r, g, b, a;
+    SDL_GetSurfaceBlendMode(source, &blending);
+    SDL_GetSurfaceColorMod(source, &r, &g, &b);
+    SDL_GetSurfaceAlphaMod(source, &a);
+
+    bool colorMod = r != 0xFF || g != 0xFF || b != 0xFF;
+    bool alphaMod = a != 0xFF;
+
+    LBlitFunction blit = findBlitter(source->format->format, target->format->format, blending, colorMod, alphaMod);
+    if (blit == NULL || SDL_HasColorKey(source)) {
+        return SDL_BlitSurface(source, sourceRect, target, targetRect);
+    }
+
+    // Clip to the source, then to the target's clip rectangle, the way SDL_BlitSurface does
+    int sx = 0;
+    int sy = 0;
+    int w = source->w;
+    int h = source->h;
+    int dx = targetRect != NULL ? targetRect->x : 0;
+    int dy = targetRect != NULL ? targetRect->y : 0;
+
+    if (sourceRect != NULL) {
+        sx = sourceRect->x;
+        sy = sourceRect->y;
+        w = sourceRect->w;
+        h = sourceRect->h;
+
+        if (sx < 0) {
+            w += sx;
+            dx -= sx;
+            sx = 0;
+        }
+        if (sy < 0) {
+            h += sy;
+            dy -= sy;
+            sy = 0;
+        }
+        w = SDL_min(w, source->w - sx);
+        h = SDL_min(h, source->h - sy);
+    }
+
+    const SDL_Rect& clip = target->clip_rect;
+    if (dx < clip.x) {
+        w -= clip.x - dx;
+        sx += clip.x - dx;
+        dx = clip.x;
+    }
+    if (dy < clip.y) {
+        h -= clip.y - dy;
+        sy += clip.y - dy;
+        dy = clip.y;
+    }
+    w = SDL_min(w, clip.x + clip.w - dx);
+    h = SDL_min(h, clip.y + clip.h - dy);
+
+    if (targetRect != NULL) {
+        targetRect->x = dx;
+        targetRect->y = dy;
+        targetRect->w = SDL_max(w, 0);
+        targetRect->h = SDL_max(h, 0);
+    }
+
+    if (w <= 0 || h <= 0) {
+        return 0;
+    }
+
+    if (SDL_MUSTLOCK(source) && SDL_LockSurface(source) < 0) {
+        return -1;
+    }
+    if (SDL_MUSTLOCK(target) && SDL_LockSurface(target) < 0) {
+        if (SDL_MUSTLOCK(source)) {
+            SDL_UnlockSurface(source);
+        }
+        return -1;
+    }
+
+    LBlitParams params;
+    params.source = (const Uint8*)source->pixels + sy * source->pitch + sx * source->format->BytesPerPixel;
+    params.sourcePitch = source->pitch;
+    params.target = (Uint8*)target->pixels + dy * target->pitch + dx * target->format->BytesPerPixel;
+    params.targetPitch = target->pitch;
+    params.width = w;
+    params.height = h;
+    params.modRed = r;
+    params.modGreen = g;
+    params.modBlue = b;
+    params.modAlpha = a;
+    blit(params);
+
+    if (SDL_MUSTLOCK(target)) {
+        SDL_UnlockSurface(target);
+    }
+    if (SDL_MUSTLOCK(source)) {
+        SDL_UnlockSurface(source);
+    }
+
+    return 0;
+}
+
+// Fills surface with random pixels
+static void fillNoise(SDL_Surface* surface)
+{
+    for (int y = 0; y < surface->h; ++y) {
+        Uint8* row = (Uint8*)surface->pixels + y * surface->pitch;
+        for (int x = 0; x < surface->w * surface->format->BytesPerPixel; ++x) {
+            row[x] = (Uint8)rand();
+        }
+    }
+}
+
+// Largest difference of any channel between two surfaces of the same format
+static int maxDifference(SDL_Surface* a, SDL_Surface* b)
+{
+    int difference = 0;
+
+    for (int y = 0; y < a->h; ++y) {
+        for (int x = 0; x < a->w; ++x) {
+            Uint32 pa = 0;
+            Uint32 pb = 0;
+            memcpy(&pa, (Uint8*)a->pixels + y * a->pitch + x * a->format->BytesPerPixel, a->format->BytesPerPixel);
+            memcpy(&pb, (Uint8*)b->pixels + y * b->pitch + x * b->format->BytesPerPixel, b->format->BytesPerPixel);
+
+            Uint8 ar, ag, ab, aa, br, bg, bb, ba;
+            SDL_GetRGBA(pa, a->format, &ar, &ag, &ab, &aa);
+            SDL_GetRGBA(pb, b->format, &br, &bg, &bb, &ba);
+            difference = SDL_max(difference, abs(ar - br));
+            difference = SDL_max(difference, abs(ag - bg));
+            difference = SDL_max(difference, abs(ab - bb));
+            difference = SDL_max(difference, abs(aa - ba));
+        }
+    }
+
+    return difference;
+}
+
+void runBlitBenchmark()
+{
+    const char* blendNames[BLIT_BLEND_MODES] = {"none", "blend", "add", "mod"};
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    double megapixels = (double)BENCHMARK_SIZE * BENCHMARK_SIZE * BENCHMARK_RUNS / 1000000.0;
+    double sdlTotal = 0;
+    double specializedTotal = 0;
+
+    registerBlitters();
+
+    printf("%-9s %-9s %-5s cm am %12s %12s %8s %5s\n", "source", "target", "blend", "SDL Mpix/s", "ours Mpix/s", "speedup", "diff");
+
+    for (int s = 0; s < BLIT_FORMATS; ++s) {
+        for (int t = 0; t < BLIT_FORMATS; ++t) {
+            SDL_Surface* source = SDL_CreateRGBSurfaceWithFormat(0, BENCHMARK_SIZE, BENCHMARK_SIZE, 32, BLIT_FORMAT_LIST[s]);
+            SDL_Surface* background = SDL_CreateRGBSurfaceWithFormat(0, BENCHMARK_SIZE, BENCHMARK_SIZE, 32, BLIT_FORMAT_LIST[t]);
+            SDL_Surface* sdlTarget = SDL_CreateRGBSurfaceWithFormat(0, BENCHMARK_SIZE, BENCHMARK_SIZE, 32, BLIT_FORMAT_LIST[t]);
+            SDL_Surface* ourTarget = SDL_CreateRGBSurfaceWithFormat(0, BENCHMARK_SIZE, BENCHMARK_SIZE, 32, BLIT_FORMAT_LIST[t]);
+            if (source == NULL || background == NULL || sdlTarget == NULL || ourTarget == NULL) {
+                printf("Failed to create benchmark surfaces! SDL Error: %s\n", SDL_GetError());
+            } else {
+                fillNoise(source);
+                fillNoise(background);
+
+                for (int blend = 0; blend < BLIT_BLEND_MODES; ++blend) {
+                    for (int mods = 0; mods < 4; ++mods) {
+                        bool colorMod = (mods & 2) != 0;
+                        bool alphaMod = (mods & 1) != 0;
+
+                        SDL_SetSurfaceBlendMode(source, BLIT_BLEND_LIST[blend]);
+                        SDL_SetSurfaceColorMod(source, colorMod ? 0xC0 : 0xFF, colorMod ? 0x80 : 0xFF, colorMod ? 0x40 : 0xFF);
+                        SDL_SetSurfaceAlphaMod(source, alphaMod ? 0x80 : 0xFF);
+
+                        // Every run blits onto the same background so both see the same input
+                        SDL_BlitSurface(background, NULL, sdlTarget, NULL);
+                        Uint64 start = SDL_GetPerformanceCounter();
+                        for (int i = 0; i < BENCHMARK_RUNS; ++i) {
+                            SDL_BlitSurface(source, NULL, sdlTarget, NULL);
+                        }
+                        double sdlSeconds = (SDL_GetPerformanceCounter() - start) / frequency;
+
+                        SDL_BlitSurface(background, NULL, ourTarget, NULL);
+                        start = SDL_GetPerformanceCounter();
+                        for (int i = 0; i < BENCHMARK_RUNS; ++i) {
+                            specializedBlit(source, NULL, ourTarget, NULL);
+                        }
+                        double specializedSeconds = (SDL_GetPerformanceCounter() - start) / frequency;
+
+                        // One blit each on a fresh background to compare results
+                        SDL_BlitSurface(background, NULL, sdlTarget, NULL);
+                        SDL_BlitSurface(background, NULL, ourTarget, NULL);
+                        SDL_BlitSurface(source, NULL, sdlTarget, NULL);
+                        specializedBlit(source, NULL, ourTarget, NULL);
+
+                        printf("%-9s %-9s %-5s %2s %2s %12.1f %12.1f %7.2fx %5d\n",
+                            SDL_GetPixelFormatName(BLIT_FORMAT_LIST[s]) + 16, SDL_GetPixelFormatName(BLIT_FORMAT_LIST[t]) + 16,
+                            blendNames[blend], colorMod ? "y" : "n", alphaMod ? "y" : "n",
+                            megapixels / sdlSeconds, megapixels / specializedSeconds, sdlSeconds / specializedSeconds,
+                            maxDifference(sdlTarget, ourTarget));
+
+                        sdlTotal += sdlSeconds;
+                        specializedTotal += specializedSeconds;
+                    }
+                }
+            }
+
+            SDL_FreeSurface(source);
+            SDL_FreeSurface(background);
+            SDL_FreeSurface(sdlTarget);
+            SDL_FreeSurface(ourTarget);
+        }
+    }
+
+    printf("All combinations: SDL %.1f ms, specialized %.1f ms (%.2fx)\n", sdlTotal * 1000.0, specializedTotal * 1000.0, sdlTotal / specializedTotal);
+}
+
+bool init()
+{
+    bool success = true;
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        printf("SDL failed to initialize! SDL Error: %s\n", SDL_GetError());
+        success = false;
+    } else {
+        gWindow = SDL_CreateWindow("SDL Tutorial", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
+        if (gWindow == NULL) {
+            printf("Failed to create window! SDL Error: %s\n", SDL_GetError());
+            success = false;
+        } else {
+            int imgFlag = IMG_INIT_PNG;
+            if (!(IMG_Init(imgFlag) & imgFlag)) {
+                printf("SDL_Image failed to initialize! SDL_Image Error: %s\n", IMG_GetError());
+                success = false;
+            } else {
+                gScreenSurface = SDL_GetWindowSurface(gWindow);
+                registerBlitters();
+            }
+        }
+    }
+
+    return success;
+}
+
+bool loadMedia()
+{
+    bool success = true;
+
+    // Kept with its alpha so every blend mode has something to work with
+    SDL_Surface* loadedSurface = IMG_Load("loaded.png");
+    if (loadedSurface == NULL) {
+        printf("Unable to load image %s! SDL_Image Error: %s\n", "loaded.png", IMG_GetError());
+        success = false;
+    } else {
+        gImgSurface = SDL_ConvertSurfaceFormat(loadedSurface, SDL_PIXELFORMAT_ARGB8888, 0);
+        if (gImgSurface == NULL) {
+            printf("Unable to convert image %s! SDL Error: %s\n", "loaded.png", SDL_GetError());
+            success = false;
+        }
+
+        SDL_FreeSurface(loadedSurface);
+    }
+
+    return success;
+}
+
+void close()
+{
+    SDL_FreeSurface(gImgSurface);
+    gImgSurface = NULL;
+
+    SDL_DestroyWindow(gWindow);
+    gWindow = NULL;
+
+    IMG_Quit();
+    SDL_Quit();
+}
+
+int main (int argc, char *argv[])
+{
+    // --bench compares against SDL_BlitSurface for every combination without a window
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        runBlitBenchmark();
+        return 0;
+    }
+
+    if (!init()) {
+        printf("Failed to initialize!\n");
+    } else {
+        if (!loadMedia()) {
+            printf("Failed to load media!\n");
+        } else {
+            bool quit = false;
+
+            SDL_Event e;
+
+            // 1 to 4 pick the blend mode, C toggles color mod, A toggles alpha mod
+            int blend = 1;
+            bool colorMod = false;
+            bool alphaMod = false;
+
+            while (!quit) {
+                while (SDL_PollEvent(&e) != 0) {
+                    if (e.type == SDL_QUIT) {
+                        quit = true;
+                    } else if (e.type == SDL_KEYDOWN) {
+                        switch (e.key.keysym.sym) {
+                            case SDLK_1:
+                            blend = 0;
+                            break;
+
+                            case SDLK_2:
+                            blend = 1;
+                            break;
+
+                            case SDLK_3:
+                            blend = 2;
+                            break;
+
+                            case SDLK_4:
+                            blend = 3;
+                            break;
+
+                            case SDLK_c:
+                            colorMod = !colorMod;
+                            break;
+
+                            case SDLK_a:
+                            alphaMod = !alphaMod;
+                            break;
+                        }
+                    }
+                }
+
+                SDL_SetSurfaceBlendMode(gImgSurface, BLIT_BLEND_LIST[blend]);
+                SDL_SetSurfaceColorMod(gImgSurface, 0xFF, colorMod ? 0x80 : 0xFF, colorMod ? 0x80 : 0xFF);
+                SDL_SetSurfaceAlphaMod(gImgSurface, alphaMod ? 0x80 : 0xFF);
+
+                SDL_FillRect(gScreenSurface, NULL, SDL_MapRGB(gScreenSurface->format, 0x40, 0x80, 0xC0));
+
+                SDL_Rect position = {(SCREEN_WIDTH - gImgSurface->w) / 2, (SCREEN_HEIGHT - gImgSurface->h) / 2, 0, 0};
+                specializedBlit(gImgSurface, NULL, gScreenSurface, &position);
+
+                SDL_UpdateWindowSurface(gWindow);
+            }
+        }
+    }
+
+    close();
+
+    return 0;
+}
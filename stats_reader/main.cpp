@@ -0,0 +1,166 @@
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Page the ttf lesson publishes to when run with --publish-stats, suffixed with its pid,
+// and the page's "LSTA" tag and layout version
+const char* STATS_PAGE_PREFIX = "/lesson_ttf_stats.";
+const uint32_t STATS_PAGE_MAGIC = 0x4154534C;
+const uint32_t STATS_PAGE_VERSION = 1;
+
+// Milliseconds between printed lines
+const int READ_INTERVAL = 500;
+
+// Attempts at a consistent copy before giving up on a line
+const int READ_RETRIES = 1000;
+
+// Lines without a new frame before the publisher is reported stalled
+const int STALL_LINES = 4;
+
+// Must match LFrameStats in ttf/main.cpp
+struct LFrameStats
+{
+    uint64_t frame;
+
+    // Last frame, moving average and worst frame of the last second
+    double frameMs;
+    double averageFrameMs;
+    double worstFrameMs;
+
+    uint32_t drawCalls;
+    uint32_t textureCount;
+    uint64_t textureBytes;
+    uint64_t texturePeakBytes;
+
+    uint64_t events;
+    double eventsPerSecond;
+};
+
+// Must match LStatsPage in ttf/main.cpp
+struct LStatsPage
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t pid;
+
+    // Odd while the publisher is writing stats
+    std::atomic<uint32_t> sequence;
+
+    LFrameStats stats;
+};
+
+// Copies stats out of the page, retrying while the publisher is mid write
+bool readStats(const LStatsPage* page, LFrameStats* stats);
+
+bool readStats(const LStatsPage* page, LFrameStats* stats)
+{
+    for (int i = 0; i < READ_RETRIES; ++i) {
+        uint32_t before = page->sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+
+        memcpy(stats, &page->stats, sizeof(LFrameStats));
+
+        // Copy must be finished before the sequence is checked again
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (page->sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int main (int argc, char *argv[])
+{
+    // Pid of the publisher or a full page name, --once prints a single line
+    std::string name;
+    bool once = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--once") {
+            once = true;
+        } else if (argument.find_first_not_of("0123456789") == std::string::npos) {
+            name = STATS_PAGE_PREFIX + argument;
+        } else {
+            name = argument;
+        }
+    }
+
+    if (name.empty()) {
+        printf("Usage: %s <pid | page name> [--once]\n", argv[0]);
+        return 1;
+    }
+
+    int file = shm_open(name.c_str(), O_RDONLY, 0);
+    if (file < 0) {
+        printf("Unable to open stats page %s, is the program running? %s\n", name.c_str(), strerror(errno));
+        return 1;
+    }
+
+    struct stat info;
+    void* mapping = MAP_FAILED;
+    if (fstat(file, &info) == 0 && (size_t)info.st_size >= sizeof(LStatsPage)) {
+        mapping = mmap(NULL, sizeof(LStatsPage), PROT_READ, MAP_SHARED, file, 0);
+    }
+    close(file);
+
+    if (mapping == MAP_FAILED) {
+        printf("Unable to map stats page %s!\n", name.c_str());
+        return 1;
+    }
+
+    const LStatsPage* page = (const LStatsPage*)mapping;
+    if (page->magic != STATS_PAGE_MAGIC || page->version != STATS_PAGE_VERSION) {
+        printf("Stats page %s has tag %08x version %u, expected %08x version %u!\n", name.c_str(), page->magic, page->version, STATS_PAGE_MAGIC, STATS_PAGE_VERSION);
+        munmap(mapping, sizeof(LStatsPage));
+        return 1;
+    }
+
+    printf("Reading stats of process %u from %s\n", page->pid, name.c_str());
+
+    LFrameStats stats;
+    uint64_t lastFrame = 0;
+    int staleLines = 0;
+
+    while (true) {
+        if (!readStats(page, &stats)) {
+            printf("Stats page changed during every read attempt\n");
+        } else {
+            staleLines = stats.frame == lastFrame ? staleLines + 1 : 0;
+            lastFrame = stats.frame;
+
+            printf("frame %8llu  %6.2f ms (avg %6.2f, worst %6.2f)  %4u draw calls  %4u textures %7.1f MiB (peak %7.1f MiB)  %6.0f events/s%s\n",
+                (unsigned long long)stats.frame, stats.frameMs, stats.averageFrameMs, stats.worstFrameMs, stats.drawCalls,
+                stats.textureCount, stats.textureBytes / 1048576.0, stats.texturePeakBytes / 1048576.0, stats.eventsPerSecond,
+                staleLines >= STALL_LINES ? "  (stalled)" : "");
+        }
+        fflush(stdout);
+
+        // The page outlives a crashed publisher, stop once it is gone
+        if (kill((pid_t)page->pid, 0) != 0 && errno == ESRCH) {
+            printf("Process %u exited\n", page->pid);
+            break;
+        }
+
+        if (once) {
+            break;
+        }
+
+        usleep(READ_INTERVAL * 1000);
+    }
+
+    munmap(mapping, sizeof(LStatsPage));
+
+    return 0;
+}
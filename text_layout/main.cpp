@@ -0,0 +1,789 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_blendmode.h>
+#include <SDL2/SDL_error.h>
+#include <SDL2/SDL_events.h>
+#include <SDL2/SDL_keycode.h>
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_surface.h>
+#include <SDL2/SDL_timer.h>
+#include <SDL2/SDL_ttf.h>
+#include <SDL2/SDL_video.h>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+const int SCREEN_WIDTH = 640;
+const int SCREEN_HEIGHT = 480;
+
+const int FONT_SIZE = 16;
+
+// Margin around the text area
+const int TEXT_MARGIN = 10;
+
+// Wrap width change per key press
+const int WRAP_STEP = 40;
+
+// Frames between generated log lines
+const int LOG_INTERVAL = 15;
+
+// Lines appended by the benchmark
+const int BENCHMARK_LINES = 10000;
+
+enum TextAlign
+{
+    TEXT_ALIGN_LEFT,
+    TEXT_ALIGN_CENTER,
+    TEXT_ALIGN_RIGHT,
+    TEXT_ALIGN_TOTAL
+};
+
+class LTexture
+{
+    public:
+        // Initialize
+        LTexture();
+
+        // Deallocate
+        ~LTexture();
+
+        // Creates image from UTF-8 string, NULL font uses gFont
+        bool loadFromRenderedText(std::string textureText, SDL_Color textColor, TTF_Font* font = NULL);
+
+        // Deallocate texture
+        void free();
+
+        // Renders texture at given point
+        void render(int x, int y, SDL_Rect* clip = NULL);
+
+        // Gets image dimensions
+        int getWidth();
+        int getHeight();
+
+    private:
+        // The actual hardware texture
+        SDL_Texture* mTexture;
+
+        // Dimensions
+        int mWidth;
+        int mHeight;
+};
+
+class LTextLayout
+{
+    public:
+        // Initialize
+        LTextLayout();
+
+        // Deallocate
+        ~LTextLayout();
+
+        // Font used for measuring and rendering
+        void setFont(TTF_Font* font);
+
+        // Width lines wrap at, rewraps every paragraph when it changes
+        void setWrapWidth(int width);
+        int getWrapWidth();
+
+        // Horizontal alignment of wrapped lines
+        void setAlignment(TextAlign alignment);
+        TextAlign getAlignment();
+
+        void setColor(SDL_Color color);
+
+        // Adds a paragraph at the end and returns its index
+        int appendParagraph(std::string text);
+
+        // Replaces paragraph text, nothing is redone when it is unchanged
+        void setParagraph(int index, std::string text);
+        std::string getParagraph(int index);
+        int getParagraphCount();
+
+        // Height of all wrapped lines
+        int getHeight();
+
+        // Draws lines between scrollY and scrollY + height at x, y
+        void render(int x, int y, int scrollY, int height);
+
+        // Paragraphs wrapped and line textures rendered since start
+        int getWrapCount();
+        int getRenderCount();
+
+        // Deallocate everything
+        void free();
+
+    private:
+        struct Paragraph
+        {
+            std::string text;
+
+            // Width lines were wrapped at, -1 when text changed since
+            int wrappedWidth;
+
+            // Wrapped lines and their textures, created when first drawn
+            std::vector<std::string> lines;
+            std::vector<LTexture*> textures;
+        };
+
+        // Splits paragraph into lines, keeping textures of unchanged lines
+        void wrap(Paragraph& paragraph);
+
+        // Brings wrapping and line offsets up to date
+        void update();
+
+        // Advance of a codepoint from the font metrics
+        int getAdvance(Uint32 codepoint);
+
+        // Next codepoint of UTF-8 text starting at index
+        static Uint32 decodeUTF8(const std::string& text, size_t* index);
+
+        // Frees line textures of a paragraph
+        static void freeTextures(Paragraph& paragraph);
+
+        TTF_Font* mFont;
+        int mWrapWidth;
+        TextAlign mAlignment;
+        SDL_Color mColor;
+        int mLineHeight;
+
+        std::vector<Paragraph> mParagraphs;
+
+        // First line of every paragraph, valid before mDirtyFrom
+        std::vector<int> mFirstLine;
+        int mDirtyFrom;
+
+        // Paragraphs holding textures
+        std::vector<int> mTextured;
+
+        // Advances by codepoint
+        std::unordered_map<Uint32, int> mAdvances;
+
+        int mWrapCount;
+        int mRenderCount;
+};
+
+// Vsync is left off for benchmarks so presents do not wait for the display
+bool init(bool vsync);
+
+bool loadMedia();
+
+void close();
+
+// Times appending to a long log against relaying it all out
+void runBenchmark();
+
+SDL_Window* gWindow = NULL;
+
+SDL_Renderer* gRenderer = NULL;
+
+TTF_Font* gFont = NULL;
+
+LTextLayout gLog;
+
+LTexture::LTexture()
+{
+    mTexture = NULL;
+    mWidth = 0;
+    mHeight = 0;
+}
+
+LTexture::~LTexture()
+{
+    free();
+}
+
+void LTexture::free()
+{
+    if (mTexture != NULL) {
+        SDL_DestroyTexture(mTexture);
+        mTexture = NULL;
+        mWidth = 0;
+        mHeight = 0;
+    }
+}
+
+bool LTexture::loadFromRenderedText(std::string textureText, SDL_Color textColor, TTF_Font* font)
+{
+    free();
+
+    if (font == NULL) {
+        font = gFont;
+    }
+
+    SDL_Surface* textSurface = TTF_RenderUTF8_Blended(font, textureText.c_str(), textColor);
+    if (textSurface == NULL) {
+        printf("Unable to render text surface! SDL_ttf Error: %s\n", TTF_GetError());
+    } else {
+        mTexture = SDL_CreateTextureFromSurface(gRenderer, textSurface);
+        if (mTexture == NULL) {
+            printf("Unable to create texture from rendered text! SDL Error: %s\n", SDL_GetError());
+        } else {
+            mWidth = textSurface->w;
+            mHeight = textSurface->h;
+        }
+
+        SDL_FreeSurface(textSurface);
+    }
+
+    return mTexture != NULL;
+}
+
+void LTexture::render(int x, int y, SDL_Rect* clip)
+{
+    SDL_Rect renderQuad = {x, y, mWidth, mHeight};
+
+    if (clip != NULL) {
+        renderQuad.w = clip->w;
+        renderQuad.h = clip->h;
+    }
+
+    SDL_RenderCopy(gRenderer, mTexture, clip, &renderQuad);
+}
+
+int LTexture::getWidth()
+{
+    return mWidth;
+}
+
+int LTexture::getHeight()
+{
+    return mHeight;
+}
+
+LTextLayout::LTextLayout()
+{
+    mFont = NULL;
+    mWrapWidth = SCREEN_WIDTH;
+    mAlignment = TEXT_ALIGN_LEFT;
+    mColor.r = 0;
+    mColor.g = 0;
+    mColor.b = 0;
+    mColor.a = 0xFF;
+    mLineHeight = 0;
+    mDirtyFrom = 0;
+    mWrapCount = 0;
+    mRenderCount = 0;
+}
+
+LTextLayout::~LTextLayout()
+{
+    free();
+}
+
+void LTextLayout::free()
+{
+    for (size_t i = 0; i < mParagraphs.size(); ++i) {
+        freeTextures(mParagraphs[i]);
+    }
+
+    mParagraphs.clear();
+    mFirstLine.clear();
+    mTextured.clear();
+    mAdvances.clear();
+    mDirtyFrom = 0;
+}
+
+void LTextLayout::freeTextures(Paragraph& paragraph)
+{
+    for (size_t i = 0; i < paragraph.textures.size(); ++i) {
+        delete paragraph.textures[i];
+        paragraph.textures[i] = NULL;
+    }
+}
+
+void LTextLayout::setFont(TTF_Font* font)
+{
+    mFont = font;
+    mLineHeight = TTF_FontLineSkip(font);
+    mAdvances.clear();
+
+    for (size_t i = 0; i < mParagraphs.size(); ++i) {
+        freeTextures(mParagraphs[i]);
+        mParagraphs[i].wrappedWidth = -1;
+    }
+    mTextured.clear();
+    mDirtyFrom = 0;
+}
+
+void LTextLayout::setWrapWidth(int width)
+{
+    if (width != mWrapWidth) {
+        mWrapWidth = width;
+        mDirtyFrom = 0;
+    }
+}
+
+int LTextLayout::getWrapWidth()
+{
+    return mWrapWidth;
+}
+
+void LTextLayout::setAlignment(TextAlign alignment)
+{
+    mAlignment = alignment;
+}
+
+TextAlign LTextLayout::getAlignment()
+{
+    return mAlignment;
+}
+
+void LTextLayout::setColor(SDL_Color color)
+{
+    mColor = color;
+
+    for (size_t i = 0; i < mParagraphs.size(); ++i) {
+        freeTextures(mParagraphs[i]);
+    }
+    mTextured.clear();
+}
+
+int LTextLayout::appendParagraph(std::string text)
+{
+    Paragraph paragraph;
+    paragraph.text = text;
+    paragraph.wrappedWidth = -1;
+
+    mParagraphs.push_back(paragraph);
+    mDirtyFrom = SDL_min(mDirtyFrom, (int)mParagraphs.size() - 1);
+
+    return (int)mParagraphs.size() - 1;
+}
+
+void LTextLayout::setParagraph(int index, std::string text)
+{
+    Paragraph& paragraph = mParagraphs[index];
+    if (paragraph.text == text) {
+        return;
+    }
+
+    paragraph.text = text;
+    paragraph.wrappedWidth = -1;
+    mDirtyFrom = SDL_min(mDirtyFrom, index);
+}
+
+std::string LTextLayout::getParagraph(int index)
+{
+    return mParagraphs[index].text;
+}
+
+int LTextLayout::getParagraphCount()
+{
+    return (int)mParagraphs.size();
+}
+
+Uint32 LTextLayout::decodeUTF8(const std::string& text, size_t* index)
+{
+    Uint8 lead = (Uint8)text[(*index)++];
+    int continuation = 0;
+    Uint32 codepoint = lead;
+
+    if (lead >= 0xF0) {
+        codepoint = lead & 0x07;
+        continuation = 3;
+    } else if (lead >= 0xE0) {
+        codepoint = lead & 0x0F;
+        continuation = 2;
+    } else if (lead >= 0xC0) {
+        codepoint = lead & 0x1F;
+        continuation = 1;
+    }
+
+    while (continuation-- > 0 && *index < text.size()) {
+        codepoint = (codepoint << 6) | ((Uint8)text[(*index)++] & 0x3F);
+    }
+
+    return codepoint;
+}
+
+int LTextLayout::getAdvance(Uint32 codepoint)
+{
+    std::unordered_map<Uint32, int>::iterator found = mAdvances.find(codepoint);
+    if (found != mAdvances.end()) {
+        return found->second;
+    }
+
+    int minx, maxx, miny, maxy, advance;
+    if (TTF_GlyphMetrics32(mFont, codepoint, &minx, &maxx, &miny, &maxy, &advance) < 0) {
+        advance = 0;
+    }
+
+    mAdvances[codepoint] = advance;
+    return advance;
+}
+
+void LTextLayout::wrap(Paragraph& paragraph)
+{
+    std::vector<std::string> lines;
+    const std::string& text = paragraph.text;
+
+    size_t lineStart = 0;
+    size_t index = 0;
+    int width = 0;
+
+    // Where the line can break after the last space, and the width up to it
+    size_t breakAt = std::string::npos;
+
+    while (index < text.size()) {
+        size_t charStart = index;
+        Uint32 codepoint = decodeUTF8(text, &index);
+
+        if (codepoint == '\n') {
+            lines.push_back(text.substr(lineStart, charStart - lineStart));
+            lineStart = index;
+            width = 0;
+            breakAt = std::string::npos;
+            continue;
+        }
+
+        width += getAdvance(codepoint);
+
+        if (width > mWrapWidth && charStart > lineStart) {
+            // Break at the last space, or mid word when there is none
+            size_t lineEnd = breakAt != std::string::npos ? breakAt : charStart;
+            lines.push_back(text.substr(lineStart, lineEnd - lineStart));
+
+            lineStart = lineEnd;
+            while (lineStart < text.size() && text[lineStart] == ' ') {
+                ++lineStart;
+            }
+
+            // Measure again from the new line start
+            index = lineStart;
+            width = 0;
+            breakAt = std::string::npos;
+            continue;
+        }
+
+        if (codepoint == ' ') {
+            breakAt = charStart;
+        }
+    }
+
+    lines.push_back(text.substr(lineStart));
+
+    // Keep the texture of every line that wrapped the same as before
+    std::vector<LTexture*> textures(lines.size(), (LTexture*)NULL);
+    for (size_t i = 0; i < lines.size() && i < paragraph.lines.size(); ++i) {
+        if (paragraph.textures.size() > i && lines[i] == paragraph.lines[i]) {
+            textures[i] = paragraph.textures[i];
+            paragraph.textures[i] = NULL;
+        }
+    }
+    freeTextures(paragraph);
+
+    paragraph.lines.swap(lines);
+    paragraph.textures.swap(textures);
+    paragraph.wrappedWidth = mWrapWidth;
+
+    ++mWrapCount;
+}
+
+void LTextLayout::update()
+{
+    if (mDirtyFrom >= (int)mParagraphs.size()) {
+        return;
+    }
+
+    mFirstLine.resize(mParagraphs.size());
+
+    int line = mDirtyFrom > 0 ? mFirstLine[mDirtyFrom - 1] + (int)mParagraphs[mDirtyFrom - 1].lines.size() : 0;
+    for (size_t i = mDirtyFrom; i < mParagraphs.size(); ++i) {
+        Paragraph& paragraph = mParagraphs[i];
+        if (paragraph.wrappedWidth != mWrapWidth) {
+            wrap(paragraph);
+        }
+
+        mFirstLine[i] = line;
+        line += (int)paragraph.lines.size();
+    }
+
+    mDirtyFrom = (int)mParagraphs.size();
+}
+
+int LTextLayout::getHeight()
+{
+    update();
+
+    if (mParagraphs.empty()) {
+        return 0;
+    }
+
+    return (mFirstLine.back() + (int)mParagraphs.back().lines.size()) * mLineHeight;
+}
+
+void LTextLayout::render(int x, int y, int scrollY, int height)
+{
+    update();
+
+    if (mParagraphs.empty() || mLineHeight <= 0) {
+        return;
+    }
+
+    // Paragraphs overlapping the visible lines
+    int firstVisible = scrollY / mLineHeight;
+    int lastVisible = (scrollY + height) / mLineHeight;
+
+    int first = (int)(std::upper_bound(mFirstLine.begin(), mFirstLine.end(), firstVisible) - mFirstLine.begin()) - 1;
+    first = SDL_max(0, first);
+
+    std::vector<int> textured;
+    for (int i = first; i < (int)mParagraphs.size() && mFirstLine[i] <= lastVisible; ++i) {
+        Paragraph& paragraph = mParagraphs[i];
+
+        for (size_t l = 0; l < paragraph.lines.size(); ++l) {
+            int line = mFirstLine[i] + (int)l;
+            if (line < firstVisible || line > lastVisible || paragraph.lines[l].empty()) {
+                continue;
+            }
+
+            LTexture*& texture = paragraph.textures[l];
+            if (texture == NULL) {
+                texture = new LTexture();
+                texture->loadFromRenderedText(paragraph.lines[l], mColor, mFont);
+                ++mRenderCount;
+            }
+
+            int offset = 0;
+            if (mAlignment == TEXT_ALIGN_CENTER) {
+                offset = (mWrapWidth - texture->getWidth()) / 2;
+            } else if (mAlignment == TEXT_ALIGN_RIGHT) {
+                offset = mWrapWidth - texture->getWidth();
+            }
+
+            texture->render(x + offset, y + line * mLineHeight - scrollY);
+        }
+
+        textured.push_back(i);
+    }
+
+    // Paragraphs scrolled out of view give their textures back
+    for (size_t t = 0; t < mTextured.size(); ++t) {
+        int index = mTextured[t];
+        if (index < (int)mParagraphs.size() && !std::binary_search(textured.begin(), textured.end(), index)) {
+            freeTextures(mParagraphs[index]);
+        }
+    }
+    mTextured.swap(textured);
+}
+
+int LTextLayout::getWrapCount()
+{
+    return mWrapCount;
+}
+
+int LTextLayout::getRenderCount()
+{
+    return mRenderCount;
+}
+
+void runBenchmark()
+{
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    int viewHeight = SCREEN_HEIGHT - TEXT_MARGIN * 2;
+
+    // Append one line per frame and draw the tail, like a scrolling log
+    LTextLayout layout;
+    layout.setFont(gFont);
+    layout.setWrapWidth(SCREEN_WIDTH - TEXT_MARGIN * 2);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < BENCHMARK_LINES; ++i) {
+        layout.appendParagraph("[" + std::to_string(i) + "] The quick brown fox jumps over the lazy dog while the log keeps growing line after line");
+
+        int scroll = SDL_max(0, layout.getHeight() - viewHeight);
+        SDL_RenderClear(gRenderer);
+        layout.render(TEXT_MARGIN, TEXT_MARGIN, scroll, viewHeight);
+        SDL_RenderPresent(gRenderer);
+    }
+    double incrementalMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+
+    printf("Incremental: %d appends in %.1f ms (%.3f ms each), %d paragraph wraps, %d line textures\n",
+        BENCHMARK_LINES, incrementalMs, incrementalMs / BENCHMARK_LINES, layout.getWrapCount(), layout.getRenderCount());
+
+    // What every append would cost if the whole log were laid out again
+    const int relayouts = 10;
+    start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < relayouts; ++i) {
+        layout.setWrapWidth(SCREEN_WIDTH - TEXT_MARGIN * 2 - (i % 2 + 1));
+        layout.getHeight();
+    }
+    double fullMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency / relayouts;
+
+    printf("Full relayout of %d paragraphs: %.3f ms each\n", layout.getParagraphCount(), fullMs);
+}
+
+bool init(bool vsync)
+{
+    bool success = true;
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        printf("SDL failed to initialize!\n");
+        success = false;
+    } else {
+        gWindow = SDL_CreateWindow("SDL Tutorial", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
+        if (gWindow == NULL) {
+            printf("Failed to create window! SDL Error: %s\n", SDL_GetError());
+            success = false;
+        } else {
+            Uint32 flags = SDL_RENDERER_ACCELERATED;
+            if (vsync) {
+                flags |= SDL_RENDERER_PRESENTVSYNC;
+            }
+
+            gRenderer = SDL_CreateRenderer(gWindow, -1, flags);
+            if (gRenderer == NULL) {
+                printf("Failed to create renderer! SDL Error: %s\n", SDL_GetError());
+                success = false;
+            } else {
+                SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+
+                if (TTF_Init() == -1) {
+                    printf("SDL_ttf failed to initialize! SDL_ttf Error: %s\n", TTF_GetError());
+                    success = false;
+                }
+            }
+        }
+    }
+
+    return success;
+}
+
+bool loadMedia()
+{
+    bool success = true;
+
+    gFont = TTF_OpenFont("lazy.ttf", FONT_SIZE);
+    if (gFont == NULL) {
+        printf("Failed to load lazy font! SDL_ttf Error: %s\n", TTF_GetError());
+        success = false;
+    } else {
+        gLog.setFont(gFont);
+        gLog.setWrapWidth(SCREEN_WIDTH - TEXT_MARGIN * 2);
+    }
+
+    return success;
+}
+
+void close()
+{
+    gLog.free();
+
+    TTF_CloseFont(gFont);
+    gFont = NULL;
+
+    SDL_DestroyRenderer(gRenderer);
+    SDL_DestroyWindow(gWindow);
+    gWindow = NULL;
+    gRenderer = NULL;
+
+    TTF_Quit();
+    SDL_Quit();
+}
+
+int main (int argc, char *argv[])
+{
+    bool benchmark = argc > 1 && std::string(argv[1]) == "--bench";
+
+    if (!init(!benchmark)) {
+        printf("Failed to initialize!\n");
+    } else {
+        if (!loadMedia()) {
+            printf("Failed to load media!\n");
+        } else if (benchmark) {
+            runBenchmark();
+        } else {
+            bool quit = false;
+
+            SDL_Event e;
+
+            int frame = 0;
+            int logLine = 0;
+
+            // Bottom paragraph takes typed text
+            std::string input;
+            int inputParagraph = gLog.appendParagraph("> ");
+
+            // Follow the end of the log until the user scrolls up
+            int viewHeight = SCREEN_HEIGHT - TEXT_MARGIN * 2;
+            int scroll = 0;
+            bool followTail = true;
+
+            SDL_StartTextInput();
+
+            while (!quit) {
+                while (SDL_PollEvent(&e) != 0) {
+                    if (e.type == SDL_QUIT) {
+                        quit = true;
+                    } else if (e.type == SDL_TEXTINPUT) {
+                        input += e.text.text;
+                    } else if (e.type == SDL_MOUSEWHEEL) {
+                        scroll -= e.wheel.y * FONT_SIZE * 3;
+                        followTail = false;
+                    } else if (e.type == SDL_KEYDOWN) {
+                        switch (e.key.keysym.sym) {
+                            // Drop the last UTF-8 character
+                            case SDLK_BACKSPACE:
+                            while (!input.empty() && ((Uint8)input[input.size() - 1] & 0xC0) == 0x80) {
+                                input.erase(input.size() - 1);
+                            }
+                            if (!input.empty()) {
+                                input.erase(input.size() - 1);
+                            }
+                            break;
+
+                            // Commit typed line into the log
+                            case SDLK_RETURN:
+                            gLog.setParagraph(inputParagraph, input);
+                            input.clear();
+                            inputParagraph = gLog.appendParagraph("> ");
+                            followTail = true;
+                            break;
+
+                            case SDLK_TAB:
+                            gLog.setAlignment((TextAlign)((gLog.getAlignment() + 1) % TEXT_ALIGN_TOTAL));
+                            break;
+
+                            case SDLK_LEFT:
+                            gLog.setWrapWidth(SDL_max(WRAP_STEP, gLog.getWrapWidth() - WRAP_STEP));
+                            break;
+
+                            case SDLK_RIGHT:
+                            gLog.setWrapWidth(SDL_min(SCREEN_WIDTH - TEXT_MARGIN * 2, gLog.getWrapWidth() + WRAP_STEP));
+                            break;
+                        }
+                    }
+                }
+
+                // Generated log lines land above the input line
+                if (frame % LOG_INTERVAL == 0) {
+                    gLog.setParagraph(inputParagraph, "[" + std::to_string(logLine++) + "] frame " + std::to_string(frame) + ", the quick brown fox jumps over the lazy dog");
+                    inputParagraph = gLog.appendParagraph("> " + input);
+                }
+                gLog.setParagraph(inputParagraph, "> " + input);
+
+                int maxScroll = SDL_max(0, gLog.getHeight() - viewHeight);
+                if (followTail) {
+                    scroll = maxScroll;
+                }
+                scroll = SDL_max(0, SDL_min(maxScroll, scroll));
+
+                SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+                SDL_RenderClear(gRenderer);
+
+                gLog.render(TEXT_MARGIN, TEXT_MARGIN, scroll, viewHeight);
+
+                SDL_RenderPresent(gRenderer);
+
+                ++frame;
+            }
+
+            SDL_StopTextInput();
+        }
+    }
+
+    close();
+
+    return 0;
+}
@@ -0,0 +1,479 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_error.h>
+#include <SDL2/SDL_events.h>
+#include <SDL2/SDL_pixels.h>
+#include <SDL2/SDL_rect.h>
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_surface.h>
+#include <SDL2/SDL_timer.h>
+#include <SDL2/SDL_video.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+const int SCREEN_WIDTH = 640;
+const int SCREEN_HEIGHT = 480;
+
+// Rotating streaming textures, the renderer may still read the previous one
+const int STREAMING_BUFFERS = 3;
+
+// Size of the region redrawn in partial mode
+const int PARTIAL_SIZE = 128;
+
+// Frames per benchmark case
+const int BENCHMARK_FRAMES = 300;
+
+class LTexture
+{
+    public:
+        // Initialize
+        LTexture();
+
+        // Deallocate
+        ~LTexture();
+
+        // Creates rotating streaming textures with a CPU side pixel buffer
+        bool createStreaming(int width, int height, int bufferCount = STREAMING_BUFFERS);
+
+        // Deallocate textures
+        void free();
+
+        // CPU side ARGB8888 pixels and their pitch in bytes
+        Uint32* getPixels();
+        int getPitch();
+
+        // Marks region of the pixel buffer as changed, NULL for all of it
+        void markDirty(SDL_Rect* rect = NULL);
+
+        // Copies changed regions into the next texture through SDL_LockTexture
+        bool upload();
+
+        // Bytes copied by the last upload
+        int getUploadedBytes();
+
+        // Renders most recently uploaded texture at given point
+        void render(int x, int y, SDL_Rect* clip = NULL);
+
+        // Gets image dimensions
+        int getWidth();
+        int getHeight();
+
+    private:
+        // Grows rect to cover other
+        static void unionRect(SDL_Rect* rect, const SDL_Rect* other);
+
+        // The actual hardware textures
+        std::vector<SDL_Texture*> mTextures;
+
+        // Region of each texture older than the pixel buffer
+        std::vector<SDL_Rect> mStale;
+
+        // Texture shown by render
+        int mCurrent;
+
+        // CPU side pixels
+        std::vector<Uint32> mPixels;
+
+        // Region changed since the last upload
+        SDL_Rect mDirty;
+
+        int mUploadedBytes;
+
+        // Image dimensions
+        int mWidth;
+        int mHeight;
+};
+
+bool init(bool vsync);
+
+bool loadMedia();
+
+void close();
+
+// Draws animated pattern into rect of pixels
+void drawPattern(Uint32* pixels, int pitch, SDL_Rect* rect, int frame);
+
+// Compares upload bandwidth of the streaming path against surface-then-create
+void runBenchmark();
+
+SDL_Window* gWindow = NULL;
+
+SDL_Renderer* gRenderer = NULL;
+
+LTexture gStreamingTexture;
+
+LTexture::LTexture()
+{
+    mCurrent = 0;
+    mDirty.x = 0;
+    mDirty.y = 0;
+    mDirty.w = 0;
+    mDirty.h = 0;
+    mUploadedBytes = 0;
+    mWidth = 0;
+    mHeight = 0;
+}
+
+LTexture::~LTexture()
+{
+    free();
+}
+
+bool LTexture::createStreaming(int width, int height, int bufferCount)
+{
+    free();
+
+    for (int i = 0; i < bufferCount; ++i) {
+        SDL_Texture* newTexture = SDL_CreateTexture(gRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+        if (newTexture == NULL) {
+            printf("Unable to create streaming texture! SDL Error: %s\n", SDL_GetError());
+            free();
+            return false;
+        }
+
+        // Every texture starts out fully stale
+        SDL_Rect stale = {0, 0, width, height};
+        mTextures.push_back(newTexture);
+        mStale.push_back(stale);
+    }
+
+    mPixels.assign(width * height, 0);
+    mCurrent = 0;
+    mWidth = width;
+    mHeight = height;
+
+    return true;
+}
+
+void LTexture::free()
+{
+    for (size_t i = 0; i < mTextures.size(); ++i) {
+        SDL_DestroyTexture(mTextures[i]);
+    }
+
+    mTextures.clear();
+    mStale.clear();
+    mPixels.clear();
+    mDirty.w = 0;
+    mDirty.h = 0;
+    mWidth = 0;
+    mHeight = 0;
+}
+
+Uint32* LTexture::getPixels()
+{
+    return mPixels.empty() ? NULL : &mPixels[0];
+}
+
+int LTexture::getPitch()
+{
+    return mWidth * 4;
+}
+
+void LTexture::unionRect(SDL_Rect* rect, const SDL_Rect* other)
+{
+    if (other->w <= 0 || other->h <= 0) {
+        return;
+    }
+
+    if (rect->w <= 0 || rect->h <= 0) {
+        *rect = *other;
+        return;
+    }
+
+    int right = SDL_max(rect->x + rect->w, other->x + other->w);
+    int bottom = SDL_max(rect->y + rect->h, other->y + other->h);
+    rect->x = SDL_min(rect->x, other->x);
+    rect->y = SDL_min(rect->y, other->y);
+    rect->w = right - rect->x;
+    rect->h = bottom - rect->y;
+}
+
+void LTexture::markDirty(SDL_Rect* rect)
+{
+    SDL_Rect bounds = {0, 0, mWidth, mHeight};
+    SDL_Rect clipped = bounds;
+
+    if (rect != NULL && !SDL_IntersectRect(rect, &bounds, &clipped)) {
+        return;
+    }
+
+    unionRect(&mDirty, &clipped);
+}
+
+bool LTexture::upload()
+{
+    mUploadedBytes = 0;
+
+    if (mTextures.empty()) {
+        return false;
+    }
+
+    // Textures not written this time fall behind by the changed region
+    for (size_t i = 0; i < mStale.size(); ++i) {
+        unionRect(&mStale[i], &mDirty);
+    }
+    mDirty.w = 0;
+    mDirty.h = 0;
+
+    // Write the texture least recently handed to the renderer
+    int next = (mCurrent + 1) % (int)mTextures.size();
+    SDL_Rect* region = &mStale[next];
+
+    if (region->w > 0 && region->h > 0) {
+        void* pixels;
+        int pitch;
+        if (SDL_LockTexture(mTextures[next], region, &pixels, &pitch) < 0) {
+            printf("Unable to lock streaming texture! SDL Error: %s\n", SDL_GetError());
+            return false;
+        }
+
+        // Locked pixels start at the region origin
+        const Uint8* src = (const Uint8*)&mPixels[region->y * mWidth + region->x];
+        Uint8* dst = (Uint8*)pixels;
+        int rowBytes = region->w * 4;
+        for (int row = 0; row < region->h; ++row) {
+            memcpy(dst, src, rowBytes);
+            src += getPitch();
+            dst += pitch;
+        }
+
+        SDL_UnlockTexture(mTextures[next]);
+
+        mUploadedBytes = rowBytes * region->h;
+        region->w = 0;
+        region->h = 0;
+    }
+
+    mCurrent = next;
+    return true;
+}
+
+int LTexture::getUploadedBytes()
+{
+    return mUploadedBytes;
+}
+
+void LTexture::render(int x, int y, SDL_Rect* clip)
+{
+    if (mTextures.empty()) {
+        return;
+    }
+
+    SDL_Rect renderQuad = {x, y, mWidth, mHeight};
+
+    if (clip != NULL) {
+        renderQuad.w = clip->w;
+        renderQuad.h = clip->h;
+    }
+
+    SDL_RenderCopy(gRenderer, mTextures[mCurrent], clip, &renderQuad);
+}
+
+int LTexture::getWidth()
+{
+    return mWidth;
+}
+
+int LTexture::getHeight()
+{
+    return mHeight;
+}
+
+void drawPattern(Uint32* pixels, int pitch, SDL_Rect* rect, int frame)
+{
+    int stride = pitch / 4;
+
+    for (int y = rect->y; y < rect->y + rect->h; ++y) {
+        Uint32* row = pixels + y * stride;
+        for (int x = rect->x; x < rect->x + rect->w; ++x) {
+            Uint8 r = (Uint8)(x + frame);
+            Uint8 g = (Uint8)(y + frame * 2);
+            Uint8 b = (Uint8)((x ^ y) + frame);
+            row[x] = 0xFF000000 | (r << 16) | (g << 8) | b;
+        }
+    }
+}
+
+bool init(bool vsync)
+{
+    bool success = true;
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        printf("SDL failed to initialize!\n");
+        success = false;
+    } else {
+        gWindow = SDL_CreateWindow("SDL Tutorial", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
+        if (gWindow == NULL) {
+            printf("Failed to create window! SDL Error: %s\n", SDL_GetError());
+            success = false;
+        } else {
+            Uint32 flags = SDL_RENDERER_ACCELERATED;
+            if (vsync) {
+                flags |= SDL_RENDERER_PRESENTVSYNC;
+            }
+
+            gRenderer = SDL_CreateRenderer(gWindow, -1, flags);
+            if (gRenderer == NULL) {
+                printf("Failed to create renderer! SDL Error: %s\n", SDL_GetError());
+                success = false;
+            } else {
+                SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+            }
+        }
+    }
+
+    return success;
+}
+
+bool loadMedia()
+{
+    bool success = true;
+
+    if (!gStreamingTexture.createStreaming(SCREEN_WIDTH, SCREEN_HEIGHT)) {
+        printf("Failed to create streaming texture!\n");
+        success = false;
+    }
+
+    return success;
+}
+
+void runBenchmark()
+{
+    SDL_Rect full = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+    SDL_Rect partial = {0, 0, PARTIAL_SIZE, PARTIAL_SIZE};
+    double frequency = (double)SDL_GetPerformanceFrequency();
+
+    // Surface then create, the path every other program uses
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (surface == NULL) {
+        printf("Unable to create benchmark surface! SDL Error: %s\n", SDL_GetError());
+        return;
+    }
+
+    double bytes = 0;
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int frame = 0; frame < BENCHMARK_FRAMES; ++frame) {
+        drawPattern((Uint32*)surface->pixels, surface->pitch, &full, frame);
+
+        SDL_Texture* texture = SDL_CreateTextureFromSurface(gRenderer, surface);
+        SDL_RenderCopy(gRenderer, texture, NULL, NULL);
+        SDL_RenderPresent(gRenderer);
+        SDL_DestroyTexture(texture);
+
+        bytes += surface->pitch * surface->h;
+    }
+    double seconds = (SDL_GetPerformanceCounter() - start) / frequency;
+    printf("surface+create:   %7.3f ms/frame, %8.1f MB/s\n", seconds * 1000.0 / BENCHMARK_FRAMES, bytes / seconds / (1024.0 * 1024.0));
+
+    SDL_FreeSurface(surface);
+
+    // Streaming, whole frame changes
+    bytes = 0;
+    start = SDL_GetPerformanceCounter();
+    for (int frame = 0; frame < BENCHMARK_FRAMES; ++frame) {
+        drawPattern(gStreamingTexture.getPixels(), gStreamingTexture.getPitch(), &full, frame);
+        gStreamingTexture.markDirty();
+        gStreamingTexture.upload();
+        gStreamingTexture.render(0, 0);
+        SDL_RenderPresent(gRenderer);
+
+        bytes += gStreamingTexture.getUploadedBytes();
+    }
+    seconds = (SDL_GetPerformanceCounter() - start) / frequency;
+    printf("streaming full:   %7.3f ms/frame, %8.1f MB/s\n", seconds * 1000.0 / BENCHMARK_FRAMES, bytes / seconds / (1024.0 * 1024.0));
+
+    // Streaming, a moving square changes
+    bytes = 0;
+    start = SDL_GetPerformanceCounter();
+    for (int frame = 0; frame < BENCHMARK_FRAMES; ++frame) {
+        partial.x = (frame * 4) % (SCREEN_WIDTH - PARTIAL_SIZE);
+        partial.y = (frame * 3) % (SCREEN_HEIGHT - PARTIAL_SIZE);
+        drawPattern(gStreamingTexture.getPixels(), gStreamingTexture.getPitch(), &partial, frame);
+        gStreamingTexture.markDirty(&partial);
+        gStreamingTexture.upload();
+        gStreamingTexture.render(0, 0);
+        SDL_RenderPresent(gRenderer);
+
+        bytes += gStreamingTexture.getUploadedBytes();
+    }
+    seconds = (SDL_GetPerformanceCounter() - start) / frequency;
+    printf("streaming partial: %6.3f ms/frame, %8.1f MB/s\n", seconds * 1000.0 / BENCHMARK_FRAMES, bytes / seconds / (1024.0 * 1024.0));
+}
+
+void close()
+{
+    gStreamingTexture.free();
+
+    SDL_DestroyRenderer(gRenderer);
+    SDL_DestroyWindow(gWindow);
+    gWindow = NULL;
+    gRenderer = NULL;
+
+    SDL_Quit();
+}
+
+int main (int argc, char *argv[])
+{
+    // Benchmark runs unthrottled
+    bool benchmark = argc > 1 && std::string(argv[1]) == "--bench";
+
+    if (!init(!benchmark)) {
+        printf("Failed to initialize!\n");
+    } else {
+        if (!loadMedia()) {
+            printf("Failed to load media!\n");
+        } else if (benchmark) {
+            runBenchmark();
+        } else {
+            bool quit = false;
+
+            SDL_Event e;
+
+            int frame = 0;
+
+            // Only redraw a moving square instead of the whole frame
+            bool partialMode = false;
+
+            SDL_Rect full = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+            SDL_Rect partial = {0, 0, PARTIAL_SIZE, PARTIAL_SIZE};
+
+            while (!quit) {
+                while (SDL_PollEvent(&e) != 0) {
+                    if (e.type == SDL_QUIT) {
+                        quit = true;
+                    } else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_SPACE) {
+                        partialMode = !partialMode;
+                    }
+                }
+
+                // Composite this frame's content on the CPU
+                if (partialMode) {
+                    partial.x = (frame * 4) % (SCREEN_WIDTH - PARTIAL_SIZE);
+                    partial.y = (frame * 3) % (SCREEN_HEIGHT - PARTIAL_SIZE);
+                    drawPattern(gStreamingTexture.getPixels(), gStreamingTexture.getPitch(), &partial, frame);
+                    gStreamingTexture.markDirty(&partial);
+                } else {
+                    drawPattern(gStreamingTexture.getPixels(), gStreamingTexture.getPitch(), &full, frame);
+                    gStreamingTexture.markDirty();
+                }
+
+                gStreamingTexture.upload();
+
+                SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+                SDL_RenderClear(gRenderer);
+
+                gStreamingTexture.render(0, 0);
+
+                SDL_RenderPresent(gRenderer);
+
+                ++frame;
+            }
+        }
+    }
+
+    close();
+
+    return 0;
+}
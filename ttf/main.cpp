@@ -9,13 +9,112 @@
 #include <SDL2/SDL_surface.h>
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL_video.h>
+#include <atomic>
+#include <cerrno>
 #include <cstdio>
+#include <cstring>
 #include <string>
 #include <cmath>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 480;
 
+// Bytes of rendered text kept around by the text cache
+const size_t TEXT_CACHE_BUDGET = 4 * 1024 * 1024;
+
+// Bytes of texture memory owners are asked to stay within
+const size_t TEXTURE_MEMORY_BUDGET = 32 * 1024 * 1024;
+
+// Shared memory page stats are published to, suffixed with the pid, and its "LSTA" tag and layout version
+const char* STATS_PAGE_PREFIX = "/lesson_ttf_stats.";
+const Uint32 STATS_PAGE_MAGIC = 0x4154534C;
+const Uint32 STATS_PAGE_VERSION = 1;
+
+// Publishes timed by --stats-bench
+const int STATS_BENCH_PUBLISHES = 10000000;
+
+// Frames shown in the overlay graph, pixels per frame and graph height
+const int OVERLAY_HISTORY = 120;
+const int OVERLAY_BAR_WIDTH = 2;
+const int OVERLAY_GRAPH_HEIGHT = 60;
+
+// Frame time at the top of the overlay graph and the target it marks
+const double OVERLAY_GRAPH_MAX_MS = 50;
+const double OVERLAY_TARGET_MS = 1000.0 / 60;
+
+// Overlay text size, one of WARM_SIZES so it never needs rasterizing
+const int OVERLAY_FONT_SIZE = 14;
+
+// Point size gFont is opened at
+const int FONT_SIZE = 28;
+
+// Side of each glyph atlas page
+const int GLYPH_PAGE_SIZE = 1024;
+
+// Codepoints rasterized per worker job
+const int GLYPH_JOB_SIZE = 256;
+
+// Inclusive codepoint range
+struct GlyphRange
+{
+    Uint32 first;
+    Uint32 last;
+};
+
+// Point sizes and ranges warmed at startup, Latin-1 plus kana and common CJK
+const int WARM_SIZES[] = {14, 20, 28};
+const GlyphRange WARM_RANGES[] = {
+    {0x0020, 0x007E},
+    {0x00A0, 0x00FF},
+    {0x3040, 0x30FF},
+    {0x4E00, 0x4FFF}
+};
+
+// Live numbers published every frame for stats_reader
+struct LFrameStats
+{
+    Uint64 frame;
+
+    // Last frame, moving average and worst frame of the last second
+    double frameMs;
+    double averageFrameMs;
+    double worstFrameMs;
+
+    Uint32 drawCalls;
+    Uint32 textureCount;
+    Uint64 textureBytes;
+    Uint64 texturePeakBytes;
+
+    Uint64 events;
+    double eventsPerSecond;
+};
+
+// Shared memory layout, bump STATS_PAGE_VERSION when it changes
+struct LStatsPage
+{
+    Uint32 magic;
+    Uint32 version;
+    Uint32 pid;
+
+    // Odd while the publisher is writing stats
+    std::atomic<Uint32> sequence;
+
+    LFrameStats stats;
+};
+
 class LTexture
 {
     public:
@@ -28,12 +127,15 @@ class LTexture
         // Load image at specified path
         bool loadFromFile(std::string path);
 
-        // Creates image from font string
-        bool loadFromRenderedText(std::string textureText, SDL_Color textColor);
+        // Creates image from font string, NULL font uses gFont
+        bool loadFromRenderedText(std::string textureText, SDL_Color textColor, TTF_Font* font = NULL);
 
         // Deallocate texture
         void free();
 
+        // Tag the texture registry reports later loads under
+        void setOwner(std::string owner);
+
         // Set color modulation
         void setColor(Uint8 red, Uint8 green, Uint8 blue);
 
@@ -57,6 +159,277 @@ class LTexture
         // Dimensions
         int mWidth;
         int mHeight;
+
+        // Registry owner tag
+        std::string mOwner;
+};
+
+class LTextCache
+{
+    public:
+        // Initialize with a byte budget
+        LTextCache(size_t budget = TEXT_CACHE_BUDGET);
+
+        // Returns texture of text, rendering it only on a miss
+        std::shared_ptr<LTexture> get(TTF_Font* font, int size, std::string text, SDL_Color color);
+
+        // Renders strings ahead of their first use
+        void prewarm(TTF_Font* font, int size, const std::vector<std::string>& strings, SDL_Color color);
+
+        // Drops least recently used entries until bytes are released
+        void evict(size_t bytes);
+
+        // Drops every entry
+        void clear();
+
+        // Prints hit rate and memory use
+        void printStats();
+
+    private:
+        // What a rendered string depends on
+        struct Key
+        {
+            TTF_Font* font;
+            int size;
+            int style;
+            Uint32 color;
+            size_t textHash;
+            std::string text;
+
+            bool operator==(const Key& other) const;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const;
+        };
+
+        struct Entry
+        {
+            Key key;
+            std::shared_ptr<LTexture> texture;
+            size_t bytes;
+        };
+
+        // Evicts least recently used entries until within budget
+        void trim();
+
+        // Drops the least recently used entry
+        void evictLast();
+
+        // Most recently used first
+        std::list<Entry> mEntries;
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> mLookup;
+
+        size_t mBudget;
+        size_t mBytes;
+
+        unsigned long mHits;
+        unsigned long mMisses;
+        unsigned long mEvictions;
+};
+
+// Glyph location in the atlas
+struct LGlyph
+{
+    int page;
+    SDL_Rect clip;
+    int advance;
+};
+
+class LGlyphAtlas
+{
+    public:
+        // Initialize
+        LGlyphAtlas();
+
+        // Deallocate
+        ~LGlyphAtlas();
+
+        // Reads font file into memory, workers open their fonts from it
+        bool loadFont(std::string path);
+
+        // Rasterizes ranges at sizes on threadCount threads and packs the results
+        bool warm(const std::vector<int>& sizes, const std::vector<GlyphRange>& ranges, int threadCount);
+
+        // Draws UTF-8 text from warmed glyphs, missing glyphs are skipped
+        void render(int x, int y, std::string text, int size, SDL_Color color);
+
+        // Width of UTF-8 text from warmed glyphs
+        int measure(std::string text, int size);
+
+        // Warmed glyph or NULL
+        const LGlyph* getGlyph(int size, Uint32 codepoint);
+
+        // Line height of a warmed size
+        int getLineHeight(int size);
+
+        // Bytes held by atlas pages
+        size_t getBytes();
+
+        // Deallocate pages and font data
+        void free();
+
+    private:
+        // Codepoints of one size rasterized by one worker
+        struct RasterJob
+        {
+            int size;
+            Uint32 first;
+            Uint32 last;
+            int lineSkip;
+            std::vector<SDL_Surface*> surfaces;
+            std::vector<int> advances;
+        };
+
+        // Rasterizes jobs pulled from next until none are left
+        void rasterize(std::vector<RasterJob>* jobs, std::atomic<size_t>* next);
+
+        // Copies job surfaces into atlas pages, main thread only
+        bool pack(RasterJob& job);
+
+        // Uploads finished page surfaces
+        bool upload();
+
+        // Next codepoint of UTF-8 text starting at index
+        static Uint32 decodeUTF8(const std::string& text, size_t* index);
+
+        // Font file shared by every worker
+        void* mFontData;
+        size_t mFontDataSize;
+
+        // FreeType faces may render concurrently but open and close one at a time
+        std::mutex mFontMutex;
+
+        // Pages being packed and their uploaded textures
+        std::vector<SDL_Surface*> mPageSurfaces;
+        std::vector<SDL_Texture*> mPages;
+
+        // Shelf packing position in the last page
+        int mPenX;
+        int mPenY;
+        int mShelfHeight;
+
+        // Glyphs by size and codepoint
+        std::unordered_map<Uint64, LGlyph> mGlyphs;
+        std::unordered_map<int, int> mLineHeights;
+};
+
+class LTextureRegistry
+{
+    public:
+        // Initialize without a budget
+        LTextureRegistry();
+
+        // Records a created texture under an owner tag and load site, evicting when over budget
+        void add(SDL_Texture* texture, std::string owner, std::string site);
+
+        // Forgets a texture, call before destroying it
+        void remove(SDL_Texture* texture);
+
+        // Bytes owners are asked to stay within, 0 for no limit
+        void setBudget(size_t budget);
+
+        // Called in order with the bytes over budget until usage is back within it
+        void addEvictionCallback(std::function<void(size_t)> callback);
+
+        // Live and peak usage
+        size_t getBytes();
+        size_t getPeakBytes();
+        size_t getBudget();
+        int getCount();
+
+        // Prints usage by format and owner, then every live texture
+        void dump();
+
+        // Prints usage as one JSON object so benchmark logs can track it
+        void printJson(std::string label);
+
+        // Prints textures still registered, call before destroying the renderer
+        void printLeaks();
+
+    private:
+        struct Record
+        {
+            Uint32 format;
+            int width;
+            int height;
+            size_t bytes;
+            std::string owner;
+            std::string site;
+        };
+
+        // Estimated video memory of a texture
+        static size_t getTextureBytes(Uint32 format, int width, int height);
+
+        std::unordered_map<SDL_Texture*, Record> mRecords;
+        std::map<Uint32, size_t> mFormatBytes;
+
+        std::vector<std::function<void(size_t)> > mEvictionCallbacks;
+
+        // Set while callbacks run so textures they create do not evict again
+        bool mEvicting;
+
+        size_t mBytes;
+        size_t mPeakBytes;
+        size_t mBudget;
+
+        unsigned long mEvictionRounds;
+        unsigned long mOverBudget;
+};
+
+class LStatsPublisher
+{
+    public:
+        // Initialize
+        LStatsPublisher();
+
+        // Deallocate
+        ~LStatsPublisher();
+
+        // Creates the POSIX shared memory page of this process, Linux only
+        bool open();
+
+        // Copies stats into the page under its seqlock, never blocks
+        void publish(const LFrameStats& stats);
+
+        // Unmaps and unlinks the page
+        void free();
+
+    private:
+        LStatsPage* mPage;
+        std::string mName;
+};
+
+class LPerfOverlay
+{
+    public:
+        // Initialize hidden with an empty graph
+        LPerfOverlay();
+
+        // Shows or hides the overlay
+        void toggle();
+        bool isVisible();
+
+        // Adds a frame time to the rolling graph, recorded while hidden too
+        void record(double frameMs);
+
+        // Draws the graph and numbers in the top right corner
+        void render(const LFrameStats& stats);
+
+    private:
+        // Frame times, the oldest one at mNext
+        float mFrameTimes[OVERLAY_HISTORY];
+        int mNext;
+
+        bool mVisible;
+
+        // What the previous render cost
+        double mRenderMs;
+
+        // Graph bars by color, kept between frames so drawing does not allocate
+        std::vector<SDL_FRect> mFastBars;
+        std::vector<SDL_FRect> mSlowBars;
 };
 
 bool init();
@@ -71,18 +444,31 @@ SDL_Renderer* gRenderer = NULL;
 
 TTF_Font* gFont = NULL;
 
-LTexture gTextTexture;
+LTextureRegistry gTextureRegistry;
+
+LStatsPublisher gStatsPublisher;
+
+LPerfOverlay gPerfOverlay;
+
+// Render calls made this frame, copies, clears and primitives alike
+Uint32 gDrawCalls = 0;
+
+LTextCache gTextCache;
+
+LGlyphAtlas gGlyphAtlas;
 
 LTexture::LTexture()
 {
     mTexture = NULL;
     mWidth = 0;
     mHeight = 0;
+    mOwner = "texture";
 }
 
 void LTexture::free()
 {
     if (mTexture != NULL) {
+        gTextureRegistry.remove(mTexture);
         SDL_DestroyTexture(mTexture);
         mTexture = NULL;
         mWidth = 0;
@@ -97,6 +483,9 @@ LTexture::~LTexture()
 
 bool LTexture::loadFromFile(std::string path)
 {
+    // Get rid of preexisting texture
+    free();
+
     SDL_Texture* newTexture = NULL;
 
     SDL_Surface* loadedSurface = IMG_Load(path.c_str());
@@ -111,6 +500,8 @@ bool LTexture::loadFromFile(std::string path)
 
             mWidth = loadedSurface->w;
             mHeight = loadedSurface->h;
+
+            gTextureRegistry.add(newTexture, mOwner, path);
         }
 
         SDL_FreeSurface(loadedSurface);
@@ -120,12 +511,16 @@ bool LTexture::loadFromFile(std::string path)
     return mTexture != NULL;
 }
 
-bool LTexture::loadFromRenderedText(std::string textureText, SDL_Color textColor)
+bool LTexture::loadFromRenderedText(std::string textureText, SDL_Color textColor, TTF_Font* font)
 {
     free();
 
+    if (font == NULL) {
+        font = gFont;
+    }
+
     // Render text surface
-    SDL_Surface* textSurface = TTF_RenderText_Solid(gFont, textureText.c_str(), textColor);
+    SDL_Surface* textSurface = TTF_RenderText_Solid(font, textureText.c_str(), textColor);
     if (textSurface == NULL) {
         printf("Unable to render text surface! SDL_ttf Error: %s\n", TTF_GetError());
     } else {
@@ -136,6 +531,8 @@ bool LTexture::loadFromRenderedText(std::string textureText, SDL_Color textColor
         } else {
             mWidth = textSurface->w;
             mHeight = textSurface->h;
+
+            gTextureRegistry.add(mTexture, mOwner, "text \"" + textureText + "\"");
         }
 
         SDL_FreeSurface(textSurface);
@@ -144,6 +541,11 @@ bool LTexture::loadFromRenderedText(std::string textureText, SDL_Color textColor
     return mTexture != NULL;
 }
 
+void LTexture::setOwner(std::string owner)
+{
+    mOwner = owner;
+}
+
 void LTexture::setColor(Uint8 red, Uint8 green, Uint8 blue)
 {
     SDL_SetTextureColorMod(mTexture, red, green, blue);
@@ -169,6 +571,7 @@ void LTexture::render(int x, int y, SDL_Rect* clip, double angle, SDL_Point* cen
     }
 
     SDL_RenderCopy(gRenderer, mTexture, clip, &renderQuad);
+    ++gDrawCalls;
 }
 
 int LTexture::getWidth()
@@ -181,6 +584,779 @@ int LTexture::getHeight()
     return mHeight;
 }
 
+bool LTextCache::Key::operator==(const Key& other) const
+{
+    return font == other.font && size == other.size && style == other.style && color == other.color && textHash == other.textHash && text == other.text;
+}
+
+size_t LTextCache::KeyHash::operator()(const Key& key) const
+{
+    size_t hash = key.textHash;
+    hash ^= std::hash<void*>()(key.font) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<Uint32>()(key.color) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= (size_t)(key.size * 31 + key.style) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+LTextCache::LTextCache(size_t budget)
+{
+    mBudget = budget;
+    mBytes = 0;
+    mHits = 0;
+    mMisses = 0;
+    mEvictions = 0;
+}
+
+std::shared_ptr<LTexture> LTextCache::get(TTF_Font* font, int size, std::string text, SDL_Color color)
+{
+    Key key;
+    key.font = font;
+    key.size = size;
+    key.style = TTF_GetFontStyle(font);
+    key.color = (color.r << 24) | (color.g << 16) | (color.b << 8) | color.a;
+    key.textHash = std::hash<std::string>()(text);
+    key.text = text;
+
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash>::iterator found = mLookup.find(key);
+    if (found != mLookup.end()) {
+        // Move to the front of the LRU list
+        mEntries.splice(mEntries.begin(), mEntries, found->second);
+        ++mHits;
+        return found->second->texture;
+    }
+
+    ++mMisses;
+
+    std::shared_ptr<LTexture> texture = std::make_shared<LTexture>();
+    texture->setOwner("text cache");
+    if (!texture->loadFromRenderedText(text, color, font)) {
+        return texture;
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.texture = texture;
+    entry.bytes = (size_t)texture->getWidth() * texture->getHeight() * 4;
+
+    mEntries.push_front(entry);
+    mLookup[key] = mEntries.begin();
+    mBytes += entry.bytes;
+
+    trim();
+
+    return texture;
+}
+
+void LTextCache::prewarm(TTF_Font* font, int size, const std::vector<std::string>& strings, SDL_Color color)
+{
+    unsigned long hits = mHits;
+    unsigned long misses = mMisses;
+
+    for (size_t i = 0; i < strings.size(); ++i) {
+        get(font, size, strings[i], color);
+    }
+
+    // Warming is not a real lookup
+    mHits = hits;
+    mMisses = misses;
+}
+
+void LTextCache::trim()
+{
+    // Never evict the entry just added
+    while (mBytes > mBudget && mEntries.size() > 1) {
+        evictLast();
+    }
+}
+
+void LTextCache::evict(size_t bytes)
+{
+    size_t target = bytes < mBytes ? mBytes - bytes : 0;
+    while (mBytes > target && !mEntries.empty()) {
+        evictLast();
+    }
+}
+
+void LTextCache::evictLast()
+{
+    Entry& last = mEntries.back();
+    mBytes -= last.bytes;
+    mLookup.erase(last.key);
+    mEntries.pop_back();
+    ++mEvictions;
+}
+
+void LTextCache::clear()
+{
+    mEntries.clear();
+    mLookup.clear();
+    mBytes = 0;
+}
+
+void LTextCache::printStats()
+{
+    unsigned long lookups = mHits + mMisses;
+    double hitRate = lookups > 0 ? 100.0 * mHits / lookups : 0.0;
+
+    printf("Text cache: %lu lookups, %.1f%% hits, %lu evictions, %zu entries, %zu of %zu bytes\n",
+        lookups, hitRate, mEvictions, mEntries.size(), mBytes, mBudget);
+}
+
+LGlyphAtlas::LGlyphAtlas()
+{
+    mFontData = NULL;
+    mFontDataSize = 0;
+    mPenX = 0;
+    mPenY = 0;
+    mShelfHeight = 0;
+}
+
+LGlyphAtlas::~LGlyphAtlas()
+{
+    free();
+}
+
+void LGlyphAtlas::free()
+{
+    for (size_t i = 0; i < mPageSurfaces.size(); ++i) {
+        SDL_FreeSurface(mPageSurfaces[i]);
+    }
+    mPageSurfaces.clear();
+
+    for (size_t i = 0; i < mPages.size(); ++i) {
+        gTextureRegistry.remove(mPages[i]);
+        SDL_DestroyTexture(mPages[i]);
+    }
+    mPages.clear();
+
+    mGlyphs.clear();
+    mLineHeights.clear();
+    mPenX = 0;
+    mPenY = 0;
+    mShelfHeight = 0;
+
+    SDL_free(mFontData);
+    mFontData = NULL;
+    mFontDataSize = 0;
+}
+
+bool LGlyphAtlas::loadFont(std::string path)
+{
+    SDL_free(mFontData);
+
+    mFontData = SDL_LoadFile(path.c_str(), &mFontDataSize);
+    if (mFontData == NULL) {
+        printf("Unable to read font %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+        return false;
+    }
+
+    return true;
+}
+
+void LGlyphAtlas::rasterize(std::vector<RasterJob>* jobs, std::atomic<size_t>* next)
+{
+    // One font per size for this worker
+    std::unordered_map<int, TTF_Font*> fonts;
+    SDL_Color white = {0xFF, 0xFF, 0xFF, 0xFF};
+
+    for (size_t i = (*next)++; i < jobs->size(); i = (*next)++) {
+        RasterJob& job = (*jobs)[i];
+
+        TTF_Font*& font = fonts[job.size];
+        if (font == NULL) {
+            std::lock_guard<std::mutex> lock(mFontMutex);
+            font = TTF_OpenFontRW(SDL_RWFromConstMem(mFontData, (int)mFontDataSize), 1, job.size);
+            if (font == NULL) {
+                printf("Unable to open font at %dpt! SDL_ttf Error: %s\n", job.size, TTF_GetError());
+                continue;
+            }
+        }
+
+        job.lineSkip = TTF_FontLineSkip(font);
+        job.surfaces.assign(job.last - job.first + 1, NULL);
+        job.advances.assign(job.last - job.first + 1, 0);
+
+        for (Uint32 codepoint = job.first; codepoint <= job.last; ++codepoint) {
+            if (!TTF_GlyphIsProvided32(font, codepoint)) {
+                continue;
+            }
+
+            int minx, maxx, miny, maxy;
+            TTF_GlyphMetrics32(font, codepoint, &minx, &maxx, &miny, &maxy, &job.advances[codepoint - job.first]);
+            job.surfaces[codepoint - job.first] = TTF_RenderGlyph32_Blended(font, codepoint, white);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mFontMutex);
+    std::unordered_map<int, TTF_Font*>::iterator it;
+    for (it = fonts.begin(); it != fonts.end(); ++it) {
+        TTF_CloseFont(it->second);
+    }
+}
+
+bool LGlyphAtlas::pack(RasterJob& job)
+{
+    if (job.lineSkip > 0) {
+        mLineHeights[job.size] = job.lineSkip;
+    }
+
+    for (size_t i = 0; i < job.surfaces.size(); ++i) {
+        SDL_Surface* glyphSurface = job.surfaces[i];
+        if (glyphSurface == NULL) {
+            continue;
+        }
+
+        // Next shelf, then next page when this one is full
+        if (mPenX + glyphSurface->w > GLYPH_PAGE_SIZE) {
+            mPenX = 0;
+            mPenY += mShelfHeight;
+            mShelfHeight = 0;
+        }
+        if (mPageSurfaces.empty() || mPenY + glyphSurface->h > GLYPH_PAGE_SIZE) {
+            SDL_Surface* page = SDL_CreateRGBSurfaceWithFormat(0, GLYPH_PAGE_SIZE, GLYPH_PAGE_SIZE, 32, SDL_PIXELFORMAT_ARGB8888);
+            if (page == NULL) {
+                printf("Unable to create glyph page! SDL Error: %s\n", SDL_GetError());
+                return false;
+            }
+
+            mPageSurfaces.push_back(page);
+            mPenX = 0;
+            mPenY = 0;
+            mShelfHeight = 0;
+        }
+
+        LGlyph glyph;
+        glyph.page = (int)(mPages.size() + mPageSurfaces.size() - 1);
+        glyph.clip.x = mPenX;
+        glyph.clip.y = mPenY;
+        glyph.clip.w = glyphSurface->w;
+        glyph.clip.h = glyphSurface->h;
+        glyph.advance = job.advances[i];
+
+        // Copy coverage as is instead of blending onto the empty page
+        SDL_SetSurfaceBlendMode(glyphSurface, SDL_BLENDMODE_NONE);
+        SDL_BlitSurface(glyphSurface, NULL, mPageSurfaces.back(), &glyph.clip);
+
+        mGlyphs[((Uint64)job.size << 32) | (job.first + i)] = glyph;
+
+        mPenX += glyphSurface->w;
+        mShelfHeight = SDL_max(mShelfHeight, glyphSurface->h);
+    }
+
+    return true;
+}
+
+bool LGlyphAtlas::upload()
+{
+    bool success = true;
+
+    for (size_t i = 0; i < mPageSurfaces.size(); ++i) {
+        SDL_Texture* page = SDL_CreateTextureFromSurface(gRenderer, mPageSurfaces[i]);
+        if (page == NULL) {
+            printf("Unable to create glyph page texture! SDL Error: %s\n", SDL_GetError());
+            success = false;
+        } else {
+            SDL_SetTextureBlendMode(page, SDL_BLENDMODE_BLEND);
+            gTextureRegistry.add(page, "glyph atlas", "page " + std::to_string(mPages.size()));
+        }
+
+        mPages.push_back(page);
+        SDL_FreeSurface(mPageSurfaces[i]);
+    }
+
+    // Pages already uploaded are never packed into again
+    mPageSurfaces.clear();
+    mPenX = 0;
+    mPenY = 0;
+    mShelfHeight = 0;
+
+    return success;
+}
+
+bool LGlyphAtlas::warm(const std::vector<int>& sizes, const std::vector<GlyphRange>& ranges, int threadCount)
+{
+    if (mFontData == NULL) {
+        printf("No font loaded into glyph atlas!\n");
+        return false;
+    }
+
+    std::vector<RasterJob> jobs;
+    for (size_t s = 0; s < sizes.size(); ++s) {
+        for (size_t r = 0; r < ranges.size(); ++r) {
+            for (Uint32 first = ranges[r].first; first <= ranges[r].last; first += GLYPH_JOB_SIZE) {
+                RasterJob job;
+                job.size = sizes[s];
+                job.first = first;
+                job.last = SDL_min(ranges[r].last, first + GLYPH_JOB_SIZE - 1);
+                job.lineSkip = 0;
+                jobs.push_back(job);
+            }
+        }
+    }
+
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    // Workers rasterize, the calling thread joins in as the last one
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threadCount; ++i) {
+        workers.push_back(std::thread(&LGlyphAtlas::rasterize, this, &jobs, &next));
+    }
+    rasterize(&jobs, &next);
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+
+    Uint64 rasterized = SDL_GetPerformanceCounter();
+
+    // Pack in job order so the layout does not depend on thread timing
+    bool success = true;
+    int glyphCount = 0;
+    int missingCount = 0;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        for (size_t g = 0; g < jobs[i].surfaces.size(); ++g) {
+            if (jobs[i].surfaces[g] != NULL) {
+                ++glyphCount;
+            } else {
+                ++missingCount;
+            }
+        }
+
+        if (success && !pack(jobs[i])) {
+            success = false;
+        }
+
+        for (size_t g = 0; g < jobs[i].surfaces.size(); ++g) {
+            SDL_FreeSurface(jobs[i].surfaces[g]);
+        }
+    }
+
+    if (!upload()) {
+        success = false;
+    }
+
+    Uint64 packed = SDL_GetPerformanceCounter();
+
+    printf("Warmed %d glyphs (%d not in font) at %d sizes: rasterized in %.1f ms on %d threads, packed in %.1f ms\n",
+        glyphCount, missingCount, (int)sizes.size(), (rasterized - start) * 1000.0 / frequency, threadCount, (packed - rasterized) * 1000.0 / frequency);
+
+    return success;
+}
+
+Uint32 LGlyphAtlas::decodeUTF8(const std::string& text, size_t* index)
+{
+    Uint8 lead = (Uint8)text[(*index)++];
+    int continuation = 0;
+    Uint32 codepoint = lead;
+
+    if (lead >= 0xF0) {
+        codepoint = lead & 0x07;
+        continuation = 3;
+    } else if (lead >= 0xE0) {
+        codepoint = lead & 0x0F;
+        continuation = 2;
+    } else if (lead >= 0xC0) {
+        codepoint = lead & 0x1F;
+        continuation = 1;
+    }
+
+    while (continuation-- > 0 && *index < text.size()) {
+        codepoint = (codepoint << 6) | ((Uint8)text[(*index)++] & 0x3F);
+    }
+
+    return codepoint;
+}
+
+const LGlyph* LGlyphAtlas::getGlyph(int size, Uint32 codepoint)
+{
+    std::unordered_map<Uint64, LGlyph>::iterator found = mGlyphs.find(((Uint64)size << 32) | codepoint);
+    return found != mGlyphs.end() ? &found->second : NULL;
+}
+
+int LGlyphAtlas::getLineHeight(int size)
+{
+    std::unordered_map<int, int>::iterator found = mLineHeights.find(size);
+    return found != mLineHeights.end() ? found->second : 0;
+}
+
+void LGlyphAtlas::render(int x, int y, std::string text, int size, SDL_Color color)
+{
+    for (size_t i = 0; i < mPages.size(); ++i) {
+        SDL_SetTextureColorMod(mPages[i], color.r, color.g, color.b);
+    }
+
+    size_t index = 0;
+    while (index < text.size()) {
+        const LGlyph* glyph = getGlyph(size, decodeUTF8(text, &index));
+        if (glyph == NULL) {
+            continue;
+        }
+
+        SDL_Rect renderQuad = {x, y, glyph->clip.w, glyph->clip.h};
+        SDL_RenderCopy(gRenderer, mPages[glyph->page], &glyph->clip, &renderQuad);
+        ++gDrawCalls;
+        x += glyph->advance;
+    }
+}
+
+int LGlyphAtlas::measure(std::string text, int size)
+{
+    int width = 0;
+
+    size_t index = 0;
+    while (index < text.size()) {
+        const LGlyph* glyph = getGlyph(size, decodeUTF8(text, &index));
+        if (glyph != NULL) {
+            width += glyph->advance;
+        }
+    }
+
+    return width;
+}
+
+size_t LGlyphAtlas::getBytes()
+{
+    return mPages.size() * GLYPH_PAGE_SIZE * GLYPH_PAGE_SIZE * 4;
+}
+
+LTextureRegistry::LTextureRegistry()
+{
+    mEvicting = false;
+    mBytes = 0;
+    mPeakBytes = 0;
+    mBudget = 0;
+    mEvictionRounds = 0;
+    mOverBudget = 0;
+}
+
+size_t LTextureRegistry::getTextureBytes(Uint32 format, int width, int height)
+{
+    // Planar YUV keeps quarter size chroma planes, everything else is packed
+    if (format == SDL_PIXELFORMAT_YV12 || format == SDL_PIXELFORMAT_IYUV || format == SDL_PIXELFORMAT_NV12 || format == SDL_PIXELFORMAT_NV21) {
+        return (size_t)width * height + 2 * (size_t)((width + 1) / 2) * ((height + 1) / 2);
+    }
+
+    return (size_t)width * height * SDL_BYTESPERPIXEL(format);
+}
+
+void LTextureRegistry::add(SDL_Texture* texture, std::string owner, std::string site)
+{
+    Record record;
+    if (texture == NULL || SDL_QueryTexture(texture, &record.format, NULL, &record.width, &record.height) != 0) {
+        return;
+    }
+
+    // A texture registered twice replaces its old record
+    remove(texture);
+
+    record.bytes = getTextureBytes(record.format, record.width, record.height);
+    record.owner = owner;
+    record.site = site;
+
+    mRecords[texture] = record;
+    mFormatBytes[record.format] += record.bytes;
+    mBytes += record.bytes;
+    mPeakBytes = SDL_max(mPeakBytes, mBytes);
+
+    if (mBudget == 0 || mBytes <= mBudget || mEvicting) {
+        return;
+    }
+
+    // Owners release what they can, the texture just added stays either way
+    mEvicting = true;
+    ++mEvictionRounds;
+    for (size_t i = 0; i < mEvictionCallbacks.size() && mBytes > mBudget; ++i) {
+        mEvictionCallbacks[i](mBytes - mBudget);
+    }
+    mEvicting = false;
+
+    if (mBytes > mBudget) {
+        ++mOverBudget;
+    }
+}
+
+void LTextureRegistry::remove(SDL_Texture* texture)
+{
+    std::unordered_map<SDL_Texture*, Record>::iterator found = mRecords.find(texture);
+    if (found == mRecords.end()) {
+        return;
+    }
+
+    mFormatBytes[found->second.format] -= found->second.bytes;
+    mBytes -= found->second.bytes;
+    mRecords.erase(found);
+}
+
+void LTextureRegistry::setBudget(size_t budget)
+{
+    mBudget = budget;
+}
+
+void LTextureRegistry::addEvictionCallback(std::function<void(size_t)> callback)
+{
+    mEvictionCallbacks.push_back(callback);
+}
+
+size_t LTextureRegistry::getBytes()
+{
+    return mBytes;
+}
+
+size_t LTextureRegistry::getPeakBytes()
+{
+    return mPeakBytes;
+}
+
+size_t LTextureRegistry::getBudget()
+{
+    return mBudget;
+}
+
+int LTextureRegistry::getCount()
+{
+    return (int)mRecords.size();
+}
+
+void LTextureRegistry::dump()
+{
+    printf("Texture memory: %d textures, %zu bytes, peak %zu, budget %zu, %lu eviction rounds, %lu left over budget\n",
+        getCount(), mBytes, mPeakBytes, mBudget, mEvictionRounds, mOverBudget);
+
+    std::map<Uint32, size_t>::iterator format;
+    for (format = mFormatBytes.begin(); format != mFormatBytes.end(); ++format) {
+        if (format->second > 0) {
+            printf("  %-24s %10zu bytes\n", SDL_GetPixelFormatName(format->first), format->second);
+        }
+    }
+
+    std::map<std::string, size_t> ownerBytes;
+    std::unordered_map<SDL_Texture*, Record>::iterator record;
+    for (record = mRecords.begin(); record != mRecords.end(); ++record) {
+        ownerBytes[record->second.owner] += record->second.bytes;
+    }
+
+    std::map<std::string, size_t>::iterator owner;
+    for (owner = ownerBytes.begin(); owner != ownerBytes.end(); ++owner) {
+        printf("  %-24s %10zu bytes\n", owner->first.c_str(), owner->second);
+    }
+
+    for (record = mRecords.begin(); record != mRecords.end(); ++record) {
+        printf("    %4dx%-4d %-24s %10zu bytes  %s: %s\n", record->second.width, record->second.height, SDL_GetPixelFormatName(record->second.format),
+            record->second.bytes, record->second.owner.c_str(), record->second.site.c_str());
+    }
+}
+
+void LTextureRegistry::printJson(std::string label)
+{
+    printf("{\"label\": \"%s\", \"texture_count\": %d, \"texture_bytes\": %zu, \"texture_peak_bytes\": %zu, \"texture_budget_bytes\": %zu, \"eviction_rounds\": %lu, \"over_budget\": %lu, \"bytes_by_format\": {",
+        label.c_str(), getCount(), mBytes, mPeakBytes, mBudget, mEvictionRounds, mOverBudget);
+
+    const char* separator = "";
+    std::map<Uint32, size_t>::iterator format;
+    for (format = mFormatBytes.begin(); format != mFormatBytes.end(); ++format) {
+        if (format->second > 0) {
+            printf("%s\"%s\": %zu", separator, SDL_GetPixelFormatName(format->first), format->second);
+            separator = ", ";
+        }
+    }
+
+    printf("}}\n");
+}
+
+void LTextureRegistry::printLeaks()
+{
+    std::unordered_map<SDL_Texture*, Record>::iterator record;
+    for (record = mRecords.begin(); record != mRecords.end(); ++record) {
+        printf("Leaked texture: %dx%d, %zu bytes, %s: %s\n", record->second.width, record->second.height,
+            record->second.bytes, record->second.owner.c_str(), record->second.site.c_str());
+    }
+}
+
+LStatsPublisher::LStatsPublisher()
+{
+    mPage = NULL;
+}
+
+LStatsPublisher::~LStatsPublisher()
+{
+    free();
+}
+
+bool LStatsPublisher::open()
+{
+    free();
+
+#if defined(__linux__)
+    // One page per process so instances never publish over each other
+    std::string name = STATS_PAGE_PREFIX + std::to_string(getpid());
+
+    int file = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (file < 0) {
+        printf("Unable to open stats page %s! %s\n", name.c_str(), strerror(errno));
+        return false;
+    }
+
+    void* mapping = MAP_FAILED;
+    if (ftruncate(file, sizeof(LStatsPage)) == 0) {
+        mapping = mmap(NULL, sizeof(LStatsPage), PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    }
+    close(file);
+
+    if (mapping == MAP_FAILED) {
+        printf("Unable to map stats page %s! %s\n", name.c_str(), strerror(errno));
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    mPage = (LStatsPage*)mapping;
+    mName = name;
+
+    // A page left behind by an earlier run is reset, readers only trust it once the tag is back
+    mPage->magic = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    memset(&mPage->stats, 0, sizeof(mPage->stats));
+    mPage->sequence.store(0, std::memory_order_relaxed);
+    mPage->version = STATS_PAGE_VERSION;
+    mPage->pid = (Uint32)getpid();
+    std::atomic_thread_fence(std::memory_order_release);
+    mPage->magic = STATS_PAGE_MAGIC;
+
+    printf("Publishing stats to %s\n", name.c_str());
+    return true;
+#else
+    printf("Stats page is only supported on Linux!\n");
+    return false;
+#endif
+}
+
+void LStatsPublisher::publish(const LFrameStats& stats)
+{
+    if (mPage == NULL) {
+        return;
+    }
+
+    // Single writer, so the sequence only needs to be odd for the duration of the copy
+    Uint32 sequence = mPage->sequence.load(std::memory_order_relaxed);
+    mPage->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    mPage->stats = stats;
+
+    mPage->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void LStatsPublisher::free()
+{
+#if defined(__linux__)
+    if (mPage != NULL) {
+        munmap(mPage, sizeof(LStatsPage));
+        shm_unlink(mName.c_str());
+        mPage = NULL;
+    }
+#endif
+}
+
+LPerfOverlay::LPerfOverlay()
+{
+    for (int i = 0; i < OVERLAY_HISTORY; ++i) {
+        mFrameTimes[i] = 0;
+    }
+    mNext = 0;
+    mVisible = false;
+    mRenderMs = 0;
+
+    mFastBars.reserve(OVERLAY_HISTORY);
+    mSlowBars.reserve(OVERLAY_HISTORY);
+}
+
+void LPerfOverlay::toggle()
+{
+    mVisible = !mVisible;
+}
+
+bool LPerfOverlay::isVisible()
+{
+    return mVisible;
+}
+
+void LPerfOverlay::record(double frameMs)
+{
+    mFrameTimes[mNext] = (float)frameMs;
+    mNext = (mNext + 1) % OVERLAY_HISTORY;
+}
+
+void LPerfOverlay::render(const LFrameStats& stats)
+{
+    if (!mVisible) {
+        return;
+    }
+
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    int lineHeight = gGlyphAtlas.getLineHeight(OVERLAY_FONT_SIZE);
+    int width = OVERLAY_HISTORY * OVERLAY_BAR_WIDTH;
+    SDL_Rect panel = {SCREEN_WIDTH - width - 20, 10, width + 10, 4 * lineHeight + OVERLAY_GRAPH_HEIGHT + 15};
+    float graphX = (float)(panel.x + 5);
+    float graphBottom = (float)(panel.y + panel.h - 5);
+
+    // Translucent backing so the numbers stay readable over any content
+    SDL_SetRenderDrawBlendMode(gRenderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(gRenderer, 0, 0, 0, 0xC0);
+    SDL_RenderFillRect(gRenderer, &panel);
+    ++gDrawCalls;
+
+    // One bar per frame oldest first, a fill call per color
+    mFastBars.clear();
+    mSlowBars.clear();
+    for (int i = 0; i < OVERLAY_HISTORY; ++i) {
+        float frameMs = mFrameTimes[(mNext + i) % OVERLAY_HISTORY];
+        float height = (float)(SDL_min(frameMs, OVERLAY_GRAPH_MAX_MS) / OVERLAY_GRAPH_MAX_MS * OVERLAY_GRAPH_HEIGHT);
+        SDL_FRect bar = {graphX + i * OVERLAY_BAR_WIDTH, graphBottom - height, (float)OVERLAY_BAR_WIDTH, height};
+
+        if (frameMs > OVERLAY_TARGET_MS) {
+            mSlowBars.push_back(bar);
+        } else {
+            mFastBars.push_back(bar);
+        }
+    }
+
+    SDL_SetRenderDrawColor(gRenderer, 0x40, 0xE0, 0x40, 0xFF);
+    SDL_RenderFillRectsF(gRenderer, mFastBars.data(), (int)mFastBars.size());
+    ++gDrawCalls;
+    SDL_SetRenderDrawColor(gRenderer, 0xF0, 0x40, 0x40, 0xFF);
+    SDL_RenderFillRectsF(gRenderer, mSlowBars.data(), (int)mSlowBars.size());
+    ++gDrawCalls;
+
+    // Target frame time marker
+    float targetY = (float)(graphBottom - OVERLAY_TARGET_MS / OVERLAY_GRAPH_MAX_MS * OVERLAY_GRAPH_HEIGHT);
+    SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0x80);
+    SDL_RenderDrawLineF(gRenderer, graphX, targetY, graphX + width, targetY);
+    ++gDrawCalls;
+    SDL_SetRenderDrawBlendMode(gRenderer, SDL_BLENDMODE_NONE);
+
+    // Numbers from the warmed glyph atlas, nothing is rasterized here
+    char line[128];
+    SDL_Color textColor = {0xFF, 0xFF, 0xFF, 0xFF};
+    int x = panel.x + 5;
+    int y = panel.y + 5;
+
+    snprintf(line, sizeof(line), "%.1f FPS  %.2f ms  worst %.2f ms", stats.averageFrameMs > 0 ? 1000.0 / stats.averageFrameMs : 0.0, stats.averageFrameMs, stats.worstFrameMs);
+    gGlyphAtlas.render(x, y, line, OVERLAY_FONT_SIZE, textColor);
+
+    snprintf(line, sizeof(line), "%u draw calls  %.0f events/s", stats.drawCalls, stats.eventsPerSecond);
+    gGlyphAtlas.render(x, y + lineHeight, line, OVERLAY_FONT_SIZE, textColor);
+
+    snprintf(line, sizeof(line), "%u textures  %.1f / %.1f MiB", stats.textureCount, stats.textureBytes / 1048576.0, gTextureRegistry.getBudget() / 1048576.0);
+    gGlyphAtlas.render(x, y + 2 * lineHeight, line, OVERLAY_FONT_SIZE, textColor);
+
+    snprintf(line, sizeof(line), "overlay %.3f ms", mRenderMs);
+    gGlyphAtlas.render(x, y + 3 * lineHeight, line, OVERLAY_FONT_SIZE, textColor);
+
+    mRenderMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+}
+
 bool init()
 {
     bool success = true;
@@ -222,14 +1398,35 @@ bool loadMedia()
 {
     bool success = true;
 
-    gFont = TTF_OpenFont("lazy.ttf", 28);
+    // Cached text is the only texture memory that can be rebuilt on demand
+    gTextureRegistry.setBudget(TEXTURE_MEMORY_BUDGET);
+    gTextureRegistry.addEvictionCallback([](size_t bytes) { gTextCache.evict(bytes); });
+
+    gFont = TTF_OpenFont("lazy.ttf", FONT_SIZE);
     if (gFont == NULL) {
         printf("Failed to load lazy font! SDL_ttf Error: %s\n", TTF_GetError());
         success = false;
     } else {
-        SDL_Color textColor = {0, 0, 0};
-        if (!gTextTexture.loadFromRenderedText("The quick brown fox jumps over the lazy dog", textColor)) {
-            printf("Failed to render text texture!\n");
+        // Every label the program can show
+        std::vector<std::string> labels;
+        labels.push_back("The quick brown fox jumps over the lazy dog");
+        for (int score = 0; score < 10; ++score) {
+            labels.push_back("Score: " + std::to_string(score * 100));
+        }
+
+        SDL_Color textColor = {0, 0, 0, 0xFF};
+        gTextCache.prewarm(gFont, FONT_SIZE, labels, textColor);
+    }
+
+    // Glyphs for every size the program uses, rasterized on all cores
+    if (!gGlyphAtlas.loadFont("lazy.ttf")) {
+        printf("Failed to read lazy font!\n");
+        success = false;
+    } else {
+        std::vector<int> sizes(WARM_SIZES, WARM_SIZES + SDL_arraysize(WARM_SIZES));
+        std::vector<GlyphRange> ranges(WARM_RANGES, WARM_RANGES + SDL_arraysize(WARM_RANGES));
+        if (!gGlyphAtlas.warm(sizes, ranges, SDL_GetCPUCount())) {
+            printf("Failed to warm glyph atlas!\n");
             success = false;
         }
     }
@@ -239,7 +1436,14 @@ bool loadMedia()
 
 void close()
 {
-    gTextTexture.free();
+    gTextCache.printStats();
+    gTextCache.clear();
+
+    gGlyphAtlas.free();
+
+    gTextureRegistry.printLeaks();
+
+    gStatsPublisher.free();
 
     TTF_CloseFont(gFont);
     gFont = NULL;
@@ -261,24 +1465,121 @@ int main (int argc, char *argv[])
     } else {
         if (!loadMedia()) {
             printf("Failed to load media!\n");
+        } else if (argc > 1 && std::string(argv[1]) == "--warm-bench") {
+            // Same warm up again on a single thread for comparison
+            LGlyphAtlas serialAtlas;
+            std::vector<int> sizes(WARM_SIZES, WARM_SIZES + SDL_arraysize(WARM_SIZES));
+            std::vector<GlyphRange> ranges(WARM_RANGES, WARM_RANGES + SDL_arraysize(WARM_RANGES));
+            if (serialAtlas.loadFont("lazy.ttf")) {
+                serialAtlas.warm(sizes, ranges, 1);
+            }
+
+            // Only the textures the lesson itself keeps belong in the report
+            serialAtlas.free();
+            gTextureRegistry.printJson("warm-bench");
+        } else if (argc > 1 && std::string(argv[1]) == "--stats-bench") {
+            // What the render loop pays every frame to publish its stats
+            if (gStatsPublisher.open()) {
+                LFrameStats stats;
+                memset(&stats, 0, sizeof(stats));
+
+                double frequency = (double)SDL_GetPerformanceFrequency();
+                Uint64 start = SDL_GetPerformanceCounter();
+                for (int i = 0; i < STATS_BENCH_PUBLISHES; ++i) {
+                    stats.frame = i;
+                    stats.frameMs = i * 0.001;
+                    gStatsPublisher.publish(stats);
+                }
+                double milliseconds = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+
+                printf("Published stats %d times in %.1f ms, %.1f ns each\n", STATS_BENCH_PUBLISHES, milliseconds, milliseconds * 1000000.0 / STATS_BENCH_PUBLISHES);
+            }
         } else {
             bool quit = false;
 
             SDL_Event e;
 
+            SDL_Color textColor = {0, 0, 0, 0xFF};
+
+            int frame = 0;
+
+            // --publish-stats shares stats with stats_reader, the program runs without them if the page can not be created
+            if (argc > 1 && std::string(argv[1]) == "--publish-stats") {
+                gStatsPublisher.open();
+            }
+
+            LFrameStats stats;
+            memset(&stats, 0, sizeof(stats));
+
+            double frequency = (double)SDL_GetPerformanceFrequency();
+            Uint64 lastFrame = SDL_GetPerformanceCounter();
+
+            // Worst frame and event rate are taken over one second windows
+            Uint64 windowStart = lastFrame;
+            Uint64 windowEvents = 0;
+            double windowWorstMs = 0;
+
             while (!quit) {
+                gDrawCalls = 0;
+
                 while (SDL_PollEvent(&e)) {
+                    ++stats.events;
+                    ++windowEvents;
+
                     if (e.type == SDL_QUIT) {
                         quit = true;
+                    } else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_m) {
+                        // Dump texture memory on demand
+                        gTextureRegistry.dump();
+                    } else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F1 && e.key.repeat == 0) {
+                        gPerfOverlay.toggle();
                     }
                 }
 
                 SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
                 SDL_RenderClear(gRenderer);
+                ++gDrawCalls;
+
+                // Labels come from the cache instead of being rendered each frame
+                std::shared_ptr<LTexture> textTexture = gTextCache.get(gFont, FONT_SIZE, "The quick brown fox jumps over the lazy dog", textColor);
+                textTexture->render((SCREEN_WIDTH - textTexture->getWidth()) / 2, (SCREEN_HEIGHT - textTexture->getHeight()) / 2);
+
+                // Score cycles through a few values, each shown for half a second
+                std::shared_ptr<LTexture> scoreTexture = gTextCache.get(gFont, FONT_SIZE, "Score: " + std::to_string((frame / 30) % 10 * 100), textColor);
+                scoreTexture->render(10, 10);
 
-                gTextTexture.render((SCREEN_WIDTH - gTextTexture.getWidth()) / 2, (SCREEN_HEIGHT - gTextTexture.getHeight()) / 2);
+                // Footer drawn glyph by glyph from the warmed atlas
+                gGlyphAtlas.render(10, SCREEN_HEIGHT - gGlyphAtlas.getLineHeight(20) - 10, "Drawn from the glyph atlas", 20, textColor);
+
+                // Shows the stats of the previous frame, F1 toggles it
+                gPerfOverlay.render(stats);
 
                 SDL_RenderPresent(gRenderer);
+
+                Uint64 now = SDL_GetPerformanceCounter();
+                stats.frame = frame;
+                stats.frameMs = (now - lastFrame) * 1000.0 / frequency;
+                stats.averageFrameMs = frame == 0 ? stats.frameMs : stats.averageFrameMs * 0.95 + stats.frameMs * 0.05;
+                stats.drawCalls = gDrawCalls;
+                stats.textureCount = gTextureRegistry.getCount();
+                stats.textureBytes = gTextureRegistry.getBytes();
+                stats.texturePeakBytes = gTextureRegistry.getPeakBytes();
+                lastFrame = now;
+
+                gPerfOverlay.record(stats.frameMs);
+
+                windowWorstMs = SDL_max(windowWorstMs, stats.frameMs);
+                if (now - windowStart >= (Uint64)frequency) {
+                    stats.worstFrameMs = windowWorstMs;
+                    stats.eventsPerSecond = windowEvents * frequency / (now - windowStart);
+                    windowStart = now;
+                    windowEvents = 0;
+                    windowWorstMs = 0;
+                }
+
+                gStatsPublisher.publish(stats);
+
+                ++frame;
             }
         }
     }